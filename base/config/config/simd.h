@@ -0,0 +1,54 @@
+/*
+	simd.h
+	------
+*/
+
+#ifndef CONFIG_SIMD_H
+#define CONFIG_SIMD_H
+
+
+/*
+	CONFIG_SSE2 and CONFIG_NEON are set if the instruction set is available
+	at compile time (and therefore on every processor we'll run on).
+	
+	CONFIG_AVX2 is set if the compiler can generate AVX2 code for functions
+	marked with __attribute__((target("avx2"))), which may only be called
+	once a run-time check confirms the processor supports it.
+*/
+
+#ifndef CONFIG_SSE2
+	#if defined( __SSE2__ )  ||  defined( __x86_64__ )
+		#define CONFIG_SSE2  1
+	#else
+		#define CONFIG_SSE2  0
+	#endif
+#endif
+
+#ifndef CONFIG_AVX2
+	#if ! CONFIG_SSE2
+		#define CONFIG_AVX2  0
+	#elif defined( __clang__ )
+		#if __clang_major__ >= 4
+			#define CONFIG_AVX2  1
+		#endif
+	#elif defined( __GNUC__ )
+		#if __GNUC__ > 4  ||  __GNUC__ == 4  &&  __GNUC_MINOR__ >= 9
+			#define CONFIG_AVX2  1
+		#endif
+	#endif
+	
+	#ifndef CONFIG_AVX2
+		#define CONFIG_AVX2  0
+	#endif
+#endif
+
+#ifndef CONFIG_NEON
+	#if defined( __ARM_NEON )  ||  defined( __ARM_NEON__ )
+		#define CONFIG_NEON  1
+	#else
+		#define CONFIG_NEON  0
+	#endif
+#endif
+
+
+#endif
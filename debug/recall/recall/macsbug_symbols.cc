@@ -31,7 +31,9 @@ namespace recall
 		
 		while ( word < end )
 		{
-			const uint16_t op = *word;
+			const uint8_t* bytes = (const uint8_t*) word;
+			
+			const uint16_t op = bytes[ 0 ] << 8 | bytes[ 1 ];  // big-endian
 			
 			if ( (op & 0xfffe) == 0x4e74 )
 			{
@@ -61,6 +63,16 @@ namespace recall
 	}
 	
 	
+	unsigned get_symbol_length( const macsbug_symbol* symbol )
+	{
+		const unsigned char* p = symbol->bytes;
+		
+		const bool has_long_name = *p == 0x80;
+		
+		return has_long_name ? p[ 1 ] : *p & 0x1f;
+	}
+	
+	
 	const char* get_symbol_string( const macsbug_symbol* symbol )
 	{
 		const unsigned char* p = symbol->bytes;
@@ -17,6 +17,8 @@ namespace recall
 	
 	const macsbug_symbol* find_symbol_name( return_address_68k addr );
 	
+	unsigned get_symbol_length( const macsbug_symbol* symbol );
+	
 	const char* get_symbol_string( const macsbug_symbol* symbol );
 	
 }
@@ -0,0 +1,353 @@
+/*
+	damogran-bench.cc
+	-----------------
+*/
+
+// POSIX
+#include <time.h>
+
+// Standard C
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// damogran
+#include "damogran/pack.hh"
+#include "damogran/unpack.hh"
+
+
+#define PROGRAM  "damogran-bench"
+
+/*
+	Pack and unpack synthetic 512x342 screen images repeatedly for about a
+	quarter of a second each, at depths of 1, 4, and 8 bits, and report
+	the rate in megabytes (of unpacked data) per second.  The library's
+	output is checked against a scalar reference implementation's.
+	
+	A delta is mostly zero, with a line of text and a cursor changed and
+	a window dragged, as a screencast would see from frame to frame.  A
+	keyframe is a patterned desktop with a few windows on it.
+*/
+
+const int width  = 512;
+const int height = 342;
+
+const double min_seconds = 0.25;
+
+static const int weights[] = { 1, 4, 8 };
+
+static uint8_t image  [ width * height ];
+static uint8_t check  [ width * height ];
+static uint8_t packed [ width * height * 2 + 4 ];
+static uint8_t packed2[ width * height * 2 + 4 ];
+
+namespace reference
+{
+	
+	/*
+		The original scalar implementation, scanning two bytes at a time.
+	*/
+	
+	typedef unsigned char byte_t;
+	
+	static
+	const byte_t* find_next_aligned_pair( const byte_t* begin, const byte_t* end )
+	{
+		const byte_t* p = begin;
+		
+		do
+		{
+			byte_t c0 = *p++;
+			byte_t c1 = *p++;
+			
+			if ( c0 == c1 )
+			{
+				return p - 2;
+			}
+		}
+		while ( p < end );
+		
+		return NULL;
+	}
+	
+	static
+	const byte_t* find_next_aligned_2pair( const byte_t* begin, const byte_t* end )
+	{
+		while ( const byte_t* p = find_next_aligned_pair( begin, end ) )
+		{
+			const short* p2 = (const short*) p;
+			
+			short pair = *p2++;
+			
+			if ( (const byte_t*) p2 == end )
+			{
+				return NULL;
+			}
+			
+			if ( *p2 == pair )
+			{
+				return p;
+			}
+			
+			begin = (const byte_t*) p2;
+		}
+		
+		return NULL;
+	}
+	
+	static
+	const byte_t* advance_repeated_pairs( const byte_t* begin, const byte_t* end )
+	{
+		const short* p = (const short*) begin;
+		
+		short pair = *p++;
+		
+		while ( p < (const short*) end )
+		{
+			if ( *p++ != pair )
+			{
+				return (const byte_t*) --p;
+			}
+		}
+		
+		return (const byte_t*) p;
+	}
+	
+	static
+	uint8_t* pack( const uint8_t* src, const uint8_t* end, uint8_t* dst )
+	{
+		#define WRITE_1( c )       *dst++ = c
+		#define WRITE_N( src, n )  memcpy( dst, src, n ); dst += n
+		
+		#include "damogran/pack_body.hh"
+		
+		return dst;
+	}
+	
+	static
+	void unpack( const uint8_t* src, uint8_t* dst, uint8_t* end )
+	{
+		while ( dst < end )
+		{
+			const int8_t c0 = *src++;
+			const int8_t c1 = *src++;
+			
+			size_t n;
+			
+			if ( c0 > 0 )
+			{
+				n = 2 * (c0 + 1);
+				
+				memset( dst, c1, n );
+			}
+			else if ( c1 < 0 )
+			{
+				n = 2 * (uint8_t) -c1;
+				
+				memcpy( dst, src, n );
+				
+				src += n;
+			}
+			else if ( c1 > 0 )
+			{
+				n = 2 * (c1 * 256 + *src++ + 1);
+				
+				memset( dst, *src++, n );
+			}
+			else
+			{
+				n = 0;
+			}
+			
+			dst += n;
+		}
+	}
+	
+}
+
+static
+double now()
+{
+	timespec ts;
+	
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static
+void fill_rect( int stride, int top, int left, int bottom, int right, int density )
+{
+	for ( int y = top;  y < bottom;  ++y )
+	{
+		for ( int x = left;  x < right;  ++x )
+		{
+			if ( rand() % 100 < density )
+			{
+				image[ y * stride + x ] = rand();
+			}
+		}
+	}
+}
+
+static
+size_t make_delta( int weight )
+{
+	const int stride = width * weight / 8;
+	
+	memset( image, '\0', sizeof image );
+	
+	fill_rect( stride,  40, stride / 8,  52, stride * 7 / 8, 60 );  // text
+	fill_rect( stride, 200, stride / 2, 216, stride / 2 + 2 * weight, 50 );
+	fill_rect( stride, 100, stride / 4, 250, stride * 3 / 4, 15 );  // drag
+	
+	return stride * height;
+}
+
+static
+size_t make_keyframe( int weight )
+{
+	const int stride = width * weight / 8;
+	
+	for ( int y = 0;  y < height;  ++y )
+	{
+		memset( image + y * stride, y & 1 ? 0x55 : 0xAA, stride );
+	}
+	
+	for ( int w = 0;  w < 3;  ++w )
+	{
+		const int top  = 30 + 90 * w;
+		const int left = stride / 8 * (w + 1);
+		
+		for ( int y = top;  y < top + 120  &&  y < height;  ++y )
+		{
+			memset( image + y * stride + left, '\0', stride / 2 );
+		}
+		
+		fill_rect( stride, top + 20, left + 2, top + 100, left + stride / 2 - 2, 30 );
+	}
+	
+	return stride * height;
+}
+
+typedef uint8_t* (*pack_proc)( const uint8_t*, const uint8_t*, uint8_t* );
+
+static
+double pack_rate( pack_proc pack, size_t size )
+{
+	const double start = now();
+	
+	double elapsed;
+	
+	int n = 0;
+	
+	do
+	{
+		pack( image, image + size, packed );
+		
+		++n;
+	}
+	while ( (elapsed = now() - start) < min_seconds );
+	
+	return n * (size / 1e6) / elapsed;
+}
+
+static
+void library_unpack( const uint8_t* src, uint8_t* dst, uint8_t* end )
+{
+	damogran::unpack( src, dst, end );
+}
+
+typedef void (*unpack_proc)( const uint8_t*, uint8_t*, uint8_t* );
+
+static
+double unpack_rate( unpack_proc unpack, size_t size )
+{
+	const double start = now();
+	
+	double elapsed;
+	
+	int n = 0;
+	
+	do
+	{
+		unpack( packed, check, check + size );
+		
+		++n;
+	}
+	while ( (elapsed = now() - start) < min_seconds );
+	
+	return n * (size / 1e6) / elapsed;
+}
+
+int main( int argc, char** argv )
+{
+	srand( 1 );
+	
+	int mismatches = 0;
+	
+	printf( "%-14s%10s%10s%10s%10s%10s\n",
+	        "",
+	        "packed",
+	        "pack",
+	        "(ref)",
+	        "unpack",
+	        "(ref)" );
+	
+	for ( int scene = 0;  scene < 2;  ++scene )
+	{
+		for ( size_t i = 0;  i < sizeof weights / sizeof *weights;  ++i )
+		{
+			const int weight = weights[ i ];
+			
+			const size_t size = scene ? make_keyframe( weight )
+			                          : make_delta   ( weight );
+			
+			char label[ 16 ];
+			
+			sprintf( label, "%s %d-bit", scene ? "key" : "delta", weight );
+			
+			printf( "%-14s", label );
+			
+			const uint8_t* end  = reference::pack( image, image + size, packed2 );
+			const uint8_t* end2 = damogran::pack ( image, image + size, packed  );
+			
+			const size_t n = end - packed2;
+			
+			if ( end2 - packed != n                      ||
+			     memcmp( packed, packed2, n ) != 0       ||
+			     damogran::preflight( image, image + size ) != n )
+			{
+				++mismatches;
+				
+				printf( "%10s\n", "MISMATCH" );
+				continue;
+			}
+			
+			memset( check, '\0', size );
+			
+			damogran::unpack( packed, check, check + size );
+			
+			if ( memcmp( check, image, size ) != 0 )
+			{
+				++mismatches;
+				
+				printf( "%10s\n", "MISMATCH" );
+				continue;
+			}
+			
+			printf( "%10lu", (unsigned long) n );
+			
+			printf( "%10.0f", pack_rate( &damogran::pack,  size ) );
+			printf( "%10.0f", pack_rate( &reference::pack, size ) );
+			
+			printf( "%10.0f", unpack_rate( &library_unpack,     size ) );
+			printf( "%10.0f", unpack_rate( &reference::unpack, size ) );
+			
+			printf( "    (MB/s)\n" );
+		}
+	}
+	
+	return mismatches != 0;
+}
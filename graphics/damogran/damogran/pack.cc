@@ -8,6 +8,17 @@
 // Standard C
 #include <string.h>
 
+// config
+#include "config/simd.h"
+
+#if CONFIG_SSE2
+#include <emmintrin.h>
+#endif
+
+#if CONFIG_NEON
+#include <arm_neon.h>
+#endif
+
 
 namespace damogran
 {
@@ -35,7 +46,7 @@ const byte_t* find_next_aligned_pair( const byte_t* begin, const byte_t* end )
 }
 
 static
-const byte_t* find_next_aligned_2pair( const byte_t* begin, const byte_t* end )
+const byte_t* find_next_aligned_2pair_scalar( const byte_t* begin, const byte_t* end )
 {
 	while ( const byte_t* p = find_next_aligned_pair( begin, end ) )
 	{
@@ -59,6 +70,79 @@ const byte_t* find_next_aligned_2pair( const byte_t* begin, const byte_t* end )
 	return NULL;
 }
 
+/*
+	Find the first aligned pair that's repeated, i.e. the first even offset
+	from begin of four identical bytes, or NULL.  The vector loops examine
+	eight pairs at a time:  Each pair is compared to the next one, and its
+	bytes to each other.
+*/
+
+static
+const byte_t* find_next_aligned_2pair( const byte_t* begin, const byte_t* end )
+{
+	const byte_t* p = begin;
+	
+	/*
+		In a busy image, the next run often starts right away.  Check the
+		first pair before setting up the vectors, which would cost more.
+	*/
+	
+	if ( end - p >= 4  &&  p[ 0 ] == p[ 1 ]  &&
+	     *(const short*) p == *(const short*) (p + 2) )
+	{
+		return p;
+	}
+	
+#if CONFIG_SSE2
+	
+	while ( end - p >= 16 + 2 )
+	{
+		const __m128i a = _mm_loadu_si128( (const __m128i*) p );
+		const __m128i b = _mm_loadu_si128( (const __m128i*) (p + 2) );
+		
+		const __m128i pairs = _mm_cmpeq_epi16( a, b );
+		const __m128i bytes = _mm_cmpeq_epi8( a, _mm_slli_epi16( a, 8 ) );
+		
+		// Only the odd (high) bytes of `bytes` are meaningful.
+		
+		const int mask = _mm_movemask_epi8( _mm_and_si128( pairs, bytes ) ) & 0xAAAA;
+		
+		if ( mask )
+		{
+			return p + __builtin_ctz( mask ) - 1;
+		}
+		
+		p += 16;
+	}
+	
+#elif CONFIG_NEON
+	
+	while ( end - p >= 16 + 2 )
+	{
+		const uint8x16_t a = vld1q_u8( p );
+		const uint8x16_t b = vld1q_u8( p + 2 );
+		
+		const uint16x8_t pairs = vceqq_u16( vreinterpretq_u16_u8( a ),
+		                                    vreinterpretq_u16_u8( b ) );
+		
+		const uint8x16_t bytes = vceqq_u8( a, vrev16q_u8( a ) );
+		
+		const uint64x2_t both = vreinterpretq_u64_u16( vandq_u16( pairs,
+		                                               vreinterpretq_u16_u8( bytes ) ) );
+		
+		if ( vgetq_lane_u64( both, 0 ) | vgetq_lane_u64( both, 1 ) )
+		{
+			return find_next_aligned_2pair_scalar( p, p + 16 + 2 );
+		}
+		
+		p += 16;
+	}
+	
+#endif
+	
+	return p < end ? find_next_aligned_2pair_scalar( p, end ) : NULL;
+}
+
 static
 const short* advance_repeated_pairs( const short* begin, const short* end )
 {
@@ -77,10 +161,65 @@ const short* advance_repeated_pairs( const short* begin, const short* end )
 	return p;
 }
 
-static inline
+/*
+	Return the first even offset past begin whose pair differs from the one
+	at begin, or end.  The vector loops compare eight pairs at a time.
+*/
+
+static
 const byte_t* advance_repeated_pairs( const byte_t* begin, const byte_t* end )
 {
-	return (const byte_t*) advance_repeated_pairs( (const short*) begin,
+	const byte_t* p = begin + 2;
+	
+	/*
+		We know the run is at least two pairs long.  If it ends at the
+		third, return without setting up the vectors.
+	*/
+	
+	if ( end - p >= 4  &&  *(const short*) (p + 2) != *(const short*) begin )
+	{
+		return p + 2;
+	}
+	
+#if CONFIG_SSE2
+	
+	const __m128i pair = _mm_set1_epi16( *(const short*) begin );
+	
+	while ( end - p >= 16 )
+	{
+		const __m128i a = _mm_loadu_si128( (const __m128i*) p );
+		
+		const int mask = _mm_movemask_epi8( _mm_cmpeq_epi16( a, pair ) );
+		
+		if ( mask != 0xFFFF )
+		{
+			return p + __builtin_ctz( ~mask );
+		}
+		
+		p += 16;
+	}
+	
+#elif CONFIG_NEON
+	
+	const uint16x8_t pair = vdupq_n_u16( *(const uint16_t*) begin );
+	
+	while ( end - p >= 16 )
+	{
+		const uint16x8_t eq = vceqq_u16( vld1q_u16( (const uint16_t*) p ), pair );
+		
+		const uint64x2_t all = vreinterpretq_u64_u16( eq );
+		
+		if ( ~(vgetq_lane_u64( all, 0 ) & vgetq_lane_u64( all, 1 )) )
+		{
+			break;  // the scalar loop finds the mismatch
+		}
+		
+		p += 16;
+	}
+	
+#endif
+	
+	return (const byte_t*) advance_repeated_pairs( (const short*) p - 1,
 	                                               (const short*) end );
 }
 
@@ -8,12 +8,145 @@
 // Standard C
 #include <string.h>
 
+// config
+#include "config/simd.h"
+
+#if CONFIG_SSE2
+#include <emmintrin.h>
+#endif
+
+#if CONFIG_NEON
+#include <arm_neon.h>
+#endif
+
 
 namespace damogran
 {
 
 typedef signed char int8_t;
 
+#if CONFIG_SSE2  ||  CONFIG_NEON
+
+#if CONFIG_SSE2
+
+typedef __m128i vector_t;
+
+static inline
+vector_t splat( uint8_t c )
+{
+	return _mm_set1_epi8( c );
+}
+
+static inline
+vector_t load( const uint8_t* p )
+{
+	return _mm_loadu_si128( (const __m128i*) p );
+}
+
+static inline
+void store( uint8_t* p, vector_t v )
+{
+	_mm_storeu_si128( (__m128i*) p, v );
+}
+
+#else
+
+typedef uint8x16_t vector_t;
+
+static inline
+vector_t splat( uint8_t c )
+{
+	return vdupq_n_u8( c );
+}
+
+static inline
+vector_t load( const uint8_t* p )
+{
+	return vld1q_u8( p );
+}
+
+static inline
+void store( uint8_t* p, vector_t v )
+{
+	vst1q_u8( p, v );
+}
+
+#endif
+
+/*
+	Short runs (up to 256 bytes) are stored sixteen bytes at a time,
+	rounded up if there's room before the end of the output -- the bytes
+	past the run are overwritten by what follows it.  Long runs are left
+	to memset(), which already uses the widest stores available.
+*/
+
+static inline
+void fill( uint8_t* dst, uint8_t c, size_t n, const uint8_t* end )
+{
+	if ( n <= 256  &&  end - dst >= 256 )
+	{
+		const vector_t v = splat( c );
+		
+		uint8_t* stop = dst + n;
+		
+		do
+		{
+			store( dst, v );
+			
+			dst += 16;
+		}
+		while ( dst < stop );
+		
+		return;
+	}
+	
+	memset( dst, c, n );
+}
+
+/*
+	Literals can't over-read the packed data, so a literal of at least
+	sixteen bytes ends with a store that overlaps the previous one.
+*/
+
+static inline
+void copy( uint8_t* dst, const uint8_t* src, size_t n )
+{
+	if ( n >= 16 )
+	{
+		const uint8_t* last = src + n - 16;
+		
+		store( dst + n - 16, load( last ) );
+		
+		while ( src < last )
+		{
+			store( dst, load( src ) );
+			
+			src += 16;
+			dst += 16;
+		}
+		
+		return;
+	}
+	
+	memcpy( dst, src, n );
+}
+
+#else
+
+static inline
+void fill( uint8_t* dst, uint8_t c, size_t n, const uint8_t* end )
+{
+	memset( dst, c, n );
+}
+
+static inline
+void copy( uint8_t* dst, const uint8_t* src, size_t n )
+{
+	memcpy( dst, src, n );
+}
+
+#endif
+
 const uint8_t* validate( const uint8_t* src, const uint8_t* end, long size )
 {
 	bool unaligned = false;
@@ -106,7 +239,7 @@ const uint8_t* unpack( const uint8_t* src, uint8_t* dst, uint8_t* end )
 					unaligned = ! unaligned;
 				}
 				
-				memcpy( dst, src, n );
+				copy( dst, src, n );
 				
 				src += n;
 				dst += n;
@@ -131,7 +264,7 @@ const uint8_t* unpack( const uint8_t* src, uint8_t* dst, uint8_t* end )
 		{
 			const size_t n = 2 * (c0 + 1);
 			
-			memset( dst, c1, n );
+			fill( dst, c1, n, end );
 			
 			dst += n;
 		}
@@ -32,10 +32,14 @@
 #include "command/get_option.hh"
 
 // raster
+#include "raster/damage.hh"
+#include "raster/frames.hh"
 #include "raster/load.hh"
 #include "raster/relay.hh"
 #include "raster/relay_detail.hh"
+#include "raster/sequence.hh"
 #include "raster/sync.hh"
+#include "raster/transcode.hh"
 
 // display-linux
 #include "fb.hh"
@@ -98,8 +102,17 @@ static bool watching;
 
 static size_t reflection_height;
 
+static size_t src_weight;      // bits per source pixel
+static size_t dst_pixel_size;  // bytes per framebuffer pixel
+
 static raster::raster_load loaded_raster;
 
+static raster::transcoder the_transcoder;
+
+static const raster::damage_list* raster_damage;
+
+static raster::frame_sequence* raster_sequence;
+
 
 static inline
 size_t min( size_t a, size_t b )
@@ -151,6 +164,20 @@ raster::sync_relay* open_raster( const char* path )
 			exit( 3 );
 		}
 		
+		raster_note* damage_note = find_note( *loaded_raster.meta, Note_damage );
+		
+		if ( is_valid_damage( damage_note ) )
+		{
+			raster_damage = (const damage_list*) data( damage_note );
+		}
+		
+		raster_note* sequence_note = find_note( *loaded_raster.meta, Note_sequence );
+		
+		if ( is_valid_sequence( sequence_note ) )
+		{
+			raster_sequence = (frame_sequence*) data( sequence_note );
+		}
+		
 		return (sync_relay*) data( sync_note );
 	}
 	
@@ -159,31 +186,10 @@ raster::sync_relay* open_raster( const char* path )
 
 typedef void (*draw_proc)( const uint8_t* src, uint8_t* dst, int width );
 
-template < class UInt >
-static
-void transcode_1_to_direct( const uint8_t* src, uint8_t* dst, int width )
-{
-	UInt* p = (UInt*) dst;
-	
-	while ( width > 0 )
-	{
-		uint8_t byte = *src++;
-		
-		for ( int mask = 1 << 7;  mask != 0;  mask >>= 1 )
-		{
-			const UInt pixel = byte & mask ? 0x00000000 : 0xFFFFFFFF;
-			
-			*p++ = pixel;
-		}
-		
-		width -= 8;
-	}
-}
-
 static
-void copy_8( const uint8_t* src, uint8_t* dst, int width )
+void transcode_to_direct( const uint8_t* src, uint8_t* dst, int width )
 {
-	memcpy( dst, src, width );
+	transcode( the_transcoder, src, dst, width );
 }
 
 static
@@ -225,7 +231,24 @@ draw_proc select_draw_proc( const raster_desc& desc, bool swap_bytes )
 	switch ( desc.weight )
 	{
 		case 1:
-			return &transcode_1_to_direct< bilevel_pixel_t >;
+		case 2:
+		case 4:
+		case 8:
+			uint32_t clut[ 256 ];
+			
+			if ( ! make_gray_clut( clut, desc.weight, raster_model( desc.model ) ) )
+			{
+				// Not grayscale (e.g. a palette), so draw it as paint anyway.
+				
+				make_gray_clut( clut, desc.weight, Model_grayscale_paint );
+			}
+			
+			set_up_transcoder( the_transcoder,
+			                   desc.weight,
+			                   sizeof (bilevel_pixel_t) * 8,
+			                   clut );
+			
+			return &transcode_to_direct;
 		
 		case 16:
 			return &copy_16;
@@ -257,16 +280,30 @@ void memcpy_fixmul( uint8_t* p, const uint8_t* q, size_t n, int fraction )
 	}
 }
 
+/*
+	Draw rows [top, bottom) of the image in full.  Rows in the reflected
+	area also draw their (faded) reflection.
+*/
+
 static
-void blit( const uint8_t*  src,
-           size_t          src_stride,
-           uint8_t*        dst,
-           size_t          dst_stride,
-           size_t          width,
-           size_t          height,
-           draw_proc       draw )
+void blit_rows( const uint8_t*  src,
+                size_t          src_stride,
+                uint8_t*        dst,
+                size_t          dst_stride,
+                size_t          width,
+                size_t          height,
+                size_t          top,
+                size_t          bottom,
+                draw_proc       draw )
 {
-	while ( height-- > reflection_height )
+	const size_t reflected = height - reflection_height;  // first such row
+	
+	src += top * src_stride;
+	dst += top * dst_stride;
+	
+	size_t row = top;
+	
+	for ( ;  row < bottom  &&  row < reflected;  ++row )
 	{
 		draw( src, dst, width );
 		
@@ -274,35 +311,97 @@ void blit( const uint8_t*  src,
 		dst += dst_stride;
 	}
 	
-	if ( reflection_height == 0 )
+	if ( row >= bottom )
 	{
 		return;
 	}
 	
 	const int denom = reflection_height * 4;
 	
-	size_t n = 0;
-	
 	uint8_t* tmp = (uint8_t*) alloca( dst_stride );
 	
 	memset( tmp, '\0', dst_stride );
 	
-	uint8_t* fxp = dst + 2 * reflection_height * dst_stride;
-	
-	while ( height-- > 0 )
+	for ( ;  row < bottom;  ++row )
 	{
 		draw( src, tmp, width );
 		
 		memcpy( dst, tmp, dst_stride );
 		
-		const int fraction = ++n * 256 / denom;
+		const int n = row - reflected + 1;
 		
-		src += src_stride;
-		dst += dst_stride;
+		const int fraction = n * 256 / denom;
+		
+		// The reflection of row r is row 2 * height - 1 - r.
 		
-		fxp -= dst_stride;
+		uint8_t* fxp = dst + (2 * (height - row) - 1) * dst_stride;
 		
 		memcpy_fixmul( fxp, tmp, dst_stride, fraction );
+		
+		src += src_stride;
+		dst += dst_stride;
+	}
+}
+
+static inline
+void blit( const uint8_t*  src,
+           size_t          src_stride,
+           uint8_t*        dst,
+           size_t          dst_stride,
+           size_t          width,
+           size_t          height,
+           draw_proc       draw )
+{
+	blit_rows( src, src_stride, dst, dst_stride, width, height, 0, height, draw );
+}
+
+/*
+	Draw only the part of the image within a damage rect.  Its columns are
+	in source bytes, so convert them to whole pixels.  The reflected area
+	is drawn a full row at a time.
+*/
+
+static
+void blit_rect( const uint8_t*       src,
+                size_t               src_stride,
+                uint8_t*             dst,
+                size_t               dst_stride,
+                size_t               width,
+                size_t               height,
+                const damage_rect&   rect,
+                draw_proc            draw )
+{
+	const size_t reflected = height - reflection_height;
+	
+	const size_t top    = min( rect.top,    height );
+	const size_t bottom = min( rect.bottom, height );
+	
+	const size_t left  =  rect.left  * 8                   / src_weight;
+	const size_t right = (rect.right * 8 + src_weight - 1) / src_weight;
+	
+	if ( top >= bottom  ||  left >= min( right, width ) )
+	{
+		return;
+	}
+	
+	const size_t n_pixels = min( right, width ) - left;
+	
+	const uint8_t* p = src + top * src_stride + left * src_weight / 8;
+	uint8_t*       q = dst + top * dst_stride + left * dst_pixel_size;
+	
+	size_t row = top;
+	
+	for ( ;  row < bottom  &&  row < reflected;  ++row )
+	{
+		draw( p, q, n_pixels );
+		
+		p += src_stride;
+		q += dst_stride;
+	}
+	
+	if ( row < bottom )
+	{
+		blit_rows( src, src_stride, dst, dst_stride, width, height, row, bottom, draw );
 	}
 }
 
@@ -310,7 +409,6 @@ static volatile sig_atomic_t signalled;
 
 static
 void update_loop( raster::sync_relay*  sync,
-                  const uint8_t*       src,
                   size_t               src_stride,
                   uint8_t*             dst,
                   size_t               dst_stride,
@@ -318,18 +416,66 @@ void update_loop( raster::sync_relay*  sync,
                   size_t               height,
                   draw_proc            draw )
 {
-	uint32_t seed = 0;
+	uint32_t seed  = 0;
+	uint32_t frame = 0;  // the full frame count, if there's a sequence
+	
+	bool drawn = false;  // whether the frame with `seed` has been drawn
+	
+	damage_rect rects[ max_damage_rects ];
 	
 	while ( sync->status == Sync_ready  &&  ! signalled )
 	{
-		while ( seed == sync->seed )
+		uint16_t next_seed;
+		
+		if ( raster_sequence )
+		{
+			// Skip to the latest frame; its low bits key the damage note.
+			
+			frame = wait_past( *raster_sequence, frame, signalled );
+			
+			if ( signalled )
+			{
+				break;
+			}
+			
+			next_seed = frame;
+		}
+		else
 		{
-			raster::wait( *sync );
+			while ( seed == sync->seed )
+			{
+				raster::wait( *sync );
+			}
+			
+			next_seed = sync->seed;
 		}
 		
-		seed = sync->seed;
+		int n = -1;
+		
+		if ( raster_damage  &&  drawn )
+		{
+			n = read_damage( *raster_damage, seed, next_seed, rects );
+		}
+		
+		seed  = next_seed;
+		drawn = true;
+		
+		// Draw from the front buffer in place (see raster.hh).
 		
-		blit( src, src_stride, dst, dst_stride, width, height, draw );
+		const uint8_t* src = (const uint8_t*) front_buffer( loaded_raster );
+		
+		if ( n < 0 )
+		{
+			blit( src, src_stride, dst, dst_stride, width, height, draw );
+			continue;
+		}
+		
+		for ( int i = 0;  i < n;  ++i )
+		{
+			const damage_rect& rect = rects[ i ];
+			
+			blit_rect( src, src_stride, dst, dst_stride, width, height, rect, draw );
+		}
 	}
 }
 
@@ -524,7 +670,9 @@ void signal_handler( int )
 {
 	signalled = true;
 	
-	if ( raster_sync )
+	// A sequence reader wakes itself (see wait_past()).
+	
+	if ( raster_sync  &&  ! raster_sequence )
 	{
 		raster::broadcast( *raster_sync );
 	}
@@ -629,6 +777,12 @@ int main( int argc, char** argv )
 	
 	draw_proc draw = select_draw_proc( desc, is_byte_swapped( loaded_raster ) );
 	
+	if ( draw == NULL )
+	{
+		WARN( "unsupported raster depth" );
+		return 3;
+	}
+	
 	fb::handle fbh( DEFAULT_FB_PATH );
 	
 	fb_var_screeninfo var_info = get_var_screeninfo( fbh );
@@ -653,11 +807,14 @@ int main( int argc, char** argv )
 	
 	uint8_t bpp = desc.weight;
 	
-	if ( desc.weight == 1 )
+	if ( desc.weight < 16 )
 	{
 		bpp = sizeof (bilevel_pixel_t) * 8;
 	}
 	
+	src_weight     = desc.weight;
+	dst_pixel_size = bpp / 8;
+	
 	const bool changing_depth = bpp != var_info.bits_per_pixel;
 	
 	if ( changing_depth )
@@ -691,7 +848,7 @@ int main( int argc, char** argv )
 	
 	fb_fix_screeninfo fix_info = get_fix_screeninfo( fbh );
 	
-	const uint8_t* src = (uint8_t*) loaded_raster.addr /*+ desc.image_offset*/;
+	const uint8_t* src = (uint8_t*) front_buffer( loaded_raster );
 	
 	fb::map map( fbh );
 	
@@ -732,7 +889,9 @@ int main( int argc, char** argv )
 	
 	if ( raster::sync_relay* sync = raster_sync )
 	{
-		update_loop( sync, src, stride, dst, dst_stride, width, height, draw );
+		update_loop( sync, stride, dst, dst_stride, width, height, draw );
+		
+		src = (uint8_t*) front_buffer( loaded_raster );
 	}
 	
 	blit( src, stride, dst, dst_stride, width, height, draw );
@@ -23,8 +23,11 @@
 #include "gear/parse_decimal.hh"
 
 // rasterlib
+#include "raster/damage.hh"
+#include "raster/frames.hh"
 #include "raster/load.hh"
 #include "raster/relay_detail.hh"
+#include "raster/sequence.hh"
 #include "raster/sync.hh"
 
 
@@ -37,7 +40,10 @@
 
 enum
 {
+	Opt_damage   = 'D',
+	Opt_frames   = 'F',
 	Opt_relay    = 'R',
+	Opt_sequence = 'S',
 	Opt_geometry = 'g',
 	Opt_model    = 'm',
 };
@@ -47,6 +53,9 @@ static command::option options[] =
 	{ "geometry", Opt_geometry, command::Param_required },
 	{ "model",    Opt_model,    command::Param_required },
 	{ "relay",    Opt_relay                             },
+	{ "damage",   Opt_damage                            },
+	{ "sequence", Opt_sequence                          },
+	{ "frames",   Opt_frames,   command::Param_required },
 	{ NULL }
 };
 
@@ -61,7 +70,11 @@ static geometry_spec the_geometry;
 
 static raster::raster_model the_model = raster::Model_none;
 
-static bool include_relay = false;
+static bool include_relay    = false;
+static bool include_damage   = false;
+static bool include_sequence = false;
+
+static uint32_t n_frames = 1;
 
 static const char* raster_models[] =
 {
@@ -179,6 +192,26 @@ char* const* get_options( char** argv )
 				include_relay = true;
 				break;
 			
+			case Opt_damage:
+				include_damage = true;
+				break;
+			
+			case Opt_sequence:
+				include_relay    = true;  // the sequence accompanies a relay
+				include_sequence = true;
+				break;
+			
+			case Opt_frames:
+				n_frames = parse_unsigned_decimal( global_result.param );
+				
+				if ( n_frames == 0 )
+				{
+					WARN( "frame count can't be zero" );
+					exit( 2 );
+				}
+				
+				break;
+			
 			default:
 				break;
 		}
@@ -219,6 +252,12 @@ uint32_t sizeof_raster( uint32_t image_size )
 	const uint32_t minimum_footer_size = sizeof (raster_metadata)
 	                                   + sizeof (raster_note) * include_relay
 	                                   + sizeof (sync_relay)  * include_relay
+	                                   + sizeof (raster_note) * include_damage
+	                                   + sizeof (damage_list) * include_damage
+	                                   + sizeof (raster_note)    * include_sequence
+	                                   + sizeof (frame_sequence) * include_sequence
+	                                   + sizeof (raster_note)    * (n_frames > 1)
+	                                   + sizeof (frame_buffers)  * (n_frames > 1)
 	                                   + sizeof (uint32_t);
 	
 	const uint32_t disk_block_size = 512;
@@ -263,7 +302,7 @@ int create_raster_file( const char* path, const geometry_spec& geometry )
 	const uint32_t weight = geometry.weight;
 	
 	const uint32_t stride     = make_stride( width, weight );
-	const uint32_t image_size = height * stride;
+	const uint32_t image_size = height * stride * n_frames;
 	
 	int nok = ftruncate( fd, sizeof_raster( image_size ) );
 	
@@ -314,6 +353,39 @@ int create_raster_file( const char* path, const geometry_spec& geometry )
 		next_note = next( next_note );
 	}
 	
+	if ( include_damage )
+	{
+		next_note->type = Note_damage;
+		next_note->size = sizeof (damage_list);
+		
+		damage_list& damage = data< damage_list >( *next_note );
+		
+		damage.count = damage_overflow;
+		
+		next_note = next( next_note );
+	}
+	
+	if ( n_frames > 1 )
+	{
+		next_note->type = Note_frames;
+		next_note->size = sizeof (frame_buffers);
+		
+		frame_buffers& frames = data< frame_buffers >( *next_note );
+		
+		frames.count = n_frames;
+		frames.front = 0;
+		
+		next_note = next( next_note );
+	}
+	
+	if ( include_sequence )
+	{
+		next_note->type = Note_sequence;
+		next_note->size = sizeof (frame_sequence);
+		
+		next_note = next( next_note );
+	}
+	
 	next_note->type = Note_end;
 	
 	return 0;
@@ -15,6 +15,7 @@
 #include "raster/raster.hh"
 #include "raster/relay.hh"
 #include "raster/relay_detail.hh"
+#include "raster/sequence.hh"
 #include "raster/sync.hh"
 
 
@@ -42,25 +43,55 @@ sync_relay& get_relay( const raster_load& loaded_raster )
 	return *(sync_relay*) data( sync );
 }
 
+static
+frame_sequence* find_sequence( const raster_load& loaded_raster )
+{
+	raster_note* note = find_note( *loaded_raster.meta, Note_sequence );
+	
+	return is_valid_sequence( note ) ? (frame_sequence*) data( note ) : NULL;
+}
+
 void init_relay( const raster_load& raster )
 {
 	publish( get_relay( raster ) );
+	
+	if ( frame_sequence* sequence = find_sequence( raster ) )
+	{
+		publish( *sequence );
+	}
 }
 
 void stop_relay( const raster_load& raster )
 {
 	terminate( get_relay( raster ) );
+	
+	if ( frame_sequence* sequence = find_sequence( raster ) )
+	{
+		terminate( *sequence );
+	}
 }
 
 void cast_relay( const raster_load& raster )
 {
 	broadcast( get_relay( raster ) );
+	
+	if ( frame_sequence* sequence = find_sequence( raster ) )
+	{
+		broadcast( *sequence );
+	}
 }
 
 bool wait_relay( const raster_load& raster )
 {
 	sync_relay& relay = get_relay( raster );
 	
+	if ( frame_sequence* sequence = find_sequence( raster ) )
+	{
+		wait_past( *sequence, sequence->frame );
+		
+		return sequence->status == Sync_ready;
+	}
+	
 	if ( relay.status == Sync_ready )
 	{
 		wait( relay );
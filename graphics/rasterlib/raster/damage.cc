@@ -0,0 +1,85 @@
+/*
+	damage.cc
+	---------
+*/
+
+#include "raster/damage.hh"
+
+// Standard C
+#include <string.h>
+
+
+#ifdef __GNUC__
+#define MEMORY_BARRIER()  __sync_synchronize()
+#else
+#define MEMORY_BARRIER()  /**/
+#endif
+
+
+namespace raster
+{
+	
+	bool is_valid_damage( const raster_note* note )
+	{
+		return note != NULL  &&  note->size == sizeof (damage_list);
+	}
+	
+	void publish_damage( damage_list&        list,
+	                     uint16_t            seed,
+	                     const damage_rect*  rects,
+	                     uint16_t            n )
+	{
+		volatile damage_list& v = list;
+		
+		v.count = damage_overflow;
+		
+		MEMORY_BARRIER();
+		
+		v.seed = seed;
+		
+		if ( n <= max_damage_rects )
+		{
+			memcpy( list.rects, rects, n * sizeof (damage_rect) );
+			
+			MEMORY_BARRIER();
+			
+			v.count = n;
+		}
+		
+		MEMORY_BARRIER();
+	}
+	
+	int read_damage( const damage_list&  list,
+	                 uint16_t            last_seed,
+	                 uint16_t            seed,
+	                 damage_rect*        rects )
+	{
+		if ( uint16_t( last_seed + 1 ) != seed )
+		{
+			return -1;  // missed a frame
+		}
+		
+		const volatile damage_list& v = list;
+		
+		const uint16_t count = v.count;
+		
+		MEMORY_BARRIER();
+		
+		if ( v.seed != seed  ||  count > max_damage_rects )
+		{
+			return -1;
+		}
+		
+		memcpy( rects, list.rects, count * sizeof (damage_rect) );
+		
+		MEMORY_BARRIER();
+		
+		if ( v.count != count  ||  v.seed != seed )
+		{
+			return -1;  // republished while we were reading
+		}
+		
+		return count;
+	}
+	
+}
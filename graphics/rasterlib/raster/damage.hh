@@ -0,0 +1,87 @@
+/*
+	damage.hh
+	---------
+*/
+
+#ifndef RASTER_DAMAGE_HH
+#define RASTER_DAMAGE_HH
+
+// Standard C
+#include <stdint.h>
+
+// raster
+#include "raster/mb32.hh"
+#include "raster/note.hh"
+
+
+namespace raster
+{
+	
+	const note_type Note_damage = note_type( mb32( 'd', 'm', 'g', 'e' ) );
+	
+	/*
+		A damage note accompanies a sync note, and lists the rectangles of
+		the image that changed in the frame most recently published through
+		the sync relay.  Rows are in the range [top, bottom) and columns are
+		bytes within a row in the range [left, right), so readers convert
+		columns to pixels using the raster's weight.
+		
+		A reader that has drawn the frame with seed N may draw only the
+		damaged rectangles of frame N + 1.  If it missed a frame, or the
+		damage note's seed doesn't match the relay's, or the list overflowed,
+		it must redraw the whole image.  read_damage() checks all of this.
+		
+		The writer publishes the damage for a frame immediately before
+		broadcasting it, while no reader should be drawing from the list
+		(publish_damage() first marks it as overflowed, so a reader that
+		reads it anyway just redraws everything).
+	*/
+	
+	enum
+	{
+		max_damage_rects = 16,
+		damage_overflow  = 0xFFFF,
+	};
+	
+	struct damage_rect
+	{
+		uint16_t  top;
+		uint16_t  left;
+		uint16_t  bottom;
+		uint16_t  right;
+	};
+	
+	struct damage_list
+	{
+		uint16_t  seed;   // the relay seed of the frame described
+		uint16_t  count;  // the number of rects, or damage_overflow
+		
+		damage_rect  rects[ max_damage_rects ];
+	};
+	
+	bool is_valid_damage( const raster_note* note );
+	
+	/*
+		Publish n rectangles (or damage_overflow, in which case rects is
+		ignored) as the damage for the frame with the given relay seed.
+	*/
+	
+	void publish_damage( damage_list&        list,
+	                     uint16_t            seed,
+	                     const damage_rect*  rects,
+	                     uint16_t            n );
+	
+	/*
+		Copy the damage for the frame with relay seed `seed` into rects and
+		return the count, or return -1 if the whole image must be redrawn.
+		`last_seed` is the seed of the last frame the reader drew.
+	*/
+	
+	int read_damage( const damage_list&  list,
+	                 uint16_t            last_seed,
+	                 uint16_t            seed,
+	                 damage_rect*        rects );
+	
+}
+
+#endif
@@ -0,0 +1,72 @@
+/*
+	frames.cc
+	---------
+*/
+
+#include "raster/frames.hh"
+
+
+#ifdef __GNUC__
+#define MEMORY_BARRIER()  __sync_synchronize()
+#else
+#define MEMORY_BARRIER()  /**/
+#endif
+
+
+namespace raster
+{
+	
+	bool is_valid_frames( const raster_load& raster, const raster_note* note )
+	{
+		if ( note == NULL  ||  note->size != sizeof (frame_buffers) )
+		{
+			return false;
+		}
+		
+		const frame_buffers& frames = data< frame_buffers >( *note );
+		
+		const uint32_t count = frames.count;
+		
+		if ( count == 0  ||  frames.front >= count )
+		{
+			return false;
+		}
+		
+		const size_t footer_offset = (char*) raster.meta - (char*) raster.addr;
+		
+		return footer_offset / count >= image_size( raster.meta->desc );
+	}
+	
+	uint32_t front_index( const frame_buffers& frames )
+	{
+		const uint32_t front = *(const volatile uint32_t*) &frames.front;
+		
+		MEMORY_BARRIER();  // don't read the buffer before its index
+		
+		return front;
+	}
+	
+	void flip( frame_buffers& frames, uint32_t front )
+	{
+		MEMORY_BARRIER();  // finish writing the buffer before publishing it
+		
+		*(volatile uint32_t*) &frames.front = front;
+		
+		MEMORY_BARRIER();
+	}
+	
+	void* front_buffer( const raster_load& raster )
+	{
+		const raster_note* note = find_note( *raster.meta, Note_frames );
+		
+		if ( is_valid_frames( raster, note ) )
+		{
+			const frame_buffers& frames = data< frame_buffers >( *note );
+			
+			return frame_buffer( raster, front_index( frames ) % frames.count );
+		}
+		
+		return raster.addr;
+	}
+	
+}
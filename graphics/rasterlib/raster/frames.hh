@@ -0,0 +1,59 @@
+/*
+	frames.hh
+	---------
+*/
+
+#ifndef RASTER_FRAMES_HH
+#define RASTER_FRAMES_HH
+
+// Standard C
+#include <stdint.h>
+
+// raster
+#include "raster/mb32.hh"
+#include "raster/raster.hh"
+
+
+namespace raster
+{
+	
+	const note_type Note_frames = note_type( mb32( 'f', 'r', 'm', 's' ) );
+	
+	/*
+		See "Frame buffers" in raster.hh for the flip protocol.
+	*/
+	
+	struct frame_buffers
+	{
+		uint32_t  count;  // image buffers in the file (at least one)
+		uint32_t  front;  // index of the buffer that readers should show
+	};
+	
+	bool is_valid_frames( const raster_load& raster, const raster_note* note );
+	
+	inline
+	uint32_t image_size( const raster_desc& desc )
+	{
+		return desc.height * desc.stride;
+	}
+	
+	inline
+	void* frame_buffer( const raster_load& raster, uint32_t index )
+	{
+		return (char*) raster.addr + index * image_size( raster.meta->desc );
+	}
+	
+	uint32_t front_index( const frame_buffers& frames );
+	
+	void flip( frame_buffers& frames, uint32_t front );
+	
+	/*
+		Return the raster's front buffer, which is its only buffer if it
+		has no (valid) frames note.
+	*/
+	
+	void* front_buffer( const raster_load& raster );
+	
+}
+
+#endif
@@ -47,6 +47,34 @@ namespace raster
 		size to a multiple of the disk block size.)
 	*/
 	
+	/*
+		Frame buffers
+		
+		A raster may hold several image buffers back to back at the start
+		of the file, listed in a frames note ('frms', see frames.hh) with
+		their count and the index of the "front" buffer -- the one that
+		readers should show.  Without the note, there's only buffer 0.
+		
+		The writer draws into a back buffer and flips when a frame is done:
+		
+			1.  Finish writing the back buffer.
+			2.  Store its index in `front` (with barriers on either side).
+			3.  Publish damage and broadcast through the relay/sequence.
+			4.  Choose the next back buffer (the one after the new front),
+			    and bring it up to date by copying from the front buffer
+			    (just the damaged rectangles, if that's all that changed).
+		
+		Readers wake on the relay or sequence, read `front` and then draw
+		from that buffer in place, without copying it or taking a lock.
+		
+		A buffer is written again once it's the back buffer, which happens
+		on the next flip with two buffers, or after count - 1 flips in
+		general.  A reader that must not see a torn frame notes the seed
+		(or frame count) before and after reading, and reads again if it
+		advanced by count - 1 or more.  Three buffers give a reader a full
+		frame period of slack.
+	*/
+	
 	/*
 		struct raster_desc
 		
@@ -7,6 +7,7 @@
 
 // Standard C
 #include <errno.h>
+#include <time.h>
 
 // config
 #include "config/setpshared.h"
@@ -103,4 +104,47 @@ namespace raster
 		}
 	}
 	
+	void wait( sync_relay& relay, const volatile sig_atomic_t& interrupted )
+	{
+		int err = ETIMEDOUT;
+		
+	#if CONFIG_SETPSHARED
+		
+		const long slice = 50 * 1000 * 1000;  // 50ms, in nanoseconds
+		
+		while ( err == ETIMEDOUT  &&  ! interrupted )
+		{
+			timespec deadline;
+			
+			clock_gettime( CLOCK_REALTIME, &deadline );
+			
+			deadline.tv_nsec += slice;
+			
+			if ( deadline.tv_nsec >= 1000 * 1000 * 1000 )
+			{
+				deadline.tv_nsec -= 1000 * 1000 * 1000;
+				deadline.tv_sec  += 1;
+			}
+			
+			must_pthread_mutex_lock( &relay.mutex );
+			
+			err = pthread_cond_timedwait( &relay.cond, &relay.mutex, &deadline );
+			
+			must_pthread_mutex_unlock( &relay.mutex );
+		}
+		
+	#else
+		
+		err = ENOSYS;
+		
+	#endif
+		
+		if ( err  &&  err != ETIMEDOUT )
+		{
+			wait_failed exception = { err };
+			
+			throw exception;
+		}
+	}
+	
 }
@@ -6,6 +6,9 @@
 #ifndef RASTER_RELAY_HH
 #define RASTER_RELAY_HH
 
+// POSIX
+#include <signal.h>
+
 
 namespace raster
 {
@@ -24,6 +27,15 @@ namespace raster
 	void terminate( sync_relay& relay );
 	void wait     ( sync_relay& relay );
 	
+	/*
+		The same, but also return once `interrupted` is set.  A signal
+		handler can't safely broadcast the relay to wake its own process
+		(and doing so would publish a frame to every reader), so instead
+		this waits in slices and checks the flag between them.
+	*/
+	
+	void wait( sync_relay& relay, const volatile sig_atomic_t& interrupted );
+	
 }
 
 #endif
@@ -0,0 +1,170 @@
+/*
+	sequence.cc
+	-----------
+*/
+
+#include "raster/sequence.hh"
+
+// POSIX
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+
+// Standard C
+#include <errno.h>
+#include <limits.h>
+
+// raster
+#include "raster/relay.hh"
+#include "raster/relay_detail.hh"
+
+
+#ifdef __GNUC__
+#define ATOMIC_ADD( p, n )  __sync_add_and_fetch( p, n )
+#define MEMORY_BARRIER()    __sync_synchronize()
+#else
+#define ATOMIC_ADD( p, n )  (*(p) += (n))
+#define MEMORY_BARRIER()    /**/
+#endif
+
+
+namespace raster
+{
+	
+	/*
+		The futexes are in a shared file mapping, so they can't use the
+		private (single-process) futex operations.
+	*/
+	
+	static
+	int futex_wait( volatile uint32_t* addr, uint32_t value, bool sliced )
+	{
+	#ifdef __linux__
+		
+		const timespec slice = { 0, 50 * 1000 * 1000 };  // 50ms
+		
+		const timespec* timeout = sliced ? &slice : NULL;
+		
+		if ( syscall( SYS_futex, addr, FUTEX_WAIT, value, timeout, NULL, 0 ) == 0 )
+		{
+			return 0;
+		}
+		
+		const int err = errno;
+		
+		return err == EAGAIN  ||  err == EINTR  ||  err == ETIMEDOUT ? 0 : err;
+	
+	#else
+		
+		usleep( 1000 );  // poll
+		
+		return 0;
+	
+	#endif
+	}
+	
+	static
+	void futex_wake( volatile uint32_t* addr )
+	{
+	#ifdef __linux__
+		
+		syscall( SYS_futex, addr, FUTEX_WAKE, INT_MAX, NULL, NULL, 0 );
+	
+	#endif
+	}
+	
+	bool is_valid_sequence( const raster_note* note )
+	{
+		return note != NULL  &&  note->size == sizeof (frame_sequence);
+	}
+	
+	void publish( frame_sequence& sequence )
+	{
+		sequence.frame    = 0;
+		sequence.waiters  = 0;
+		sequence.reserved = 0;
+		
+		MEMORY_BARRIER();
+		
+		sequence.status = Sync_ready;
+	}
+	
+	void broadcast( frame_sequence& sequence )
+	{
+		ATOMIC_ADD( &sequence.frame, 1 );
+		
+		/*
+			The increment is a full barrier, so either a reader registered
+			as a waiter before we read `waiters` (and we wake it), or its
+			futex wait will see the new frame and return at once.
+		*/
+		
+		if ( *(volatile uint32_t*) &sequence.waiters )
+		{
+			futex_wake( &sequence.frame );
+		}
+	}
+	
+	void terminate( frame_sequence& sequence )
+	{
+		sequence.status = Sync_ended;
+		
+		broadcast( sequence );
+	}
+	
+	/*
+		A signal that arrives during the futex wait cuts it short, but one
+		that arrives just before it can't, so if there's a flag for a signal
+		handler to set, we wait in slices and check it between them.
+	*/
+	
+	static
+	uint32_t wait_past( frame_sequence&               sequence,
+	                    uint32_t                      last,
+	                    const volatile sig_atomic_t*  interrupted )
+	{
+		volatile frame_sequence& v = sequence;
+		
+		uint32_t frame;
+		
+		while ( (frame = v.frame) == last  &&  v.status == Sync_ready )
+		{
+			if ( interrupted  &&  *interrupted )
+			{
+				break;
+			}
+			
+			ATOMIC_ADD( &sequence.waiters, 1 );
+			
+			const int err = futex_wait( &v.frame, last, interrupted != NULL );
+			
+			ATOMIC_ADD( &sequence.waiters, -1 );
+			
+			if ( err )
+			{
+				wait_failed exception = { err };
+				
+				throw exception;
+			}
+		}
+		
+		return frame;
+	}
+	
+	uint32_t wait_past( frame_sequence& sequence, uint32_t last )
+	{
+		return wait_past( sequence, last, NULL );
+	}
+	
+	uint32_t wait_past( frame_sequence&               sequence,
+	                    uint32_t                      last,
+	                    const volatile sig_atomic_t&  interrupted )
+	{
+		return wait_past( sequence, last, &interrupted );
+	}
+	
+}
@@ -0,0 +1,72 @@
+/*
+	sequence.hh
+	-----------
+*/
+
+#ifndef RASTER_SEQUENCE_HH
+#define RASTER_SEQUENCE_HH
+
+// Standard C
+#include <signal.h>
+#include <stdint.h>
+
+// raster
+#include "raster/mb32.hh"
+#include "raster/note.hh"
+
+
+namespace raster
+{
+	
+	const note_type Note_sequence = note_type( mb32( 's', 'e', 'q', 'n' ) );
+	
+	/*
+		A frame sequence is a lock-free alternative to the sync relay.  The
+		writer atomically increments `frame` for each frame it publishes and
+		never waits for readers, who wake via a futex on `frame` (on Linux;
+		elsewhere they poll).  Any number of readers can wait at once.
+		
+		A reader that last drew frame N asks for a frame past N and gets
+		the latest one, so a slow reader skips the frames it missed instead
+		of holding up the writer or falling behind.  A writer that also
+		maintains a damage note keys it with the low 16 bits of `frame`.
+		
+		A reader shouldn't broadcast the sequence to wake itself (say, from
+		a signal handler), since that would publish a frame to everyone.
+		Instead, it passes the flag its handler sets to wait_past().
+	*/
+	
+	struct frame_sequence
+	{
+		uint32_t  frame;    // frames published so far
+		uint32_t  waiters;  // readers blocked (or about to block) on frame
+		int32_t   status;   // sync_status
+		uint32_t  reserved;
+	};
+	
+	bool is_valid_sequence( const raster_note* note );
+	
+	void publish  ( frame_sequence& sequence );
+	void broadcast( frame_sequence& sequence );
+	void terminate( frame_sequence& sequence );
+	
+	/*
+		Wait until a frame past `last` is published (or the sequence has
+		ended), and return the latest frame.  Frames between `last` and the
+		result were skipped.  Throws wait_failed if the wait fails.
+	*/
+	
+	uint32_t wait_past( frame_sequence& sequence, uint32_t last );
+	
+	/*
+		The same, but also return (possibly with `last`) once `interrupted`
+		is set.
+	*/
+	
+	uint32_t wait_past( frame_sequence&               sequence,
+	                    uint32_t                      last,
+	                    const volatile sig_atomic_t&  interrupted );
+	
+}
+
+#endif
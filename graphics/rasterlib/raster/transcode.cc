@@ -0,0 +1,708 @@
+/*
+	transcode.cc
+	------------
+*/
+
+#include "raster/transcode.hh"
+
+// Standard C
+#include <string.h>
+
+// config
+#include "config/simd.h"
+
+#if CONFIG_SSE2
+#include <emmintrin.h>
+#endif
+
+#if CONFIG_AVX2
+#include <immintrin.h>
+#endif
+
+#if CONFIG_NEON
+#include <arm_neon.h>
+#endif
+
+
+#if CONFIG_AVX2
+#define AVX2_TARGET  __attribute__(( target( "avx2" ) ))
+#endif
+
+
+namespace raster
+{
+	
+	static inline
+	int source_bytes( const transcoder& t, int width )
+	{
+		return (width * t.src_weight + 7) / 8;
+	}
+	
+	static inline
+	uint32_t rgb565( uint32_t xrgb )
+	{
+		const uint32_t r = xrgb >> 16 & 0xFF;
+		const uint32_t g = xrgb >>  8 & 0xFF;
+		const uint32_t b = xrgb       & 0xFF;
+		
+		return (r >> 3) << 11 | (g >> 2) << 5 | b >> 3;
+	}
+	
+	/*
+		Portable
+		--------
+	*/
+	
+	template < int size >
+	static
+	void expand_bytes( const uint8_t* expansion, const uint8_t* src, uint8_t* dst, int n )
+	{
+		while ( n-- > 0 )
+		{
+			memcpy( dst, expansion + *src++ * 32, size );
+			
+			dst += size;
+		}
+	}
+	
+	static
+	void expand( const transcoder& t, const uint8_t* src, uint8_t* dst, int n )
+	{
+		const uint8_t* expansion = t.expansion;
+		
+		switch ( t.expansion_size )
+		{
+			case  2:  expand_bytes<  2 >( expansion, src, dst, n );  break;
+			case  4:  expand_bytes<  4 >( expansion, src, dst, n );  break;
+			case  8:  expand_bytes<  8 >( expansion, src, dst, n );  break;
+			case 16:  expand_bytes< 16 >( expansion, src, dst, n );  break;
+			case 32:  expand_bytes< 32 >( expansion, src, dst, n );  break;
+			
+			default:
+				break;
+		}
+	}
+	
+	static
+	void transcode_portable( const transcoder&  t,
+	                         const uint8_t*     src,
+	                         uint8_t*           dst,
+	                         int                width )
+	{
+		expand( t, src, dst, source_bytes( t, width ) );
+	}
+	
+	/*
+		SSE2
+		----
+		
+		1-bit pixels are selected by comparing their bits in a broadcast copy
+		of several source bytes with a mask for each lane.  (For 2-bit pixels
+		and up, the portable path's table is faster than comparing with each
+		possible value.)
+	*/
+
+#if CONFIG_SSE2
+	
+	static inline
+	__m128i select_SSE2( __m128i mask, __m128i a, __m128i b )
+	{
+		return _mm_or_si128( _mm_andnot_si128( mask, a ), _mm_and_si128( mask, b ) );
+	}
+	
+	static inline
+	__m128i select_bits_SSE2( __m128i word, __m128i bits, __m128i c0, __m128i c1 )
+	{
+		const __m128i m = _mm_cmpeq_epi32( _mm_and_si128( word, bits ), bits );
+		
+		return select_SSE2( m, c0, c1 );
+	}
+	
+	static
+	void transcode_1_to_32_SSE2( const transcoder&  t,
+	                             const uint8_t*     src,
+	                             uint8_t*           dst,
+	                             int                width )
+	{
+		const __m128i c0 = _mm_set1_epi32( t.clut[ 0 ] );
+		const __m128i c1 = _mm_set1_epi32( t.clut[ 1 ] );
+		
+		const __m128i hi = _mm_setr_epi32( 0x80, 0x40, 0x20, 0x10 );
+		const __m128i lo = _mm_setr_epi32( 0x08, 0x04, 0x02, 0x01 );
+		
+		int n = source_bytes( t, width );
+		
+		while ( n >= 2 )
+		{
+			// Byte 0 is tested in the low byte of each lane, byte 1 above it.
+			
+			const __m128i word = _mm_set1_epi32( src[ 0 ] | src[ 1 ] << 8 );
+			
+			__m128i* p = (__m128i*) dst;
+			
+			_mm_storeu_si128( p++, select_bits_SSE2( word, hi, c0, c1 ) );
+			_mm_storeu_si128( p++, select_bits_SSE2( word, lo, c0, c1 ) );
+			
+			_mm_storeu_si128( p++, select_bits_SSE2( word, _mm_slli_epi32( hi, 8 ), c0, c1 ) );
+			_mm_storeu_si128( p++, select_bits_SSE2( word, _mm_slli_epi32( lo, 8 ), c0, c1 ) );
+			
+			src += 2;
+			dst += 64;
+			n   -= 2;
+		}
+		
+		expand( t, src, dst, n );
+	}
+	
+	static
+	void transcode_1_to_16_SSE2( const transcoder&  t,
+	                             const uint8_t*     src,
+	                             uint8_t*           dst,
+	                             int                width )
+	{
+		const __m128i c0 = _mm_set1_epi16( t.clut[ 0 ] );
+		const __m128i c1 = _mm_set1_epi16( t.clut[ 1 ] );
+		
+		const __m128i bits_0 = _mm_setr_epi16( 0x80, 0x40, 0x20, 0x10,
+		                                       0x08, 0x04, 0x02, 0x01 );
+		
+		const __m128i bits_1 = _mm_slli_epi16( bits_0, 8 );
+		
+		int n = source_bytes( t, width );
+		
+		while ( n >= 2 )
+		{
+			const __m128i word = _mm_set1_epi16( src[ 0 ] | src[ 1 ] << 8 );
+			
+			const __m128i m0 = _mm_cmpeq_epi16( _mm_and_si128( word, bits_0 ), bits_0 );
+			const __m128i m1 = _mm_cmpeq_epi16( _mm_and_si128( word, bits_1 ), bits_1 );
+			
+			_mm_storeu_si128( (__m128i*) dst,        select_SSE2( m0, c0, c1 ) );
+			_mm_storeu_si128( (__m128i*) (dst + 16), select_SSE2( m1, c0, c1 ) );
+			
+			src += 2;
+			dst += 32;
+			n   -= 2;
+		}
+		
+		expand( t, src, dst, n );
+	}
+
+#endif
+	
+	/*
+		AVX2
+		----
+		
+		Eight source pixels at a time are unpacked into 32-bit lanes, and
+		looked up with a permute (for tables of up to 16 colors) or a gather.
+		Pairs of results are packed for 16-bit output.
+	*/
+
+#if CONFIG_AVX2
+	
+	template < int weight >
+	static inline AVX2_TARGET
+	__m256i indices_AVX2( const uint8_t* src );
+	
+	template <>
+	inline AVX2_TARGET
+	__m256i indices_AVX2< 2 >( const uint8_t* src )
+	{
+		const __m256i shifts = _mm256_setr_epi32( 6, 4, 2, 0, 6, 4, 2, 0 );
+		
+		__m128i x = _mm_cvtsi32_si128( src[ 0 ] | src[ 1 ] << 8 );
+		
+		x = _mm_unpacklo_epi8 ( x, x );  // b0 b0 b1 b1
+		x = _mm_unpacklo_epi16( x, x );  // b0 b0 b0 b0 b1 b1 b1 b1
+		
+		const __m256i bytes = _mm256_cvtepu8_epi32( x );
+		
+		return _mm256_and_si256( _mm256_srlv_epi32( bytes, shifts ),
+		                         _mm256_set1_epi32( 0x3 ) );
+	}
+	
+	template <>
+	inline AVX2_TARGET
+	__m256i indices_AVX2< 4 >( const uint8_t* src )
+	{
+		const __m256i shifts = _mm256_setr_epi32( 4, 0, 4, 0, 4, 0, 4, 0 );
+		
+		uint32_t word;
+		
+		memcpy( &word, src, sizeof word );
+		
+		__m128i x = _mm_cvtsi32_si128( word );
+		
+		x = _mm_unpacklo_epi8( x, x );  // b0 b0 b1 b1 b2 b2 b3 b3
+		
+		const __m256i bytes = _mm256_cvtepu8_epi32( x );
+		
+		return _mm256_and_si256( _mm256_srlv_epi32( bytes, shifts ),
+		                         _mm256_set1_epi32( 0xF ) );
+	}
+	
+	template <>
+	inline AVX2_TARGET
+	__m256i indices_AVX2< 8 >( const uint8_t* src )
+	{
+		return _mm256_cvtepu8_epi32( _mm_loadl_epi64( (const __m128i*) src ) );
+	}
+	
+	template < int weight >
+	static inline AVX2_TARGET
+	__m256i lookup_AVX2( const transcoder& t, __m256i i )
+	{
+		const __m256i* clut = (const __m256i*) t.clut;
+		
+		if ( weight <= 2 )
+		{
+			return _mm256_permutevar8x32_epi32( _mm256_loadu_si256( clut ), i );
+		}
+		
+		if ( weight == 4 )
+		{
+			const __m256i lo = _mm256_loadu_si256( clut     );
+			const __m256i hi = _mm256_loadu_si256( clut + 1 );
+			
+			const __m256i m = _mm256_cmpgt_epi32( i, _mm256_set1_epi32( 7 ) );
+			
+			return _mm256_blendv_epi8( _mm256_permutevar8x32_epi32( lo, i ),
+			                           _mm256_permutevar8x32_epi32( hi, i ),
+			                           m );
+		}
+		
+		return _mm256_i32gather_epi32( (const int*) t.clut, i, 4 );
+	}
+	
+	template < int weight >
+	static AVX2_TARGET
+	void transcode_to_32_AVX2( const transcoder&  t,
+	                           const uint8_t*     src,
+	                           uint8_t*           dst,
+	                           int                width )
+	{
+		int n = source_bytes( t, width );
+		
+		while ( n >= weight )
+		{
+			const __m256i i = indices_AVX2< weight >( src );
+			
+			_mm256_storeu_si256( (__m256i*) dst, lookup_AVX2< weight >( t, i ) );
+			
+			src += weight;
+			dst += 32;
+			n   -= weight;
+		}
+		
+		expand( t, src, dst, n );
+	}
+	
+	template < int weight >
+	static AVX2_TARGET
+	void transcode_to_16_AVX2( const transcoder&  t,
+	                           const uint8_t*     src,
+	                           uint8_t*           dst,
+	                           int                width )
+	{
+		int n = source_bytes( t, width );
+		
+		while ( n >= 2 * weight )
+		{
+			const __m256i a = lookup_AVX2< weight >( t, indices_AVX2< weight >( src          ) );
+			const __m256i b = lookup_AVX2< weight >( t, indices_AVX2< weight >( src + weight ) );
+			
+			// Packing works within 128-bit lanes, so restore the order after.
+			
+			const __m256i packed = _mm256_packus_epi32( a, b );
+			
+			_mm256_storeu_si256( (__m256i*) dst, _mm256_permute4x64_epi64( packed, 0xD8 ) );
+			
+			src += 2 * weight;
+			dst += 32;
+			n   -= 2 * weight;
+		}
+		
+		expand( t, src, dst, n );
+	}
+
+	/*
+		For 1-bit pixels, selecting with a compare (as with SSE2) beats the
+		generic lookup.
+	*/
+	
+	static AVX2_TARGET
+	void transcode_1_to_32_AVX2( const transcoder&  t,
+	                             const uint8_t*     src,
+	                             uint8_t*           dst,
+	                             int                width )
+	{
+		const __m256i c0 = _mm256_set1_epi32( t.clut[ 0 ] );
+		const __m256i c1 = _mm256_set1_epi32( t.clut[ 1 ] );
+		
+		const __m256i bits = _mm256_setr_epi32( 0x80, 0x40, 0x20, 0x10,
+		                                        0x08, 0x04, 0x02, 0x01 );
+		
+		int n = source_bytes( t, width );
+		
+		while ( n >= 4 )
+		{
+			uint32_t word;
+			
+			memcpy( &word, src, sizeof word );
+			
+			const __m256i words = _mm256_set1_epi32( word );
+			
+			__m256i* p = (__m256i*) dst;
+			
+			// Byte k of the source is byte k of each (little-endian) lane.
+			
+			__m256i b = bits;
+			
+			for ( int k = 0;  k < 4;  ++k )
+			{
+				const __m256i m = _mm256_cmpeq_epi32( _mm256_and_si256( words, b ), b );
+				
+				_mm256_storeu_si256( p++, _mm256_blendv_epi8( c0, c1, m ) );
+				
+				b = _mm256_slli_epi32( b, 8 );
+			}
+			
+			src += 4;
+			dst += 128;
+			n   -= 4;
+		}
+		
+		expand( t, src, dst, n );
+	}
+	
+	static AVX2_TARGET
+	void transcode_1_to_16_AVX2( const transcoder&  t,
+	                             const uint8_t*     src,
+	                             uint8_t*           dst,
+	                             int                width )
+	{
+		const __m256i c0 = _mm256_set1_epi16( t.clut[ 0 ] );
+		const __m256i c1 = _mm256_set1_epi16( t.clut[ 1 ] );
+		
+		const __m256i bits = _mm256_setr_epi16( 0x0080, 0x0040, 0x0020, 0x0010,
+		                                        0x0008, 0x0004, 0x0002, 0x0001,
+		                                        0x8000, 0x4000, 0x2000, 0x1000,
+		                                        0x0800, 0x0400, 0x0200, 0x0100 );
+		
+		int n = source_bytes( t, width );
+		
+		while ( n >= 2 )
+		{
+			const __m256i words = _mm256_set1_epi16( src[ 0 ] | src[ 1 ] << 8 );
+			
+			const __m256i m = _mm256_cmpeq_epi16( _mm256_and_si256( words, bits ), bits );
+			
+			_mm256_storeu_si256( (__m256i*) dst, _mm256_blendv_epi8( c0, c1, m ) );
+			
+			src += 2;
+			dst += 32;
+			n   -= 2;
+		}
+		
+		expand( t, src, dst, n );
+	}
+	
+#endif
+	
+	/*
+		NEON
+		----
+		
+		As with SSE2, 1-bit pixels are selected by testing their bits in
+		a broadcast copy of their byte.
+	*/
+
+#if CONFIG_NEON
+	
+	static
+	void transcode_1_to_32_NEON( const transcoder&  t,
+	                             const uint8_t*     src,
+	                             uint8_t*           dst,
+	                             int                width )
+	{
+		static const uint32_t hi_bits[] = { 0x80, 0x40, 0x20, 0x10 };
+		static const uint32_t lo_bits[] = { 0x08, 0x04, 0x02, 0x01 };
+		
+		const uint32x4_t c0 = vdupq_n_u32( t.clut[ 0 ] );
+		const uint32x4_t c1 = vdupq_n_u32( t.clut[ 1 ] );
+		
+		const uint32x4_t hi = vld1q_u32( hi_bits );
+		const uint32x4_t lo = vld1q_u32( lo_bits );
+		
+		uint32_t* p = (uint32_t*) dst;
+		
+		int n = source_bytes( t, width );
+		
+		while ( n-- > 0 )
+		{
+			const uint32x4_t byte = vdupq_n_u32( *src++ );
+			
+			vst1q_u32( p,     vbslq_u32( vtstq_u32( byte, hi ), c1, c0 ) );
+			vst1q_u32( p + 4, vbslq_u32( vtstq_u32( byte, lo ), c1, c0 ) );
+			
+			p += 8;
+		}
+	}
+	
+	static
+	void transcode_1_to_16_NEON( const transcoder&  t,
+	                             const uint8_t*     src,
+	                             uint8_t*           dst,
+	                             int                width )
+	{
+		static const uint16_t bit_values[] = { 0x80, 0x40, 0x20, 0x10,
+		                                       0x08, 0x04, 0x02, 0x01 };
+		
+		const uint16x8_t c0 = vdupq_n_u16( t.clut[ 0 ] );
+		const uint16x8_t c1 = vdupq_n_u16( t.clut[ 1 ] );
+		
+		const uint16x8_t bits = vld1q_u16( bit_values );
+		
+		uint16_t* p = (uint16_t*) dst;
+		
+		int n = source_bytes( t, width );
+		
+		while ( n-- > 0 )
+		{
+			const uint16x8_t byte = vdupq_n_u16( *src++ );
+			
+			vst1q_u16( p, vbslq_u16( vtstq_u16( byte, bits ), c1, c0 ) );
+			
+			p += 8;
+		}
+	}
+
+#endif
+	
+	static
+	transcode_proc select_proc( transcode_path path, int src_weight, int dst_weight )
+	{
+		const bool to_32 = dst_weight == 32;
+		
+		switch ( path )
+		{
+		#if CONFIG_SSE2
+			
+			case Path_SSE2:
+				switch ( src_weight )
+				{
+					case 1:  return to_32 ? &transcode_1_to_32_SSE2 : &transcode_1_to_16_SSE2;
+					
+					default:
+						break;
+				}
+				
+				break;
+		
+		#endif
+		
+		#if CONFIG_AVX2
+			
+			case Path_AVX2:
+				switch ( src_weight )
+				{
+					case 1:  return to_32 ? &transcode_1_to_32_AVX2 : &transcode_1_to_16_AVX2;
+					case 2:  return to_32 ? &transcode_to_32_AVX2< 2 > : &transcode_to_16_AVX2< 2 >;
+					case 4:  return to_32 ? &transcode_to_32_AVX2< 4 > : &transcode_to_16_AVX2< 4 >;
+					case 8:  return to_32 ? &transcode_to_32_AVX2< 8 > : &transcode_to_16_AVX2< 8 >;
+					
+					default:
+						break;
+				}
+				
+				break;
+		
+		#endif
+		
+		#if CONFIG_NEON
+			
+			case Path_NEON:
+				if ( src_weight == 1 )
+				{
+					return to_32 ? &transcode_1_to_32_NEON : &transcode_1_to_16_NEON;
+				}
+				
+				break;
+		
+		#endif
+			
+			default:
+				break;
+		}
+		
+		return NULL;
+	}
+	
+	const char* transcode_path_name( transcode_path path )
+	{
+		switch ( path )
+		{
+			case Path_portable:  return "portable";
+			case Path_SSE2:      return "SSE2";
+			case Path_AVX2:      return "AVX2";
+			case Path_NEON:      return "NEON";
+			
+			default:
+				return NULL;
+		}
+	}
+	
+	bool transcode_path_available( transcode_path path )
+	{
+		switch ( path )
+		{
+			case Path_portable:
+				return true;
+			
+			case Path_SSE2:
+				return CONFIG_SSE2;
+			
+			case Path_AVX2:
+			#if CONFIG_AVX2
+				__builtin_cpu_init();
+				
+				return __builtin_cpu_supports( "avx2" );
+			#endif
+				
+				return false;
+			
+			case Path_NEON:
+				return CONFIG_NEON;
+			
+			default:
+				return false;
+		}
+	}
+	
+	transcode_path best_transcode_path()
+	{
+		/*
+			The SSE2 path measures slower than the portable path's table on
+			the machines we've tried (see transcode-bench), so it's only used
+			when requested.
+		*/
+		
+		static int best = -1;
+		
+		if ( best < 0 )
+		{
+			best = transcode_path_available( Path_AVX2 ) ? Path_AVX2
+			     : transcode_path_available( Path_NEON ) ? Path_NEON
+			     :                                         Path_portable;
+		}
+		
+		return transcode_path( best );
+	}
+	
+	bool make_gray_clut( uint32_t* clut, int weight, raster_model model )
+	{
+		if ( model != Model_grayscale_paint  &&  model != Model_grayscale_light )
+		{
+			return false;
+		}
+		
+		const uint32_t max = (1 << weight) - 1;
+		
+		for ( uint32_t i = 0;  i <= max;  ++i )
+		{
+			uint32_t level = i * 255 / max;
+			
+			if ( model == Model_grayscale_paint )
+			{
+				level = 255 - level;
+			}
+			
+			clut[ i ] = level * 0x01010101;
+		}
+		
+		return true;
+	}
+	
+	bool set_up_transcoder( transcoder&      t,
+	                        int              src_weight,
+	                        int              dst_weight,
+	                        const uint32_t*  clut,
+	                        transcode_path   path )
+	{
+		switch ( src_weight )
+		{
+			case 1:
+			case 2:
+			case 4:
+			case 8:
+				break;
+			
+			default:
+				return false;
+		}
+		
+		if ( dst_weight != 16  &&  dst_weight != 32 )
+		{
+			return false;
+		}
+		
+		const int n_colors     = 1 << src_weight;
+		const int per_byte     = 8 / src_weight;
+		const int dst_bytes    = dst_weight / 8;
+		
+		t.src_weight     = src_weight;
+		t.dst_weight     = dst_weight;
+		t.expansion_size = per_byte * dst_bytes;
+		t.reserved       = 0;
+		
+		memset( t.clut, '\0', sizeof t.clut );
+		
+		for ( int i = 0;  i < n_colors;  ++i )
+		{
+			t.clut[ i ] = dst_weight == 16 ? rgb565( clut[ i ] ) : clut[ i ];
+		}
+		
+		const int mask = n_colors - 1;
+		
+		for ( int byte = 0;  byte < 256;  ++byte )
+		{
+			uint8_t* p = t.expansion + byte * 32;
+			
+			for ( int i = 0;  i < per_byte;  ++i )
+			{
+				const int shift = 8 - src_weight * (i + 1);
+				
+				const uint32_t pixel = t.clut[ byte >> shift & mask ];
+				
+				if ( dst_weight == 16 )
+				{
+					const uint16_t pixel16 = pixel;
+					
+					memcpy( p, &pixel16, sizeof pixel16 );
+				}
+				else
+				{
+					memcpy( p, &pixel, sizeof pixel );
+				}
+				
+				p += dst_bytes;
+			}
+		}
+		
+		t.path = Path_portable;
+		t.proc = &transcode_portable;
+		
+		if ( transcode_path_available( path ) )
+		{
+			if ( transcode_proc proc = select_proc( path, src_weight, dst_weight ) )
+			{
+				t.path = path;
+				t.proc = proc;
+			}
+		}
+		
+		return true;
+	}
+	
+}
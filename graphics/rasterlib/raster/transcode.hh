@@ -0,0 +1,108 @@
+/*
+	transcode.hh
+	------------
+*/
+
+#ifndef RASTER_TRANSCODE_HH
+#define RASTER_TRANSCODE_HH
+
+// Standard C
+#include <stdint.h>
+
+// raster
+#include "raster/raster.hh"
+
+
+namespace raster
+{
+	
+	/*
+		A transcoder converts rows of 1, 2, 4, or 8-bit pixels into 16 or
+		32-bit direct pixels (in native byte order), by looking up each source
+		pixel in a color table of destination pixels.  Source pixels are read
+		a byte at a time, so the output for a row of `width` pixels is rounded
+		up to a whole number of source bytes.
+		
+		Each path is an implementation for a particular instruction set.  The
+		portable path expands each source byte with a precomputed table; the
+		others also fall back to it for the end of a row.
+	*/
+	
+	enum transcode_path
+	{
+		Path_portable,
+		Path_SSE2,
+		Path_AVX2,
+		Path_NEON,
+		
+		Path_end_of_enumeration,
+	};
+	
+	struct transcoder;
+	
+	typedef void (*transcode_proc)( const transcoder&  t,
+	                                const uint8_t*     src,
+	                                uint8_t*           dst,
+	                                int                width );
+	
+	struct transcoder
+	{
+		transcode_proc  proc;
+		transcode_path  path;
+		
+		uint8_t  src_weight;
+		uint8_t  dst_weight;
+		uint8_t  expansion_size;  // bytes of output per byte of input
+		uint8_t  reserved;
+		
+		uint32_t  clut[ 256 ];  // destination pixel for each source value
+		
+		uint8_t  expansion[ 256 * 32 ];  // output for each source byte
+	};
+	
+	const char* transcode_path_name( transcode_path path );
+	
+	bool transcode_path_available( transcode_path path );
+	
+	/*
+		Returns the fastest path the processor supports.  It's checked once
+		and remembered.  (Run transcode-bench to compare them.)
+	*/
+	
+	transcode_path best_transcode_path();
+	
+	/*
+		Fill a color table of 2^weight xRGB colors for a grayscale model,
+		replicating each gray level into all four bytes (so paint's white
+		and light's white are both 0xFFFFFFFF, and black is zero).  Returns
+		false for other models.
+	*/
+	
+	bool make_gray_clut( uint32_t* clut, int weight, raster_model model );
+	
+	/*
+		Set up t to transcode src_weight-bit pixels to dst_weight-bit ones,
+		using the given color table of 2^src_weight xRGB colors (converted
+		to 5/6/5 for 16-bit output).  If the path isn't available (or has
+		no implementation for the weights), t uses the portable path.
+		Returns false if the weights aren't supported.
+	*/
+	
+	bool set_up_transcoder( transcoder&      t,
+	                        int              src_weight,
+	                        int              dst_weight,
+	                        const uint32_t*  clut,
+	                        transcode_path   path = best_transcode_path() );
+	
+	inline
+	void transcode( const transcoder&  t,
+	                const uint8_t*     src,
+	                uint8_t*           dst,
+	                int                width )
+	{
+		t.proc( t, src, dst, width );
+	}
+	
+}
+
+#endif
@@ -0,0 +1,73 @@
+/*
+	format.hh
+	---------
+*/
+
+#ifndef FORMAT_HH
+#define FORMAT_HH
+
+// Standard C
+#include <stdint.h>
+
+// rasterlib
+#include "raster/mb32.hh"
+#include "raster/raster.hh"
+
+
+/*
+	A screencast file is a header, followed by frames, followed (if the
+	recording ended cleanly) by an index of the keyframes.  Everything is
+	in native byte order.
+	
+	Each frame is a frame_header and the frame's image, XORed with the
+	previous frame's (or with zero, for a keyframe) and packed with
+	Damogran.  The packed data is padded with a Damogran no-op to a
+	multiple of four bytes, as unpacking requires.
+	
+	The index is a list of index_entry records for the keyframes and an
+	index_trailer at the very end of the file.  A file without a trailer
+	(e.g. from a recorder that was killed) is still playable -- the index
+	is rebuilt by walking the frame headers, ignoring a truncated frame.
+*/
+
+const uint32_t screencast_magic   = raster::mb32( 'D', 'm', 'g', 'C' );
+const uint32_t screencast_version = 1;
+
+const uint32_t index_magic = raster::mb32( 'D', 'm', 'g', 'X' );
+
+enum
+{
+	Frame_key = 1,
+};
+
+struct screencast_header
+{
+	uint32_t  magic;
+	uint32_t  version;
+	uint64_t  start_time;  // microseconds since the Unix epoch
+	uint32_t  image_size;  // bytes per frame
+	uint32_t  reserved;
+	
+	raster::raster_desc  desc;
+};
+
+struct frame_header
+{
+	uint64_t  timestamp;  // microseconds since start_time
+	uint32_t  size;       // bytes of packed data following
+	uint32_t  flags;
+};
+
+struct index_entry
+{
+	uint64_t  timestamp;
+	uint64_t  offset;  // of the frame_header
+};
+
+struct index_trailer
+{
+	uint32_t  count;  // index entries preceding the trailer
+	uint32_t  magic;
+};
+
+#endif
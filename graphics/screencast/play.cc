@@ -0,0 +1,633 @@
+/*
+	play.cc
+	-------
+*/
+
+#include "play.hh"
+
+// POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Standard C
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// command
+#include "command/get_option.hh"
+
+// damogran
+#include "damogran/unpack.hh"
+
+// gear
+#include "gear/parse_decimal.hh"
+
+// more-posix
+#include "more/perror.hh"
+
+// rasterlib
+#include "raster/damage.hh"
+#include "raster/frames.hh"
+#include "raster/load.hh"
+#include "raster/relay.hh"
+#include "raster/relay_detail.hh"
+#include "raster/sequence.hh"
+#include "raster/sync.hh"
+
+// screencast
+#include "format.hh"
+
+
+#define PROGRAM  "screencast"
+
+#define STR_LEN( s )  "" s, (sizeof s - 1)
+
+#define WARN( msg )  write( STDERR_FILENO, STR_LEN( PROGRAM ": " msg "\n" ) )
+
+
+enum
+{
+	Opt_seek = 's',
+};
+
+static command::option options[] =
+{
+	{ "seek", Opt_seek, command::Param_required },
+	{ NULL }
+};
+
+static uint64_t seek_time;  // microseconds
+
+struct screencast
+{
+	const uint8_t*  begin;
+	const uint8_t*  frames_end;  // start of the index, if any
+	const uint8_t*  end;
+	
+	const screencast_header*  header;
+	
+	index_entry*  index;
+	uint32_t      index_count;
+	
+	uint32_t  frame_count;   // complete frames
+	uint64_t  duration;      // timestamp of the last one
+};
+
+
+static
+void report_error( const char* path, int err )
+{
+	more::perror( PROGRAM, path, err );
+}
+
+static
+char* const* get_options( char** argv )
+{
+	int opt;
+	
+	++argv;  // skip arg 0
+	
+	while ( (opt = command::get_option( (char* const**) &argv, options )) > 0 )
+	{
+		using command::global_result;
+		using gear::parse_unsigned_decimal;
+		
+		switch ( opt )
+		{
+			case Opt_seek:
+				seek_time = parse_unsigned_decimal( global_result.param )
+				          * 1000000ull;
+				break;
+			
+			default:
+				break;
+		}
+	}
+	
+	return argv;
+}
+
+static inline
+const frame_header& header_at( const screencast& cast, uint64_t offset )
+{
+	return *(const frame_header*) (cast.begin + offset);
+}
+
+/*
+	Return the offset of the frame following the one at `offset`, or zero
+	if there's no complete frame at `offset`.
+*/
+
+static
+uint64_t next_frame( const screencast& cast, uint64_t offset )
+{
+	const uint64_t limit = cast.frames_end - cast.begin;
+	
+	if ( limit - offset < sizeof (frame_header) )
+	{
+		return 0;
+	}
+	
+	const frame_header& frame = header_at( cast, offset );
+	
+	offset += sizeof (frame_header);
+	
+	if ( limit - offset < frame.size  ||  frame.size & 0x3 )
+	{
+		return 0;
+	}
+	
+	return offset + frame.size;
+}
+
+static
+bool load_index( screencast& cast )
+{
+	const uint64_t file_size = cast.end - cast.begin;
+	
+	uint64_t offset = sizeof (screencast_header);
+	
+	if ( file_size - offset >= sizeof (index_trailer) )
+	{
+		const index_trailer& trailer = ((const index_trailer*) cast.end)[ -1 ];
+		
+		const uint64_t index_size = trailer.count * sizeof (index_entry)
+		                          + sizeof (index_trailer);
+		
+		if ( trailer.magic == index_magic  &&  index_size <= file_size - offset )
+		{
+			cast.frames_end = cast.end - index_size;
+		}
+	}
+	
+	// Walk the frame headers to count the frames (and index them if needed).
+	
+	const bool indexed = cast.frames_end != cast.end;
+	
+	uint32_t capacity = 0;
+	
+	while ( const uint64_t next = next_frame( cast, offset ) )
+	{
+		const frame_header& frame = header_at( cast, offset );
+		
+		if ( ! indexed  &&  frame.flags & Frame_key )
+		{
+			if ( cast.index_count == capacity )
+			{
+				capacity = capacity ? capacity * 2 : 64;
+				
+				void* index = realloc( cast.index, capacity * sizeof (index_entry) );
+				
+				if ( index == NULL )
+				{
+					return false;
+				}
+				
+				cast.index = (index_entry*) index;
+			}
+			
+			index_entry& entry = cast.index[ cast.index_count++ ];
+			
+			entry.timestamp = frame.timestamp;
+			entry.offset    = offset;
+		}
+		
+		++cast.frame_count;
+		
+		cast.duration = frame.timestamp;
+		
+		offset = next;
+	}
+	
+	if ( indexed )
+	{
+		const index_trailer& trailer = ((const index_trailer*) cast.end)[ -1 ];
+		
+		cast.index_count = trailer.count;
+		
+		const size_t size = cast.index_count * sizeof (index_entry);
+		
+		cast.index = (index_entry*) malloc( size );
+		
+		if ( cast.index == NULL  &&  size != 0 )
+		{
+			return false;
+		}
+		
+		memcpy( cast.index, cast.frames_end, size );
+	}
+	
+	return true;
+}
+
+static
+void open_screencast( const char* path, screencast& cast )
+{
+	int fd = open( path, O_RDONLY );
+	
+	struct stat st;
+	
+	if ( fd < 0  ||  fstat( fd, &st ) < 0 )
+	{
+		report_error( path, errno );
+		exit( 1 );
+	}
+	
+	if ( st.st_size < (off_t) sizeof (screencast_header) )
+	{
+		report_error( path, ENOEXEC );
+		exit( 3 );
+	}
+	
+	void* addr = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	
+	if ( addr == MAP_FAILED )
+	{
+		report_error( path, errno );
+		exit( 1 );
+	}
+	
+	close( fd );
+	
+	memset( &cast, '\0', sizeof cast );
+	
+	cast.begin      = (const uint8_t*) addr;
+	cast.end        = cast.begin + st.st_size;
+	cast.frames_end = cast.end;
+	cast.header     = (const screencast_header*) addr;
+	
+	const screencast_header& header = *cast.header;
+	
+	if ( header.magic      != screencast_magic           ||
+	     header.version    != screencast_version         ||
+	     header.image_size != image_size( header.desc )  ||
+	     header.image_size & 0x1 )
+	{
+		report_error( path, ENOEXEC );
+		exit( 3 );
+	}
+	
+	if ( ! load_index( cast ) )
+	{
+		report_error( path, errno );
+		exit( 1 );
+	}
+}
+
+static
+uint64_t monotonic_microseconds()
+{
+	timespec ts;
+	
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	
+	return ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+}
+
+static
+void sleep_until( uint64_t when )
+{
+	const uint64_t now = monotonic_microseconds();
+	
+	if ( when > now )
+	{
+		const uint64_t delay = when - now;
+		
+		const timespec ts = { time_t( delay / 1000000 ), long( delay % 1000000 * 1000 ) };
+		
+		nanosleep( &ts, NULL );
+	}
+}
+
+/*
+	Apply the frame at `offset` to `image`, unpacking a delta into `delta`
+	first.  Returns the damaged rows as [top, bottom), or false if the
+	frame's packed data is invalid.
+*/
+
+static
+bool apply_frame( const screencast&  cast,
+                  uint64_t           offset,
+                  uint8_t*           image,
+                  uint8_t*           delta,
+                  uint32_t&          top,
+                  uint32_t&          bottom )
+{
+	const frame_header& frame = header_at( cast, offset );
+	
+	const uint8_t* src = (const uint8_t*) &frame + sizeof frame;
+	
+	const long n = cast.header->image_size;
+	
+	if ( damogran::validate( src, src + frame.size, n ) == NULL )
+	{
+		return false;
+	}
+	
+	const uint32_t stride = cast.header->desc.stride;
+	
+	if ( frame.flags & Frame_key )
+	{
+		damogran::unpack( src, image, image + n );
+		
+		top    = 0;
+		bottom = cast.header->desc.height;
+		
+		return true;
+	}
+	
+	damogran::unpack( src, delta, delta + n );
+	
+	long first = -1;
+	long last  = -1;
+	
+	for ( long i = 0;  i < n;  ++i )
+	{
+		if ( const uint8_t c = delta[ i ] )
+		{
+			image[ i ] ^= c;
+			
+			if ( first < 0 )
+			{
+				first = i;
+			}
+			
+			last = i;
+		}
+	}
+	
+	top    = first < 0 ? 0 : first / stride;
+	bottom = first < 0 ? 0 : last  / stride + 1;
+	
+	return true;
+}
+
+static
+void show_frame( const raster::raster_load&  raster,
+                 const uint8_t*              image,
+                 uint32_t                    top,
+                 uint32_t                    bottom )
+{
+	using namespace raster;
+	
+	raster_metadata& meta = *raster.meta;
+	
+	const uint32_t n = image_size( meta.desc );
+	
+	sync_relay& sync = *(sync_relay*) data( find_note( meta, Note_sync ) );
+	
+	raster_note* frames_note = find_note( meta, Note_frames );
+	
+	if ( is_valid_frames( raster, frames_note ) )
+	{
+		frame_buffers& frames = *(frame_buffers*) data( frames_note );
+		
+		const uint32_t back = (front_index( frames ) + 1) % frames.count;
+		
+		memcpy( frame_buffer( raster, back ), image, n );
+		
+		flip( frames, back );
+	}
+	else
+	{
+		memcpy( raster.addr, image, n );
+	}
+	
+	raster_note* sequence = find_note( meta, Note_sequence );
+	
+	frame_sequence* seq = is_valid_sequence( sequence )
+	                    ? (frame_sequence*) data( sequence )
+	                    : NULL;
+	
+	raster_note* damage = find_note( meta, Note_damage );
+	
+	if ( is_valid_damage( damage ) )
+	{
+		const damage_rect rect =
+		{
+			uint16_t( top    ),
+			0,
+			uint16_t( bottom ),
+			uint16_t( meta.desc.stride ),
+		};
+		
+		// Key the damage as readers will see the frame (see sequence.hh).
+		
+		const uint16_t seed = (seq ? seq->frame : sync.seed) + 1;
+		
+		if ( top == bottom )
+		{
+			publish_damage( *(damage_list*) data( damage ), seed, NULL, 0 );
+		}
+		else if ( bottom == meta.desc.height )
+		{
+			publish_damage( *(damage_list*) data( damage ), seed, NULL, damage_overflow );
+		}
+		else
+		{
+			publish_damage( *(damage_list*) data( damage ), seed, &rect, 1 );
+		}
+	}
+	
+	broadcast( sync );
+	
+	if ( seq )
+	{
+		broadcast( *seq );
+	}
+}
+
+int play( char** argv )
+{
+	char* const* args = get_options( argv - 1 );
+	
+	const char* screencast_path = args[ 0 ];
+	const char* raster_path     = screencast_path ? args[ 1 ] : NULL;
+	
+	if ( raster_path == NULL )
+	{
+		WARN( "usage: " PROGRAM " play [--seek=SECONDS] <screencast> <raster>" );
+		return 2;
+	}
+	
+	screencast cast;
+	
+	open_screencast( screencast_path, cast );
+	
+	int fd = open( raster_path, O_RDWR );
+	
+	if ( fd < 0 )
+	{
+		report_error( raster_path, errno );
+		return 1;
+	}
+	
+	using namespace raster;
+	
+	raster_load raster = play_raster( fd );
+	
+	if ( raster.addr == NULL )
+	{
+		report_error( raster_path, errno );
+		return 1;
+	}
+	
+	close( fd );
+	
+	const raster_desc& desc = raster.meta->desc;
+	
+	if ( ! is_valid_sync( find_note( *raster.meta, Note_sync ) ) )
+	{
+		report_error( raster_path, ENOSYS );
+		return 3;
+	}
+	
+	if ( desc.stride != cast.header->desc.stride  ||
+	     desc.height != cast.header->desc.height  ||
+	     desc.weight != cast.header->desc.weight )
+	{
+		WARN( "screencast and raster geometries don't match" );
+		return 3;
+	}
+	
+	if ( cast.index_count == 0 )
+	{
+		return 0;  // no keyframes, so nothing to play
+	}
+	
+	// Start from the last keyframe at or before the seek time.
+	
+	uint32_t k = 0;
+	
+	while ( k + 1 < cast.index_count  &&  cast.index[ k + 1 ].timestamp <= seek_time )
+	{
+		++k;
+	}
+	
+	uint64_t offset = cast.index[ k ].offset;
+	
+	if ( next_frame( cast, offset ) == 0  ||  ! (header_at( cast, offset ).flags & Frame_key) )
+	{
+		WARN( "invalid keyframe index" );
+		return 3;
+	}
+	
+	const uint32_t n = cast.header->image_size;
+	
+	uint8_t* image = (uint8_t*) malloc( n );
+	uint8_t* delta = (uint8_t*) malloc( n );
+	
+	if ( image == NULL  ||  delta == NULL )
+	{
+		report_error( screencast_path, ENOMEM );
+		return 1;
+	}
+	
+	const uint64_t base = monotonic_microseconds();
+	
+	/*
+		Frames before the seek time are applied without being shown, until
+		the last of them (which is the image at the seek time).  Damage
+		accumulates across the unshown frames.
+	*/
+	
+	uint32_t top    = desc.height;
+	uint32_t bottom = 0;
+	
+	while ( const uint64_t next = next_frame( cast, offset ) )
+	{
+		const frame_header& frame = header_at( cast, offset );
+		
+		uint32_t t, b;
+		
+		if ( ! apply_frame( cast, offset, image, delta, t, b ) )
+		{
+			WARN( "invalid frame data" );
+			return 3;
+		}
+		
+		if ( t < b )
+		{
+			top    = t < top    ? t : top;
+			bottom = b > bottom ? b : bottom;
+		}
+		
+		offset = next;
+		
+		if ( next_frame( cast, next )  &&  header_at( cast, next ).timestamp <= seek_time )
+		{
+			continue;
+		}
+		
+		if ( frame.timestamp > seek_time )
+		{
+			sleep_until( base + (frame.timestamp - seek_time) );
+		}
+		
+		show_frame( raster, image, top < bottom ? top : 0, bottom );
+		
+		top    = desc.height;
+		bottom = 0;
+	}
+	
+	free( delta );
+	free( image );
+	free( cast.index );
+	
+	close_raster( raster );
+	
+	return 0;
+}
+
+int info( char** args )
+{
+	while ( const char* path = *args++ )
+	{
+		screencast cast;
+		
+		open_screencast( path, cast );
+		
+		const screencast_header& header = *cast.header;
+		
+		const time_t start = header.start_time / 1000000;
+		
+		char date[ sizeof "YYYY-MM-DD HH:MM:SS" ];
+		
+		strftime( date, sizeof date, "%Y-%m-%d %H:%M:%S", localtime( &start ) );
+		
+		const uint64_t packed = cast.frames_end - cast.begin
+		                      - sizeof header
+		                      - cast.frame_count * sizeof (frame_header);
+		
+		printf( "%s:\n"
+		        "  started:   %s\n"
+		        "  geometry:  %ux%u*%u\n"
+		        "  frames:    %u (%u keyframes)\n"
+		        "  duration:  %u.%.3u s\n"
+		        "  size:      %llu bytes packed, %llu unpacked\n"
+		        "  index:     %s\n",
+		        path,
+		        date,
+		        header.desc.width,
+		        header.desc.height,
+		        header.desc.weight,
+		        cast.frame_count,
+		        cast.index_count,
+		        unsigned( cast.duration / 1000000 ),
+		        unsigned( cast.duration / 1000 % 1000 ),
+		        (unsigned long long) packed,
+		        (unsigned long long) header.image_size * cast.frame_count,
+		        cast.frames_end != cast.end ? "present" : "rebuilt" );
+		
+		free( cast.index );
+		
+		munmap( (void*) cast.begin, cast.end - cast.begin );
+	}
+	
+	return 0;
+}
@@ -0,0 +1,13 @@
+/*
+	play.hh
+	-------
+*/
+
+#ifndef PLAY_HH
+#define PLAY_HH
+
+int play( char** args );
+
+int info( char** args );
+
+#endif
@@ -0,0 +1,454 @@
+/*
+	record.cc
+	---------
+*/
+
+#include "record.hh"
+
+// POSIX
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+// Standard C
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// command
+#include "command/get_option.hh"
+
+// damogran
+#include "damogran/pack.hh"
+
+// gear
+#include "gear/parse_decimal.hh"
+
+// more-posix
+#include "more/perror.hh"
+
+// rasterlib
+#include "raster/frames.hh"
+#include "raster/load.hh"
+#include "raster/relay.hh"
+#include "raster/relay_detail.hh"
+#include "raster/sequence.hh"
+#include "raster/sync.hh"
+
+// screencast
+#include "format.hh"
+
+
+#define PROGRAM  "screencast"
+
+#define STR_LEN( s )  "" s, (sizeof s - 1)
+
+#define WARN( msg )  write( STDERR_FILENO, STR_LEN( PROGRAM ": " msg "\n" ) )
+
+
+enum
+{
+	Opt_keyframes = 'k',
+};
+
+static command::option options[] =
+{
+	{ "keyframes", Opt_keyframes, command::Param_required },
+	{ NULL }
+};
+
+static unsigned keyframe_interval = 300;  // frames
+
+static raster::raster_load loaded_raster;
+
+static raster::sync_relay*     raster_sync;
+static raster::frame_sequence* raster_sequence;
+
+static volatile sig_atomic_t signalled;
+
+
+static
+void report_error( const char* path, int err )
+{
+	more::perror( PROGRAM, path, err );
+}
+
+static
+char* const* get_options( char** argv )
+{
+	int opt;
+	
+	++argv;  // skip arg 0
+	
+	while ( (opt = command::get_option( (char* const**) &argv, options )) > 0 )
+	{
+		using command::global_result;
+		using gear::parse_unsigned_decimal;
+		
+		switch ( opt )
+		{
+			case Opt_keyframes:
+				keyframe_interval = parse_unsigned_decimal( global_result.param );
+				
+				if ( keyframe_interval == 0 )
+				{
+					WARN( "keyframe interval can't be zero" );
+					exit( 2 );
+				}
+				
+				break;
+			
+			default:
+				break;
+		}
+	}
+	
+	return argv;
+}
+
+static
+void open_raster( const char* path )
+{
+	int fd = open( path, O_RDWR );
+	
+	if ( fd < 0 )
+	{
+		report_error( path, errno );
+		exit( 1 );
+	}
+	
+	using namespace raster;
+	
+	loaded_raster = play_raster( fd );
+	
+	if ( loaded_raster.addr == NULL )
+	{
+		report_error( path, errno );
+		exit( 1 );
+	}
+	
+	close( fd );
+	
+	raster_note* sync = find_note( *loaded_raster.meta, Note_sync );
+	
+	if ( ! is_valid_sync( sync ) )
+	{
+		report_error( path, ENOSYS );
+		exit( 3 );
+	}
+	
+	raster_sync = (sync_relay*) data( sync );
+	
+	raster_note* sequence = find_note( *loaded_raster.meta, Note_sequence );
+	
+	if ( is_valid_sequence( sequence ) )
+	{
+		raster_sequence = (frame_sequence*) data( sequence );
+	}
+}
+
+static
+void signal_handler( int )
+{
+	signalled = true;
+	
+	// The waits in wait_for_frame() check the flag; see relay.hh.
+}
+
+static
+uint64_t microseconds( clockid_t clock )
+{
+	timespec ts;
+	
+	clock_gettime( clock, &ts );
+	
+	return ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+}
+
+/*
+	Wait for a frame after the last one, returning false once the relay
+	has ended (or we've been signalled).
+*/
+
+static
+bool wait_for_frame( uint32_t& last )
+{
+	using namespace raster;
+	
+	if ( raster_sequence )
+	{
+		last = wait_past( *raster_sequence, last, signalled );
+	}
+	else
+	{
+		while ( last == raster_sync->seed  &&  raster_sync->status == Sync_ready )
+		{
+			if ( signalled )
+			{
+				return false;
+			}
+			
+			wait( *raster_sync, signalled );
+		}
+		
+		last = raster_sync->seed;
+	}
+	
+	return raster_sync->status == Sync_ready  &&  ! signalled;
+}
+
+class recorder
+{
+	private:
+		int  its_fd;
+		
+		uint64_t  its_offset;
+		uint64_t  its_start;  // monotonic clock
+		
+		uint32_t  its_image_size;
+		uint32_t  its_count;  // frames recorded
+		
+		uint8_t*  its_previous;
+		uint8_t*  its_delta;
+		uint8_t*  its_record;
+		
+		index_entry*  its_index;
+		uint32_t      its_index_count;
+		uint32_t      its_index_capacity;
+		
+		// non-copyable
+		recorder           ( const recorder& );
+		recorder& operator=( const recorder& );
+		
+		bool write_all( const void* data, size_t n );
+		
+		bool add_to_index( uint64_t timestamp );
+	
+	public:
+		recorder( int fd, const raster::raster_desc& desc );
+		
+		~recorder();
+		
+		bool record_frame( const uint8_t* image );
+		
+		bool finish();
+};
+
+recorder::recorder( int fd, const raster::raster_desc& desc )
+:
+	its_fd( fd ),
+	its_offset(),
+	its_start( microseconds( CLOCK_MONOTONIC ) ),
+	its_image_size( raster::image_size( desc ) ),
+	its_count(),
+	its_index(),
+	its_index_count(),
+	its_index_capacity()
+{
+	const size_t n = its_image_size;
+	
+	// At worst, every two source bytes get a two-byte header.
+	
+	const size_t max_packed = 2 * n + 4;
+	
+	its_previous = (uint8_t*) calloc( n, 1 );
+	its_delta    = (uint8_t*) malloc( n );
+	its_record   = (uint8_t*) malloc( sizeof (frame_header) + max_packed );
+	
+	if ( ! its_previous  ||  ! its_delta  ||  ! its_record )
+	{
+		abort();
+	}
+	
+	screencast_header header = {};
+	
+	header.magic      = screencast_magic;
+	header.version    = screencast_version;
+	header.start_time = microseconds( CLOCK_REALTIME );
+	header.image_size = its_image_size;
+	header.desc       = desc;
+	
+	if ( ! write_all( &header, sizeof header ) )
+	{
+		report_error( "write", errno );
+		exit( 1 );
+	}
+}
+
+recorder::~recorder()
+{
+	free( its_index    );
+	free( its_record   );
+	free( its_delta    );
+	free( its_previous );
+}
+
+bool recorder::write_all( const void* data, size_t n )
+{
+	const char* p = (const char*) data;
+	
+	while ( n > 0 )
+	{
+		ssize_t n_written = write( its_fd, p, n );
+		
+		if ( n_written < 0 )
+		{
+			if ( errno == EINTR )
+			{
+				continue;
+			}
+			
+			return false;
+		}
+		
+		p += n_written;
+		n -= n_written;
+		
+		its_offset += n_written;
+	}
+	
+	return true;
+}
+
+bool recorder::add_to_index( uint64_t timestamp )
+{
+	if ( its_index_count == its_index_capacity )
+	{
+		const uint32_t capacity = its_index_capacity ? its_index_capacity * 2 : 64;
+		
+		void* index = realloc( its_index, capacity * sizeof (index_entry) );
+		
+		if ( index == NULL )
+		{
+			return false;
+		}
+		
+		its_index          = (index_entry*) index;
+		its_index_capacity = capacity;
+	}
+	
+	index_entry& entry = its_index[ its_index_count++ ];
+	
+	entry.timestamp = timestamp;
+	entry.offset    = its_offset;
+	
+	return true;
+}
+
+bool recorder::record_frame( const uint8_t* image )
+{
+	const size_t n = its_image_size;
+	
+	const bool key = its_count++ % keyframe_interval == 0;
+	
+	/*
+		Copy the image first, so the delta and the next frame's reference
+		agree even if the image changes while we're reading it.
+	*/
+	
+	memcpy( its_delta, image, n );
+	
+	for ( size_t i = 0;  i < n;  ++i )
+	{
+		const uint8_t c = its_delta[ i ];
+		
+		its_delta[ i ] = key ? c : c ^ its_previous[ i ];
+		
+		its_previous[ i ] = c;
+	}
+	
+	frame_header& header = *(frame_header*) its_record;
+	
+	uint8_t* packed = its_record + sizeof header;
+	uint8_t* end    = damogran::pack( its_delta, its_delta + n, packed );
+	
+	if ( (end - packed) & 0x2 )
+	{
+		*end++ = 0x00;  // no-op, for alignment
+		*end++ = 0x00;
+	}
+	
+	header.timestamp = microseconds( CLOCK_MONOTONIC ) - its_start;
+	header.size      = end - packed;
+	header.flags     = key ? Frame_key : 0;
+	
+	if ( key  &&  ! add_to_index( header.timestamp ) )
+	{
+		return false;
+	}
+	
+	return write_all( its_record, end - its_record );
+}
+
+bool recorder::finish()
+{
+	const index_trailer trailer = { its_index_count, index_magic };
+	
+	return write_all( its_index, its_index_count * sizeof (index_entry) )  &&
+	       write_all( &trailer, sizeof trailer );
+}
+
+int record( char** argv )
+{
+	char* const* args = get_options( argv - 1 );
+	
+	const char* raster_path = args[ 0 ];
+	const char* output_path = raster_path ? args[ 1 ] : NULL;
+	
+	if ( output_path == NULL )
+	{
+		WARN( "usage: " PROGRAM " record [--keyframes=N] <raster> <screencast>" );
+		return 2;
+	}
+	
+	open_raster( raster_path );
+	
+	const raster::raster_desc& desc = loaded_raster.meta->desc;
+	
+	if ( raster::image_size( desc ) & 0x1 )
+	{
+		WARN( "Damogran requires an even image size" );
+		return 3;
+	}
+	
+	int fd = open( output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+	
+	if ( fd < 0 )
+	{
+		report_error( output_path, errno );
+		return 1;
+	}
+	
+	signal( SIGINT,  &signal_handler );
+	signal( SIGTERM, &signal_handler );
+	
+	recorder rec( fd, desc );
+	
+	// Record the current image first, then each new frame.
+	
+	uint32_t last = raster_sequence ? raster_sequence->frame
+	                                : raster_sync->seed;
+	
+	bool ok = true;
+	
+	do
+	{
+		const uint8_t* image = (const uint8_t*) front_buffer( loaded_raster );
+		
+		ok = rec.record_frame( image );
+	}
+	while ( ok  &&  wait_for_frame( last ) );
+	
+	ok = ok  &&  rec.finish();
+	
+	if ( ! ok )
+	{
+		report_error( output_path, errno );
+	}
+	
+	close( fd );
+	
+	return ! ok;
+}
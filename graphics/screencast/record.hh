@@ -0,0 +1,11 @@
+/*
+	record.hh
+	---------
+*/
+
+#ifndef RECORD_HH
+#define RECORD_HH
+
+int record( char** args );
+
+#endif
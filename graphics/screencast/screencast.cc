@@ -0,0 +1,59 @@
+/*
+	screencast.cc
+	-------------
+*/
+
+// POSIX
+#include <unistd.h>
+
+// Standard C
+#include <string.h>
+
+// screencast
+#include "play.hh"
+#include "record.hh"
+
+
+#define PROGRAM  "screencast"
+
+#define STR_LEN( s )  "" s, (sizeof s - 1)
+
+#define WARN( msg )  write( STDERR_FILENO, STR_LEN( PROGRAM ": " msg "\n" ) )
+
+
+int main( int argc, char** argv )
+{
+	if ( argc == 0 )
+	{
+		return 0;
+	}
+	
+	char** args = argv + 1;
+	
+	if ( *args == NULL )
+	{
+		WARN( "usage: " PROGRAM " (record|play|info) ..." );
+		return 2;
+	}
+	
+	const char* subcommand = *args++;
+	
+	if ( strcmp( subcommand, "info" ) == 0 )
+	{
+		return info( args );
+	}
+	
+	if ( strcmp( subcommand, "record" ) == 0 )
+	{
+		return record( args );
+	}
+	
+	if ( strcmp( subcommand, "play" ) == 0 )
+	{
+		return play( args );
+	}
+	
+	WARN( "unknown subcommand" );
+	
+	return 2;
+}
@@ -0,0 +1,172 @@
+/*
+	transcode-bench.cc
+	------------------
+*/
+
+// POSIX
+#include <time.h>
+
+// Standard C
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// rasterlib
+#include "raster/transcode.hh"
+
+
+#define PROGRAM  "transcode-bench"
+
+/*
+	Transcode a 512x342 image repeatedly for about a quarter of a second
+	with each path available, for each pair of source and destination
+	weights, and report the rate in megapixels per second.  Each path's
+	output is checked against the portable path's.
+*/
+
+const int width  = 512;
+const int height = 342;
+
+const double min_seconds = 0.25;
+
+static const int src_weights[] = { 1, 2, 4, 8 };
+static const int dst_weights[] = { 16, 32 };
+
+static raster::transcoder the_transcoder;
+
+static uint8_t src_image[ width * height ];
+static uint8_t dst_image[ width * height * 4 ];
+static uint8_t dst_check[ width * height * 4 ];
+
+
+static
+double now()
+{
+	timespec ts;
+	
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static
+void transcode_image( const raster::transcoder& t, uint8_t* dst )
+{
+	const size_t src_stride = width * t.src_weight / 8;
+	const size_t dst_stride = width * t.dst_weight / 8;
+	
+	const uint8_t* src = src_image;
+	
+	for ( int y = 0;  y < height;  ++y )
+	{
+		transcode( t, src, dst, width );
+		
+		src += src_stride;
+		dst += dst_stride;
+	}
+}
+
+static
+double megapixels_per_second( const raster::transcoder& t )
+{
+	const double start = now();
+	
+	double elapsed;
+	
+	int n = 0;
+	
+	do
+	{
+		transcode_image( t, dst_image );
+		
+		++n;
+	}
+	while ( (elapsed = now() - start) < min_seconds );
+	
+	return n * (width * height / 1e6) / elapsed;
+}
+
+int main( int argc, char** argv )
+{
+	using namespace raster;
+	
+	srand( 1 );
+	
+	for ( size_t i = 0;  i < sizeof src_image;  ++i )
+	{
+		src_image[ i ] = rand();
+	}
+	
+	uint32_t clut[ 256 ];
+	
+	for ( int i = 0;  i < 256;  ++i )
+	{
+		clut[ i ] = rand() & 0xFFFFFF;
+	}
+	
+	int mismatches = 0;
+	
+	printf( "%-10s", "" );
+	
+	for ( int p = 0;  p < Path_end_of_enumeration;  ++p )
+	{
+		printf( "%10s", transcode_path_name( transcode_path( p ) ) );
+	}
+	
+	printf( "    (megapixels/s)\n" );
+	
+	for ( size_t i = 0;  i < sizeof src_weights / sizeof *src_weights;  ++i )
+	{
+		for ( size_t j = 0;  j < sizeof dst_weights / sizeof *dst_weights;  ++j )
+		{
+			const int src_weight = src_weights[ i ];
+			const int dst_weight = dst_weights[ j ];
+			
+			char label[ 16 ];
+			
+			sprintf( label, "%d -> %d", src_weight, dst_weight );
+			
+			printf( "%-10s", label );
+			
+			transcoder& t = the_transcoder;
+			
+			set_up_transcoder( t, src_weight, dst_weight, clut, Path_portable );
+			
+			transcode_image( t, dst_check );
+			
+			const size_t size = width * height * dst_weight / 8;
+			
+			for ( int p = 0;  p < Path_end_of_enumeration;  ++p )
+			{
+				const transcode_path path = transcode_path( p );
+				
+				set_up_transcoder( t, src_weight, dst_weight, clut, path );
+				
+				if ( t.path != path )
+				{
+					printf( "%10s", "-" );
+					continue;
+				}
+				
+				memset( dst_image, '\0', size );
+				
+				transcode_image( t, dst_image );
+				
+				if ( memcmp( dst_image, dst_check, size ) != 0 )
+				{
+					++mismatches;
+					
+					printf( "%10s", "MISMATCH" );
+					continue;
+				}
+				
+				printf( "%10.0f", megapixels_per_second( t ) );
+			}
+			
+			printf( "\n" );
+		}
+	}
+	
+	return mismatches != 0;
+}
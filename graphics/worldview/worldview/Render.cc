@@ -30,6 +30,7 @@
 #include "worldview/Model.hh"
 #include "worldview/Objects.hh"
 #include "worldview/Port.hh"
+#include "worldview/Workers.hh"
 
 
 namespace worldview
@@ -84,7 +85,98 @@ namespace worldview
 	
 	typedef Portage::DepthBuffer< float > DeepPixelDevice;
 	
-	static DeepPixelDevice gDeepPixelDevice;
+	/*
+		The viewport is divided into tiles, each with its own depth buffer.
+		Each frame, every polygon is set up once and binned to the tiles its
+		bounds overlap, and then the tiles are rasterized independently (on
+		worker threads).  A tile draws its polygons in their original order,
+		and only the pixels within it, so the output is identical to drawing
+		each polygon across the whole viewport in turn.
+	*/
+	
+	const int kTileSize = 64;
+	
+	class Tile
+	{
+		public:
+			int left, top, right, bottom;
+			
+			DeepPixelDevice  itsDepthBuffer;
+			
+			std::vector< std::size_t >  itsPolygons;  // binned, in order
+			
+			void ResetDepthBuffer()
+			{
+				itsDepthBuffer.Resize( right - left, bottom - top );
+			}
+			
+			bool Nearer( int x, int y, float z )
+			{
+				return itsDepthBuffer.Nearer( x - left, y - top, z );
+			}
+			
+			void Set( int x, int y, float z )
+			{
+				itsDepthBuffer.Set( x - left, y - top, z );
+			}
+			
+			bool SetIfNearer( int x, int y, float z )
+			{
+				return itsDepthBuffer.SetIfNearer( x - left, y - top, z );
+			}
+	};
+	
+	static std::vector< Tile > gTiles;
+	
+	static
+	void SetUpTiles( size_t width, size_t height )
+	{
+		const int h_tiles = (width  + kTileSize - 1) / kTileSize;
+		const int v_tiles = (height + kTileSize - 1) / kTileSize;
+		
+		gTiles.resize( h_tiles * v_tiles );
+		
+		for ( int v = 0;  v < v_tiles;  ++v )
+		{
+			for ( int h = 0;  h < h_tiles;  ++h )
+			{
+				Tile& tile = gTiles[ v * h_tiles + h ];
+				
+				tile.left   = h * kTileSize;
+				tile.top    = v * kTileSize;
+				tile.right  = std::min< int >( tile.left + kTileSize, width  );
+				tile.bottom = std::min< int >( tile.top  + kTileSize, height );
+				
+				tile.itsPolygons.clear();
+			}
+		}
+	}
+	
+	/*
+		Add polygon i to the bin of each tile that overlaps the pixels in
+		[left, right) x [top, bottom).
+	*/
+	
+	static
+	void BinPolygon( std::size_t i, int left, int top, int right, int bottom, size_t width )
+	{
+		const int h_tiles = (width + kTileSize - 1) / kTileSize;
+		const int v_tiles = gTiles.size() / h_tiles;
+		
+		const int h_begin = std::max( left, 0 ) / kTileSize;
+		const int v_begin = std::max( top,  0 ) / kTileSize;
+		
+		const int h_end = std::min( (right  + kTileSize - 1) / kTileSize, h_tiles );
+		const int v_end = std::min( (bottom + kTileSize - 1) / kTileSize, v_tiles );
+		
+		for ( int v = v_begin;  v < v_end;  ++v )
+		{
+			for ( int h = h_begin;  h < h_end;  ++h )
+			{
+				gTiles[ v * h_tiles + h ].itsPolygons.push_back( i );
+			}
+		}
+	}
 	
 	
 	static const V::Radians sHorizontalFieldOfViewAngle = V::Degrees( 45 );
@@ -204,14 +296,17 @@ namespace worldview
 	template < class DoubleSpectrum,
 	           class ColorSpectrum >
 	static
-	void DrawDeepScanLine( int                    y,
+	void DrawDeepScanLine( Tile&                  tile,
+	                       int                    y,
 	                       double                 left,
 	                       double                 right,
 	                       const DoubleSpectrum&  w_spectrum,
 	                       const ColorSpectrum&   colors,
 	                       uint8_t*               rowAddr )
 	{
-		for ( int x = int( std::ceil( left ) );  x < right;  ++x )
+		const int begin = std::max( int( std::ceil( left ) ), tile.left );
+		
+		for ( int x = begin;  x < right  &&  x < tile.right;  ++x )
 		{
 			double tX = (x - left) / (right - left);
 			
@@ -219,7 +314,7 @@ namespace worldview
 			
 			double z = -1.0 / w;
 			
-			if ( gDeepPixelDevice.SetIfNearer( x, y, -z ) )
+			if ( tile.SetIfNearer( x, y, -z ) )
 			{
 				uint8_t* pixelAddr = rowAddr + x * 32/8;
 				
@@ -238,7 +333,8 @@ namespace worldview
 	           class ColorSpectrum,
 	           class UVSpectrum >
 	static
-	void DrawDeepScanLine( int                    y,
+	void DrawDeepScanLine( Tile&                  tile,
+	                       int                    y,
 	                       double                 left,
 	                       double                 right,
 	                       const DoubleSpectrum&  w_spectrum,
@@ -247,7 +343,9 @@ namespace worldview
 	                       const MeshPolygon&     polygon,
 	                       uint8_t*               rowAddr )
 	{
-		for ( int x = int( std::ceil( left ) );  x < right;  ++x )
+		const int begin = std::max( int( std::ceil( left ) ), tile.left );
+		
+		for ( int x = begin;  x < right  &&  x < tile.right;  ++x )
 		{
 			double tX = (x - left) / (right - left);
 			
@@ -255,7 +353,7 @@ namespace worldview
 			
 			double z = -1.0 / w;
 			
-			if ( gDeepPixelDevice.SetIfNearer( x, y, -z ) )
+			if ( tile.SetIfNearer( x, y, -z ) )
 			{
 				uint8_t* pixelAddr = rowAddr + x * 32/8;
 				
@@ -292,7 +390,8 @@ namespace worldview
 	
 	template < class Vertex >
 	static
-	void DrawDeepTrapezoid( const Vertex&  topLeft,
+	void DrawDeepTrapezoid( Tile&          tile,
+	                        const Vertex&  topLeft,
 	                        const Vertex&  topRight,
 	                        const Vertex&  bottomLeft,
 	                        const Vertex&  bottomRight,
@@ -318,6 +417,9 @@ namespace worldview
 		pin_to_minimum( start, 0            );
 		pin_to_maximum( stop,  (int) height );  // unsigned comparison == death
 		
+		pin_to_minimum( start, tile.top    );
+		pin_to_maximum( stop,  tile.bottom );
+		
 		for ( int y = start;  y < stop;  ++y )
 		{
 			uint8_t* rowAddr = base + y * stride;
@@ -342,7 +444,8 @@ namespace worldview
 			
 			if ( !using_texture_map )
 			{
-				DrawDeepScanLine( y,
+				DrawDeepScanLine( tile,
+				                  y,
 				                  left,
 				                  right,
 				                  w_spectrum,
@@ -357,7 +460,8 @@ namespace worldview
 				V::Point2D::Type rightUV_W = MakeLinearSpectrum( topRight.itsTexturePoint    * topRight   [ W ],
 				                                                 bottomRight.itsTexturePoint * bottomRight[ W ] )[ tY ];
 				
-				DrawDeepScanLine( y,
+				DrawDeepScanLine( tile,
+				                  y,
 				                  left,
 				                  right,
 				                  w_spectrum,
@@ -446,6 +550,14 @@ namespace worldview
 		return a[ Y ] > b[ Y ];
 	}
 	
+	static
+	void SortVertically( std::vector< DeepVertex >& vertices )
+	{
+		std::sort( vertices.begin(),
+		           vertices.end(),
+		           std::ptr_fun( VerticallyGreater ) );
+	}
+	
 	static
 	void AdvanceVertexIterator( std::vector< DeepVertex >::const_iterator&  it,
 	                            unsigned                                    top_index,
@@ -483,20 +595,18 @@ namespace worldview
 		return result;
 	}
 	
+	/*
+		The vertices must already be sorted by Y (see SortVertically()).
+	*/
+	
 	static
-	void DrawDeepPolygon( std::vector< DeepVertex >  vertices,
-	                      void*                      dst,
-	                      size_t                     height,
-	                      size_t                     width,
-	                      size_t                     stride )
+	void DrawDeepPolygon( Tile&                             tile,
+	                      const std::vector< DeepVertex >&  sorted_vertices,
+	                      void*                             dst,
+	                      size_t                            height,
+	                      size_t                            width,
+	                      size_t                            stride )
 	{
-		std::vector< DeepVertex >& sorted_vertices = vertices;
-		
-		// sort by Y
-		std::sort( sorted_vertices.begin(),
-		           sorted_vertices.end(),
-		           std::ptr_fun( VerticallyGreater ) );
-		
 		double top    = sorted_vertices.front()[ Y ];
 		double bottom = sorted_vertices.back ()[ Y ];
 		
@@ -529,7 +639,8 @@ namespace worldview
 				
 				DeepVertex interpolated = InterpolateDeepVertex( *prev_right_it, *right_it, t );
 				
-				DrawDeepTrapezoid( prev_left,
+				DrawDeepTrapezoid( tile,
+				                   prev_left,
 				                   prev_right,
 				                   *left_it,
 				                   interpolated,
@@ -551,7 +662,8 @@ namespace worldview
 				
 				DeepVertex interpolated = InterpolateDeepVertex( *prev_left_it, *left_it, t );
 				
-				DrawDeepTrapezoid( prev_left,
+				DrawDeepTrapezoid( tile,
+				                   prev_left,
 				                   prev_right,
 				                   interpolated,
 				                   *right_it,
@@ -567,7 +679,8 @@ namespace worldview
 			}
 		}
 		
-		DrawDeepTrapezoid( prev_left,
+		DrawDeepTrapezoid( tile,
+		                   prev_left,
 		                   prev_right,
 		                   sorted_vertices.back(),
 		                   sorted_vertices.back(),
@@ -613,6 +726,25 @@ namespace worldview
 	}
 	*/
 	
+	/*
+		Looks up points by offset, like PointMesh itself, but without copying
+		the mesh into std::transform() for every polygon.
+	*/
+	
+	class MeshLookup
+	{
+		private:
+			const PointMesh& itsMesh;
+		
+		public:
+			MeshLookup( const PointMesh& mesh ) : itsMesh( mesh )  {}
+			
+			const V::Point3D::Type& operator()( std::size_t offset ) const
+			{
+				return itsMesh( offset );
+			}
+	};
+	
 	static inline
 	V::Point3D::Type PerspectiveDivision( const V::Point3D::Type& pt )
 	{
@@ -721,6 +853,38 @@ namespace worldview
 		return DotProduct( a, b );
 	}
 	
+	struct PaintJob
+	{
+		const std::vector< std::vector< DeepVertex > >*  polygons;
+		
+		void*   dst;
+		size_t  width;
+		size_t  height;
+		size_t  stride;
+	};
+	
+	static
+	void PaintTile( void* context, size_t index )
+	{
+		const PaintJob& job = *(const PaintJob*) context;
+		
+		Tile& tile = gTiles[ index ];
+		
+		tile.ResetDepthBuffer();
+		
+		typedef std::vector< std::size_t >::const_iterator Iter;
+		
+		for ( Iter it = tile.itsPolygons.begin();  it != tile.itsPolygons.end();  ++it )
+		{
+			DrawDeepPolygon( tile,
+			                 (*job.polygons)[ *it ],
+			                 job.dst,
+			                 job.height,
+			                 job.width,
+			                 job.stride );
+		}
+	}
+	
 	void paint_onto_surface( const MeshModel*  begin,
 	                         const MeshModel*  end,
 	                         void*             dst,
@@ -728,11 +892,11 @@ namespace worldview
 	                         size_t            height,
 	                         size_t            stride )
 	{
-		uint8_t* base = (uint8_t*) dst;
-		
 		//fishEye = itsPort.mCamera.fishEyeMode;
 		
-		gDeepPixelDevice.Resize( width, height );
+		SetUpTiles( width, height );
+		
+		std::vector< std::vector< DeepVertex > > deep_polygons;
 		
 		const V::Point3D::Type pt0 = V::Point3D::Make( 0, 0, 0 );
 		
@@ -779,7 +943,7 @@ namespace worldview
 				std::transform( offsets.begin(),
 				                offsets.end(),
 				                points.begin(),
-				                mesh );
+				                MeshLookup( mesh ) );
 				
 				V::Vector3D::Type faceNormal = V::UnitLength( V::FaceNormal( points ) );
 				
@@ -831,13 +995,41 @@ namespace worldview
 					}
 				}
 				
-				DrawDeepPolygon( vertices,
-				                 base,
-				                 height,
-				                 width,
-				                 stride );
+				SortVertically( vertices );
+				
+				double top    = vertices.front()[ Y ] * width / -2.0 + height / 2.0;
+				double bottom = vertices.back ()[ Y ] * width / -2.0 + height / 2.0;
+				
+				double left  = vertices[ 0 ][ X ];
+				double right = vertices[ 0 ][ X ];
+				
+				for ( unsigned int i = 1;  i < vertices.size();  ++i )
+				{
+					pin_to_maximum( left,  vertices[ i ][ X ] );
+					pin_to_minimum( right, vertices[ i ][ X ] );
+				}
+				
+				left  = left  * width / 2.0 + width / 2.0;
+				right = right * width / 2.0 + width / 2.0;
+				
+				// Allow a pixel's margin for rounding.
+				
+				BinPolygon( deep_polygons.size(),
+				            int( std::floor( left  ) ) - 1,
+				            int( std::floor( top   ) ) - 1,
+				            int( std::ceil ( right  ) ) + 1,
+				            int( std::ceil ( bottom ) ) + 1,
+				            width );
+				
+				deep_polygons.push_back( std::vector< DeepVertex >() );
+				
+				deep_polygons.back().swap( vertices );
 			}
 		}
+		
+		PaintJob job = { &deep_polygons, dst, width, height, stride };
+		
+		run_workers( &PaintTile, &job, gTiles.size() );
 	}
 	
 	MeshModel* hit_test( Frame& frame, double x, double y )
@@ -852,6 +1044,158 @@ namespace worldview
 		return frame.HitTest( pt1 );
 	}
 	
+	struct TracePolygon
+	{
+		const MeshPolygon*  polygon;
+		bool                selected;
+		
+		V::Point3D::Type    savedPoints[ 3 ];
+		V::Vector3D::Type   faceNormal;
+		V::Plane3D::Type    plane;
+		V::Polygon2D        poly2d;
+		
+		/*
+			Rows and columns to trace, compared as unsigned (so a negative
+			top or right skips the polygon).
+		*/
+		
+		V::Rect2D< int >    rect;
+	};
+	
+	struct TraceJob
+	{
+		const std::vector< TracePolygon >*  polygons;
+		
+		void*   dst;
+		size_t  width;
+		size_t  height;
+		size_t  stride;
+	};
+	
+	static
+	void TracePolygonInTile( Tile&                tile,
+	                         const TracePolygon&  trace,
+	                         void*                dst,
+	                         size_t               width,
+	                         size_t               height,
+	                         size_t               stride )
+	{
+		const V::Point3D::Type pt0 = V::Point3D::Make( 0, 0, 0 );
+		
+		const MeshPolygon& polygon = *trace.polygon;
+		
+		const ImageTile& tile_map = polygon.Tile();
+		
+		const V::Point3D::Type*  savedPoints = trace.savedPoints;
+		const V::Vector3D::Type& faceNormal  = trace.faceNormal;
+		const V::Plane3D::Type&  plane       = trace.plane;
+		const V::Polygon2D&      poly2d      = trace.poly2d;
+		const V::Rect2D< int >&  rect        = trace.rect;
+		
+		const unsigned top    = std::max< unsigned >( rect.top,    tile.top    );
+		const unsigned bottom = std::min< unsigned >( rect.bottom, tile.bottom );
+		const unsigned left   = std::max< unsigned >( rect.left,   tile.left   );
+		const unsigned right  = std::min< unsigned >( rect.right,  tile.right  );
+		
+		V::Point3D::Type current_pixel_3d;
+		V::Point2D::Type current_pixel_2d;
+		
+		current_pixel_3d[ Z ] = -sFocalLength;
+		current_pixel_3d[ W ] =  1.0;
+		current_pixel_2d[ W ] =  1.0;
+		
+		// For each row
+		for ( unsigned iY = top;  iY < bottom;  ++iY )
+		{
+			//escapement();
+			
+			current_pixel_3d[ Y ] =
+			current_pixel_2d[ Y ] = (iY + 0.5 - height / 2.0) / (width / -2.0);
+			
+			uint8_t* rowAddr = (uint8_t*) dst + iY * stride;
+			
+			// For each pixel in the row
+			for ( unsigned iX = left;  iX < right;  ++iX )
+			{
+				current_pixel_3d[ X ] =
+				current_pixel_2d[ X ] = (iX + 0.5 - width / 2.0) / (width / 2.0);
+				
+				const V::Point3D::Type& pt1 = current_pixel_3d;
+				
+				if ( fishEye )
+				{
+				//	pt1 = UnFishEye(pt1);
+				}
+				
+				// The ray is inverted to face the same way as the face normal.
+				V::Vector3D::Type ray = pt0 - pt1;
+				
+				V::Point3D::Type sectPt = LinePlaneIntersection( ray, pt0, plane );
+				
+				double dist = V::Magnitude( sectPt - pt0 );
+				
+				if (    dist > 0
+				     && tile.Nearer( iX, iY, dist )
+				     && poly2d.ContainsPoint( current_pixel_2d ) )
+				{
+					// set the pixel, below
+				}
+				else
+				{
+					continue;
+				}
+				
+				tile.Set( iX, iY, dist );
+				
+				// P . Q = mag(P) * mag(Q) * cos(a)
+				// cos(a) = P.Q / mag(P) / mag(Q)
+				// The normal is already unit length, so its magnitude is 1.
+				/*
+				double cosTheta = DotProduct( ray, faceNormal )
+					/ Magnitude( ray ) / Magnitude( faceNormal );
+				*/
+				double cosAlpha = ray * faceNormal / V::Magnitude( ray );
+				double incidenceRatio = cosAlpha;
+				
+				ColorMatrix lightColor = LightColor( dist, incidenceRatio, trace.selected );
+				
+				ColorMatrix sample = tile_map.Empty() ? polygon.Color()
+				                                      : GetSampleFromMap( tile_map,
+				                                                          InterpolatedUV( sectPt,
+				                                                                          savedPoints,
+				                                                                          polygon.MapPoints() ) );
+				
+				ColorMatrix tweaked = ModulateColor( sample, lightColor );
+				
+				uint8_t* pixelAddr = rowAddr + iX * 32/8;
+				
+				inscribe_argb_pixel( pixelAddr, tweaked );
+			}
+		}
+	}
+	
+	static
+	void TraceTile( void* context, size_t index )
+	{
+		const TraceJob& job = *(const TraceJob*) context;
+		
+		Tile& tile = gTiles[ index ];
+		
+		tile.ResetDepthBuffer();
+		
+		typedef std::vector< std::size_t >::const_iterator Iter;
+		
+		for ( Iter it = tile.itsPolygons.begin();  it != tile.itsPolygons.end();  ++it )
+		{
+			TracePolygonInTile( tile,
+			                    (*job.polygons)[ *it ],
+			                    job.dst,
+			                    job.width,
+			                    job.height,
+			                    job.stride );
+		}
+	}
+	
 	void trace_onto_surface( const MeshModel*  begin,
 	                         const MeshModel*  end,
 	                         void*             dst,
@@ -859,200 +1203,129 @@ namespace worldview
 	                         size_t            height,
 	                         size_t            stride )
 	{
-		//DeepPixelDevice device( width, height );
-		gDeepPixelDevice.Resize( width, height );
+		SetUpTiles( width, height );
 		
-		// Always 1, but could be altered to make multiple passes with a smaller depth buffer
-		unsigned hPasses = (width - 1) / width + 1;
-		unsigned vPasses = (height - 1) / height + 1;
+		std::vector< TracePolygon > traces;
 		
-		const V::Point3D::Type pt0 = V::Point3D::Make( 0, 0, 0 );
+		V::Rect2D< int > depthRect;
+		
+		depthRect.left   = 0;
+		depthRect.right  = width;
+		depthRect.bottom = 0;
+		depthRect.top    = height;
 		
-		// For each vertical pass
-		for ( unsigned vp = 0;  vp < vPasses;  ++vp )
+		// For each mesh model...
+		for ( const MeshModel* it = begin;  it != end;  ++it )
 		{
-			// For each horizontal pass
-			for ( unsigned hp = 0;  hp < hPasses;  ++hp )
+			const MeshModel& model = *it;
+			
+			bool selected = model.Selected();
+			
+			const PointMesh& mesh = model.Mesh();
+			
+			// Sanity check:  Must have some points to work with.
+			if ( mesh.Empty() )  continue;
+			
+			// Fish-eye view distortion
+			if ( fishEye )
+			{
+			//	transform(points.begin(), points.end(), points.begin(), FishEye);
+			}
+			
+			const std::vector< MeshPolygon >& polygons = model.Polygons();
+			
+			typedef std::vector< MeshPolygon >::const_iterator PolygonIter;
+			
+			// For each polygon in the mesh...
+			for ( PolygonIter it = polygons.begin(), end = polygons.end();  it != end;  ++it )
 			{
-				gDeepPixelDevice.Reset();
-				V::Rect2D< int > depthRect;
+				const MeshPolygon& polygon = *it;
+				
+				const std::vector< unsigned >& offsets = polygon.Vertices();
 				
-				depthRect.left   = hp * width;
-				depthRect.right  = (hp + 1) * width;
-				depthRect.bottom = vp * height;
-				depthRect.top    = (vp + 1) * height;
+				unsigned const *const savedOffsets = polygon.SavedOffsets();
 				
-				// For each mesh model...
-				for ( const MeshModel* it = begin;  it != end;  ++it )
+				if ( offsets.empty() )
 				{
-					const MeshModel& model = *it;
-					
-					bool selected = model.Selected();
-					
-					const PointMesh& mesh = model.Mesh();
-					
-					// Sanity check:  Must have some points to work with.
-					if ( mesh.Empty() )  continue;
-					
-					// Fish-eye view distortion
-					if ( fishEye )
-					{
-					//	transform(points.begin(), points.end(), points.begin(), FishEye);
-					}
-					
-					const std::vector< MeshPolygon >& polygons = model.Polygons();
-					
-					typedef std::vector< MeshPolygon >::const_iterator PolygonIter;
-					
-					// For each polygon in the mesh...
-					for ( PolygonIter it = polygons.begin(), end = polygons.end();  it != end;  ++it )
-					{
-						const MeshPolygon& polygon = *it;
-						
-						const std::vector< unsigned >& offsets = polygon.Vertices();
-						
-						unsigned const *const savedOffsets = polygon.SavedOffsets();
-						
-						if ( offsets.empty() )
-						{
-							continue;
-						}
-						
-						const ImageTile& tile = polygon.Tile();
-						
-						V::Point3D::Type savedPoints[3];
-						
-						savedPoints[0] = mesh.Points()[ savedOffsets[ 0 ] ];
-						savedPoints[1] = mesh.Points()[ savedOffsets[ 1 ] ];
-						savedPoints[2] = mesh.Points()[ savedOffsets[ 2 ] ];
-						
-						std::vector< V::Point3D::Type > points( offsets.size() );
-						
-						// Lookup the vertices of this polygon
-						// in port coordinates
-						std::transform( offsets.begin(),
-						                offsets.end(),
-						                points.begin(),
-						                mesh );
-						
-						V::Vector3D::Type faceNormal = V::UnitLength( V::FaceNormal( points ) );
-						
-						V::Plane3D::Type plane = V::PlaneVector( faceNormal, points[ 0 ] );
-						
-						// Perspective division
-						std::transform( points.begin(),
-						                points.end(),
-						                points.begin(),
-						                std::ptr_fun( PerspectiveDivision ) );
-						
-						V::Polygon2D poly2d;
-						
-						std::vector< V::Point2D::Type >& screenPts( poly2d.Points() );
-						
-						screenPts.resize( points.size() );
-						
-						std::transform( points.begin(),
-						                points.end(),
-						                screenPts.begin(),
-						                std::ptr_fun( Point3DTo2D ) );
-						
-						V::Rect2D< double > bounding_rect = poly2d.BoundingRect();
-						
-						bounding_rect.left  = bounding_rect.left  * width / 2.0 + width / 2.0;
-						bounding_rect.right = bounding_rect.right * width / 2.0 + width / 2.0;
-						
-						bounding_rect.top    = bounding_rect.top    * width / -2.0 + height / 2.0;
-						bounding_rect.bottom = bounding_rect.bottom * width / -2.0 + height / 2.0;
-						
-						V::Rect2D< int > bounds;
-						bounds = bounding_rect;
-						
-						// Extend the rect to account for truncation error
-						bounds.right  += 1;
-						bounds.bottom += 1;
-						
-						// Intersect the polygon bounds with the depth buffer bounds
-						V::Rect2D< int > rect = depthRect * bounds;
-						
-						V::Point3D::Type current_pixel_3d;
-						V::Point2D::Type current_pixel_2d;
-						
-						current_pixel_3d[ Z ] = -sFocalLength;
-						current_pixel_3d[ W ] =  1.0;
-						current_pixel_2d[ W ] =  1.0;
-						
-						// For each row
-						for ( unsigned iY = rect.top;  iY < rect.bottom;  ++iY )
-						{
-							//escapement();
-							
-							current_pixel_3d[ Y ] =
-							current_pixel_2d[ Y ] = (iY + 0.5 - height / 2.0) / (width / -2.0);
-							
-							uint8_t* rowAddr = (uint8_t*) dst + iY * stride;
-							
-							// For each pixel in the row
-							for ( unsigned iX = rect.left;  iX < rect.right;  ++iX )
-							{
-								current_pixel_3d[ X ] =
-								current_pixel_2d[ X ] = (iX + 0.5 - width / 2.0) / (width / 2.0);
-								
-								const V::Point3D::Type& pt1 = current_pixel_3d;
-								
-								if ( fishEye )
-								{
-								//	pt1 = UnFishEye(pt1);
-								}
-								
-								// The ray is inverted to face the same way as the face normal.
-								V::Vector3D::Type ray = pt0 - pt1;
-								
-								V::Point3D::Type sectPt = LinePlaneIntersection( ray, pt0, plane );
-								
-								double dist = V::Magnitude( sectPt - pt0 );
-								
-								if (    dist > 0
-								     && gDeepPixelDevice.Nearer( iX % width, iY % height, dist )
-								     && poly2d.ContainsPoint( current_pixel_2d ) )
-								{
-									// set the pixel, below
-								}
-								else
-								{
-									continue;
-								}
-								
-								gDeepPixelDevice.Set( iX % width, iY % height, dist );
-								
-								// P . Q = mag(P) * mag(Q) * cos(a)
-								// cos(a) = P.Q / mag(P) / mag(Q)
-								// The normal is already unit length, so its magnitude is 1.
-								/*
-								double cosTheta = DotProduct( ray, faceNormal )
-									/ Magnitude( ray ) / Magnitude( faceNormal );
-								*/
-								double cosAlpha = ray * faceNormal / V::Magnitude( ray );
-								double incidenceRatio = cosAlpha;
-								
-								ColorMatrix lightColor = LightColor( dist, incidenceRatio, selected );
-								
-								ColorMatrix sample = tile.Empty() ? polygon.Color()
-								                                  : GetSampleFromMap( tile,
-								                                                      InterpolatedUV( sectPt,
-								                                                                      savedPoints,
-								                                                                      polygon.MapPoints() ) );
-								
-								ColorMatrix tweaked = ModulateColor( sample, lightColor );
-								
-								uint8_t* pixelAddr = rowAddr + iX * 32/8;
-								
-								inscribe_argb_pixel( pixelAddr, tweaked );
-							}
-						}
-					}
+					continue;
+				}
+				
+				traces.push_back( TracePolygon() );
+				
+				TracePolygon& trace = traces.back();
+				
+				trace.polygon  = &polygon;
+				trace.selected = selected;
+				
+				V::Point3D::Type* savedPoints = trace.savedPoints;
+				
+				savedPoints[0] = mesh.Points()[ savedOffsets[ 0 ] ];
+				savedPoints[1] = mesh.Points()[ savedOffsets[ 1 ] ];
+				savedPoints[2] = mesh.Points()[ savedOffsets[ 2 ] ];
+				
+				std::vector< V::Point3D::Type > points( offsets.size() );
+				
+				// Lookup the vertices of this polygon
+				// in port coordinates
+				std::transform( offsets.begin(),
+				                offsets.end(),
+				                points.begin(),
+				                MeshLookup( mesh ) );
+				
+				trace.faceNormal = V::UnitLength( V::FaceNormal( points ) );
+				
+				trace.plane = V::PlaneVector( trace.faceNormal, points[ 0 ] );
+				
+				// Perspective division
+				std::transform( points.begin(),
+				                points.end(),
+				                points.begin(),
+				                std::ptr_fun( PerspectiveDivision ) );
+				
+				std::vector< V::Point2D::Type >& screenPts( trace.poly2d.Points() );
+				
+				screenPts.resize( points.size() );
+				
+				std::transform( points.begin(),
+				                points.end(),
+				                screenPts.begin(),
+				                std::ptr_fun( Point3DTo2D ) );
+				
+				V::Rect2D< double > bounding_rect = trace.poly2d.BoundingRect();
+				
+				bounding_rect.left  = bounding_rect.left  * width / 2.0 + width / 2.0;
+				bounding_rect.right = bounding_rect.right * width / 2.0 + width / 2.0;
+				
+				bounding_rect.top    = bounding_rect.top    * width / -2.0 + height / 2.0;
+				bounding_rect.bottom = bounding_rect.bottom * width / -2.0 + height / 2.0;
+				
+				V::Rect2D< int > bounds;
+				bounds = bounding_rect;
+				
+				// Extend the rect to account for truncation error
+				bounds.right  += 1;
+				bounds.bottom += 1;
+				
+				// Intersect the polygon bounds with the depth buffer bounds
+				V::Rect2D< int >& rect = trace.rect = depthRect * bounds;
+				
+				// Rows past the bottom are clipped when the tiles are traced.
+				
+				const unsigned top    = rect.top;
+				const unsigned left   = rect.left;
+				const unsigned bottom = std::min< unsigned >( rect.bottom, height );
+				const unsigned right  = std::min< unsigned >( rect.right,  width  );
+				
+				if ( top < bottom  &&  left < right )
+				{
+					BinPolygon( traces.size() - 1, left, top, right, bottom, width );
 				}
 			}
 		}
+		
+		TraceJob job = { &traces, dst, width, height, stride };
+		
+		run_workers( &TraceTile, &job, gTiles.size() );
 	}
 	
 }
@@ -0,0 +1,179 @@
+/*
+	worldview/Workers.cc
+	--------------------
+*/
+
+#include "worldview/Workers.hh"
+
+#ifndef __MACOS__
+// POSIX
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+
+namespace worldview
+{
+
+#ifndef __MACOS__
+	
+	struct work_queue
+	{
+		work_proc  proc;
+		void*      context;
+		size_t     n;
+		size_t     next;
+	};
+	
+	static
+	void work_through( work_queue& queue )
+	{
+		size_t i;
+		
+		while ( (i = __sync_fetch_and_add( &queue.next, 1 )) < queue.n )
+		{
+			queue.proc( queue.context, i );
+		}
+	}
+	
+	/*
+		The pool's threads are started the first time there's work, and
+		then wait for each job in turn.  A job is handed off by bumping the
+		generation; each thread decrements n_busy when it's done with it.
+	*/
+	
+	static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+	static pthread_cond_t  job_posted = PTHREAD_COND_INITIALIZER;
+	static pthread_cond_t  job_done   = PTHREAD_COND_INITIALIZER;
+	
+	static pthread_mutex_t run_mutex = PTHREAD_MUTEX_INITIALIZER;
+	
+	static work_queue*    current_job;
+	static unsigned long  generation;
+	static size_t         n_busy;
+	static size_t         n_pool_threads;
+	
+	static
+	void* pool_thread( void* )
+	{
+		unsigned long seen = 0;
+		
+		while ( true )
+		{
+			pthread_mutex_lock( &pool_mutex );
+			
+			while ( generation == seen )
+			{
+				pthread_cond_wait( &job_posted, &pool_mutex );
+			}
+			
+			seen = generation;
+			
+			work_queue& queue = *current_job;
+			
+			pthread_mutex_unlock( &pool_mutex );
+			
+			work_through( queue );
+			
+			pthread_mutex_lock( &pool_mutex );
+			
+			if ( --n_busy == 0 )
+			{
+				pthread_cond_signal( &job_done );
+			}
+			
+			pthread_mutex_unlock( &pool_mutex );
+		}
+		
+		return NULL;
+	}
+	
+	static
+	size_t count_processors()
+	{
+		const long n = sysconf( _SC_NPROCESSORS_ONLN );
+		
+		return n > 0 ? n : 1;
+	}
+	
+	static
+	void start_pool()
+	{
+		/*
+			The calling thread is one of the workers.  If a thread can't be
+			created, the others (including the caller) take up the slack.
+		*/
+		
+		const size_t n_processors = count_processors();
+		
+		for ( size_t i = 1;  i < n_processors;  ++i )
+		{
+			pthread_t thread;
+			
+			if ( pthread_create( &thread, NULL, &pool_thread, NULL ) == 0 )
+			{
+				pthread_detach( thread );
+				
+				++n_pool_threads;
+			}
+		}
+	}
+	
+	void run_workers( work_proc proc, void* context, size_t n )
+	{
+		static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+		
+		pthread_once( &pool_once, &start_pool );
+		
+		work_queue queue = { proc, context, n, 0 };
+		
+		if ( n_pool_threads == 0  ||  n < 2 )
+		{
+			work_through( queue );
+			return;
+		}
+		
+		// There's one pool, so one job at a time.
+		
+		pthread_mutex_lock( &run_mutex );
+		
+		pthread_mutex_lock( &pool_mutex );
+		
+		current_job = &queue;
+		n_busy      = n_pool_threads;
+		
+		++generation;
+		
+		pthread_cond_broadcast( &job_posted );
+		
+		pthread_mutex_unlock( &pool_mutex );
+		
+		work_through( queue );
+		
+		// The queue lives on our stack, so wait until no thread is using it.
+		
+		pthread_mutex_lock( &pool_mutex );
+		
+		while ( n_busy > 0 )
+		{
+			pthread_cond_wait( &job_done, &pool_mutex );
+		}
+		
+		pthread_mutex_unlock( &pool_mutex );
+		
+		pthread_mutex_unlock( &run_mutex );
+	}
+
+#else
+	
+	void run_workers( work_proc proc, void* context, size_t n )
+	{
+		for ( size_t i = 0;  i < n;  ++i )
+		{
+			proc( context, i );
+		}
+	}
+
+#endif
+
+}
@@ -0,0 +1,33 @@
+/*
+	worldview/Workers.hh
+	--------------------
+*/
+
+#ifndef WORLDVIEW_WORKERS_HH
+#define WORLDVIEW_WORKERS_HH
+
+// Standard C
+#include <stddef.h>
+
+
+namespace worldview
+{
+	
+	typedef void (*work_proc)( void* context, size_t index );
+	
+	/*
+		Call proc( context, i ) for each i in [0, n), on the calling thread
+		and a pool of threads (one per additional online processor, started
+		on the first call), and return when all the calls have returned.
+		Each worker takes the next index in turn, so the calls may run in any
+		order -- they must not depend on each other.
+		
+		Where threads aren't available, the calls are made in order on the
+		calling thread.
+	*/
+	
+	void run_workers( work_proc proc, void* context, size_t n );
+	
+}
+
+#endif
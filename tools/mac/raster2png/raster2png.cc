@@ -26,6 +26,7 @@
 #include "more/perror.hh"
 
 // raster
+#include "raster/frames.hh"
 #include "raster/load.hh"
 
 
@@ -162,7 +163,9 @@ CGImageRef CGImage_from_raster( const raster_load& raster )
 		cpy = &converting_LE_565_to_555_copy;
 	}
 	
-	CGDataProviderRef dataProvider = make_data_provider( base,
+	char* image_base = (char*) front_buffer( raster );
+	
+	CGDataProviderRef dataProvider = make_data_provider( image_base,
 	                                                     height * stride,
 	                                                     cpy );
 	
@@ -6,6 +6,9 @@
 // POSIX
 #include <unistd.h>
 
+// Standard C
+#include <stdlib.h>
+
 // must
 #include "must/write.h"
 
@@ -19,6 +22,7 @@
 #include "bignum/integer_hex.hh"
 
 // vlib
+#include "vlib/bytecode.hh"
 #include "vlib/interpret.hh"
 #include "vlib/string-utils.hh"
 
@@ -28,12 +32,14 @@ using namespace vlib;
 
 enum
 {
+	Opt_bytecode   = 'B',
 	Opt_hex_output = 'x',
 };
 
 static command::option options[] =
 {
-	{ "hex",  Opt_hex_output },
+	{ "bytecode", Opt_bytecode   },
+	{ "hex",      Opt_hex_output },
 	{ NULL },
 };
 
@@ -70,10 +76,18 @@ static char* const* get_options( char** argv )
 	
 	++argv;  // skip arg 0
 	
+	// Setting V_BYTECODE runs a test suite with the bytecode interpreter.
+	
+	bytecode_enabled = getenv( "V_BYTECODE" ) != NULL;
+	
 	while ( (opt = command::get_option( (char* const**) &argv, options )) > 0 )
 	{
 		switch ( opt )
 		{
+			case Opt_bytecode:
+				bytecode_enabled = true;
+				break;
+			
 			case Opt_hex_output:
 				hex_output = true;
 				break;
@@ -22,3 +22,23 @@ $ vc 'var t = str^[]; t <-- (); t'
 
 $ vc 'int^[] map {_}'
 1 >= '[]'
+
+%
+
+$ vc 'var t = int^[]; for k in 0 -> 20 do {t[k] = k * 2}; t <-- 5 => 0; t <-- 20 => 40; t[5], t[19], t[20], t[[3, 17]]'
+1 >= '(10, 38, 40, [6, 34])'
+
+%
+
+$ vc 'var t = str^[]; for k in 0 -> 20 do {t[str k] = k}; var u = t; u["15"] = 0; t["15"], u["15"]'
+1 >= '(15, 0)'
+
+%
+
+$ vc 'var t = ...^[]; for k in 0 -> 20 do {t[k] = k}; try { t[null] } catch { _ }'
+1 >= '"no such key in table"'
+
+%
+
+$ vc 'var t = int^[]; for k in 0 -> 20 do {t[k] = k}; var r = [tail(*t)]; var u = t; t[5] = 0; t[30] = 1; u[6] = -1; r[4], t[5], t[6], t.length, u[5], u[6], u.length'
+1 >= '((5 => 5), 0, 6, 21, 5, -1, 20)'
@@ -20,6 +20,26 @@ $ vc -x 98765432109876543210
 
 %
 
+$ vc 'var x = 0; var y = (x = 5) * x; y'
+1 >= 0
+
+%
+
+$ vc -B 'var x = 0; var y = (x = 5) * x; y'
+1 >= 0
+
+%
+
+$ vc --bytecode 'false and 1/0, true or 1/0, 0 or 3'
+1 >= '(false, true, 3)'
+
+%
+
+$ vc -B 'var f = lambda {return _ * 2}; f(21), f'
+1 >= '(42, (lambda {return (_ * 2)}))'
+
+%
+
 $ vc 1+2
 1 >= 3
 
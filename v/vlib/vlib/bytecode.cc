@@ -0,0 +1,526 @@
+/*
+	bytecode.cc
+	-----------
+*/
+
+#include "vlib/bytecode.hh"
+
+// Standard C
+#include <stdint.h>
+
+// Standard C++
+#include <new>
+#include <vector>
+
+// debug
+#include "debug/assert.hh"
+
+// iota
+#include "iota/swap.hh"
+
+// vlib
+#include "vlib/eval.hh"
+#include "vlib/execute.hh"
+#include "vlib/generic.hh"
+#include "vlib/list-utils.hh"
+#include "vlib/stack.hh"
+#include "vlib/symbol.hh"
+#include "vlib/tracker.hh"
+#include "vlib/types/boolean.hh"
+#include "vlib/types/symdesc.hh"
+
+
+namespace vlib
+{
+	
+	bool bytecode_enabled = false;
+	
+	/*
+		Each instruction is a 32-bit word, with the opcode in the low byte
+		and an operand in the rest.  A local's operand is its frame depth
+		(in the high byte) and its index in the frame.
+	*/
+	
+	enum opcode
+	{
+		Code_push,    // push constant n
+		Code_lookup,  // push the value of constant n (a non-local symbol)
+		Code_load,    // push the value of a local
+		Code_refer,   // push a local itself (as the target of a varop)
+		Code_eval,    // pop two operands; push the result of node n's op
+		Code_exec,    // push the result of walking node n
+		Code_drop,    // pop and discard
+		Code_and,     // if the top is false, jump to n; else pop it
+		Code_or,      // if the top is true,  jump to n; else pop it
+	};
+	
+	const unsigned max_local_depth = 0xFF;
+	const unsigned max_local_index = 0xFFFF;
+	
+	typedef uint32_t instruction;
+	
+	struct bytecode_program
+	{
+		std::vector< Value >        constants;
+		std::vector< instruction >  code;
+	};
+	
+	class Bytecode : public Value
+	{
+		public:
+			Bytecode()
+			:
+				Value( sizeof (bytecode_program),
+				       &generic_destructor< bytecode_program >,
+				       Value_other,
+				       0 )  // NULL
+			{
+				new ((void*) pointer()) bytecode_program();
+			}
+			
+			bytecode_program& program() const
+			{
+				return *(bytecode_program*) pointer();
+			}
+	};
+	
+	static
+	bool get_local( const Value& v, unsigned& operand )
+	{
+		if ( const Symbol* sym = v.sym() )
+		{
+			const Value& value = sym->get();
+			
+			if ( value.type() == V_desc )
+			{
+				const SymDesc& symdesc = (const SymDesc&) value;
+				
+				const unsigned depth = symdesc.depth();
+				const unsigned index = symdesc.index();
+				
+				if ( depth <= max_local_depth  &&  index <= max_local_index )
+				{
+					operand = depth << 16 | index;
+					
+					return true;
+				}
+			}
+		}
+		
+		return false;
+	}
+	
+	static
+	bool is_elseif( const Expr* expr )
+	{
+		if ( expr->op == Op_else )
+		{
+			if (( expr = expr->right.expr() ))
+			{
+				return expr->op == Op_if;
+			}
+		}
+		
+		return false;
+	}
+	
+	/*
+		These are the operations that execute() handles specially, other
+		than the ones the compiler handles itself.
+	*/
+	
+	static
+	bool is_special( const Expr* expr )
+	{
+		switch ( expr->op )
+		{
+			case Op_for:
+			case Op_module:
+			case Op_export:
+			case Op_block:
+			case Op_do_2:
+			case Op_while_2:
+			case Op_assert:
+			case Op_unary_refer:
+			case Op_bytecode:
+				return true;
+			
+			default:
+				break;
+		}
+		
+		return declares_symbols( expr->op )  ||  is_elseif( expr );
+	}
+	
+	/*
+		Returns the symbol that's the target of a varop, if it's a plain
+		symbol (possibly being declared), or NULL otherwise.
+	*/
+	
+	static
+	const Value* simple_target( const Value& v )
+	{
+		const Value* target = &v;
+		
+		if ( Expr* expr = v.expr() )
+		{
+			if ( ! declares_symbols( expr->op ) )
+			{
+				return 0;  // NULL
+			}
+			
+			target = &expr->right;
+		}
+		
+		return target->type() == Value_symbol ? target : 0;  // NULL
+	}
+	
+	class compiler
+	{
+		private:
+			bytecode_program& its_program;
+			
+			unsigned constant( const Value& v );
+			
+			unsigned here() const  { return its_program.code.size(); }
+			
+			void emit( opcode op, unsigned operand = 0 )
+			{
+				its_program.code.push_back( op | operand << 8 );
+			}
+			
+			void patch( unsigned at, unsigned operand )
+			{
+				its_program.code[ at ] |= operand << 8;
+			}
+			
+			void compile_symbol( const Value& v );
+			
+			void compile_target( const Value& v );
+		
+		public:
+			compiler( bytecode_program& program ) : its_program( program )
+			{
+			}
+			
+			void compile( const Value& tree );
+	};
+	
+	unsigned compiler::constant( const Value& v )
+	{
+		its_program.constants.push_back( v );
+		
+		return its_program.constants.size() - 1;
+	}
+	
+	void compiler::compile_symbol( const Value& v )
+	{
+		unsigned local;
+		
+		if ( get_local( v, local ) )
+		{
+			emit( Code_load, local );
+		}
+		else if ( v.type() == Value_symbol  &&  v.sym()->get().type() == V_desc )
+		{
+			emit( Code_exec, constant( v ) );  // too deep to encode
+		}
+		else
+		{
+			emit( Code_lookup, constant( v ) );
+		}
+	}
+	
+	void compiler::compile_target( const Value& v )
+	{
+		unsigned local;
+		
+		if ( get_local( v, local ) )
+		{
+			emit( Code_refer, local );
+		}
+		else
+		{
+			emit( Code_push, constant( v ) );
+		}
+	}
+	
+	/*
+		The tree walker evaluates the right operand of a binary operation
+		before the left one.  So that both engines produce the same results,
+		we do the same.
+	*/
+	
+	void compiler::compile( const Value& tree )
+	{
+		if ( tree.is_evaluated() )
+		{
+			emit( Code_push, constant( tree ) );
+			return;
+		}
+		
+		Expr* expr = tree.expr();
+		
+		if ( expr == 0 )  // NULL
+		{
+			compile_symbol( tree );
+			return;
+		}
+		
+		if ( expr->op == Op_end )
+		{
+			compile( expr->left );
+			emit( Code_drop );
+			compile( expr->right );
+			return;
+		}
+		
+		if ( expr->op == Op_and  ||  expr->op == Op_or )
+		{
+			compile( expr->left );
+			
+			const unsigned branch = here();
+			
+			emit( expr->op == Op_and ? Code_and : Code_or );
+			
+			compile( expr->right );
+			
+			patch( branch, here() );
+			return;
+		}
+		
+		if ( is_special( expr ) )
+		{
+			emit( Code_exec, constant( tree ) );
+			return;
+		}
+		
+		const Value* left  = &expr->left;
+		const Value* right = &expr->right;
+		
+		if ( left->type() == Value_dummy_operand )
+		{
+			using iota::swap;
+			
+			swap( left, right );
+		}
+		else if ( expr->op == Op_typeof )
+		{
+			// This is an endec type, not a typeof operation
+			
+			emit( Code_push, constant( tree ) );
+			return;
+		}
+		
+		if ( is_right_varop( expr->op ) )
+		{
+			emit( Code_exec, constant( tree ) );
+			return;
+		}
+		
+		if ( is_left_varop( expr->op )  &&  ! is_type_annotation( *left ) )
+		{
+			const Value* target = simple_target( *left );
+			
+			if ( target == 0  ||  expr->op == Op_denote )  // NULL
+			{
+				emit( Code_exec, constant( tree ) );
+				return;
+			}
+			
+			compile( *right );
+			compile_target( *target );
+			emit( Code_eval, constant( tree ) );
+			return;
+		}
+		
+		compile( *right );
+		compile( *left );
+		emit( Code_eval, constant( tree ) );
+	}
+	
+	static
+	Value compile_scopes( const Value& tree )
+	{
+		Expr* expr = tree.expr();
+		
+		if ( expr == 0  ||  tree.is_evaluated()  ||  tree.dispatch_methods() )
+		{
+			return tree;
+		}
+		
+		if ( expr->op == Op_scope )
+		{
+			const Value code = compile_code( compile_scopes( expr->right ) );
+			
+			return Value( expr->left, expr->op, code, expr->source );
+		}
+		
+		const Value left  = compile_scopes( expr->left  );
+		const Value right = compile_scopes( expr->right );
+		
+		if ( left.expr() == expr->left.expr()  &&  right.expr() == expr->right.expr() )
+		{
+			return tree;
+		}
+		
+		return Value( left, expr->op, right, expr->source );
+	}
+	
+	Value compile_bytecode( const Value& tree )
+	{
+		return compile_scopes( tree );
+	}
+	
+	Value compile_code( const Value& code )
+	{
+		if ( code.expr() == 0  ||  code.is_evaluated() )  // NULL
+		{
+			return code;
+		}
+		
+		Bytecode bytecode;
+		
+		compiler( bytecode.program() ).compile( code );
+		
+		return Value( code, Op_bytecode, bytecode, code.expr()->source );
+	}
+	
+	class operand_stack
+	{
+		private:
+			std::vector< Value > its_values;
+			
+			// non-copyable
+			operand_stack           ( const operand_stack& );
+			operand_stack& operator=( const operand_stack& );
+		
+		public:
+			operand_stack()  { its_values.reserve( 16 ); }
+			
+			~operand_stack()
+			{
+				while ( ! its_values.empty() )
+				{
+					pop();
+				}
+			}
+			
+			const Value& top() const  { return its_values.end()[ -1 ]; }
+			const Value& next() const  { return its_values.end()[ -2 ]; }
+			
+			void push( const Value& v )
+			{
+				add_root( v );
+				
+				its_values.push_back( v );
+			}
+			
+			void pop()
+			{
+				del_root( its_values.back() );
+				
+				its_values.pop_back();
+			}
+	};
+	
+	static
+	const Value& local_at( const Value& stack, unsigned operand )
+	{
+		const Value& frame = nth_frame( stack, operand >> 16 );
+		
+		Expr* expr = frame.expr();
+		
+		ASSERT( expr );
+		ASSERT( expr->op == Op_frame );
+		
+		return get_nth( expr->right, operand & 0xFFFF );
+	}
+	
+	static inline
+	bool truth( const Value& v )
+	{
+		return v.to< Boolean >();
+	}
+	
+	Value_in_flight run_bytecode( const Value& program, const Value& stack )
+	{
+		const bytecode_program& bytecode = ((const Bytecode&) program).program();
+		
+		const Value* constants = &bytecode.constants[ 0 ];
+		
+		const instruction* begin = &bytecode.code[ 0 ];
+		const instruction* end   = begin + bytecode.code.size();
+		
+		operand_stack operands;
+		
+		for ( const instruction* pc = begin;  pc < end; )
+		{
+			const instruction code = *pc++;
+			
+			const unsigned n = code >> 8;
+			
+			switch ( code & 0xFF )
+			{
+				case Code_push:
+					operands.push( constants[ n ] );
+					break;
+				
+				case Code_lookup:
+					operands.push( eval( constants[ n ] ) );
+					break;
+				
+				case Code_load:
+					operands.push( eval( local_at( stack, n ) ) );
+					break;
+				
+				case Code_refer:
+					operands.push( local_at( stack, n ) );
+					break;
+				
+				case Code_eval:
+					{
+						const Expr* expr = constants[ n ].expr();
+						
+						const Value result = eval( operands.top(),
+						                           expr->op,
+						                           operands.next(),
+						                           expr->source );
+						
+						operands.pop();
+						operands.pop();
+						
+						operands.push( result );
+					}
+					break;
+				
+				case Code_exec:
+					operands.push( execute( constants[ n ], stack ) );
+					break;
+				
+				case Code_drop:
+					operands.pop();
+					break;
+				
+				case Code_and:
+				case Code_or:
+					if ( truth( operands.top() ) == ((code & 0xFF) == Code_or) )
+					{
+						pc = begin + n;
+					}
+					else
+					{
+						operands.pop();
+					}
+					break;
+				
+				default:
+					ASSERT( false );
+					break;
+			}
+		}
+		
+		return operands.top();
+	}
+	
+}
@@ -0,0 +1,36 @@
+/*
+	bytecode.hh
+	-----------
+*/
+
+#ifndef VLIB_BYTECODE_HH
+#define VLIB_BYTECODE_HH
+
+// vlib
+#include "vlib/in-flight.hh"
+#include "vlib/value.hh"
+
+
+namespace vlib
+{
+	
+	/*
+		If bytecode_enabled is set, interpret() compiles the code of each
+		scope in an analyzed program into bytecode for a stack machine, and
+		execute() runs it in place of walking the code.  The tree walker is
+		the reference implementation:  anything the compiler doesn't handle
+		is left to it (one node at a time), and running a test suite both
+		ways should produce identical results.
+	*/
+	
+	extern bool bytecode_enabled;
+	
+	Value compile_bytecode( const Value& tree );
+	
+	Value compile_code( const Value& code );
+	
+	Value_in_flight run_bytecode( const Value& program, const Value& stack );
+	
+}
+
+#endif
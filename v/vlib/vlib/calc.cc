@@ -22,6 +22,7 @@
 #include "vlib/os.hh"
 #include "vlib/return.hh"
 #include "vlib/string-utils.hh"
+#include "vlib/table-index.hh"
 #include "vlib/table-utils.hh"
 #include "vlib/targets.hh"
 #include "vlib/throw.hh"
@@ -67,6 +68,10 @@ namespace vlib
 		{
 			if ( expr->op == Op_array )
 			{
+				// The list's cells are about to be shared.
+				
+				disown_table_cells( expr );
+				
 				return expr->right;
 			}
 			
@@ -741,10 +746,68 @@ namespace vlib
 	                 op_type       op,
 	                 const Value&  right );
 	
+	static
+	Value fixnum_calc( long a, op_type op, long b )
+	{
+		long result;
+		
+		switch ( op )
+		{
+			case Op_add:
+				if ( fixnum_add( a, b, result ) )
+				{
+					return Integer( result );
+				}
+				break;
+			
+			case Op_subtract:
+				if ( fixnum_subtract( a, b, result ) )
+				{
+					return Integer( result );
+				}
+				break;
+			
+			case Op_multiply:
+				if ( fixnum_multiply( a, b, result ) )
+				{
+					return Integer( result );
+				}
+				break;
+			
+			case Op_equal:    return Boolean( a == b );
+			case Op_unequal:  return Boolean( a != b );
+			
+			case Op_lt:   return Boolean( a <  b );
+			case Op_lte:  return Boolean( a <= b );
+			case Op_gt:   return Boolean( a >  b );
+			case Op_gte:  return Boolean( a >= b );
+			
+			case Op_cmp:  return Integer( (a > b) - (a < b) );
+			
+			default:
+				break;
+		}
+		
+		return Value();
+	}
+	
 	Value calc( const Value&  left,
 	            op_type       op,
 	            const Value&  right )
 	{
+		long a;
+		long b;
+		
+		if ( get_fixnum( left, a )  &&  get_fixnum( right, b ) )
+		{
+			const Value result = fixnum_calc( a, op, b );
+			
+			if ( result )
+			{
+				return result;
+			}
+		}
+		
 		if ( const dispatch* methods = left.dispatch_methods() )
 		{
 			if ( const operators* ops = methods->ops )
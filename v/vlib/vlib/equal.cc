@@ -75,6 +75,12 @@ namespace vlib
 						return false;
 					}
 					
+					if ( ax.op == Op_bytecode )
+					{
+						// Compare the code, not what it was compiled to.
+						return equal_atoms( ax.left, bx.left );
+					}
+					
 					const bool compare_left = (ax.op & 0xFF) != Op_scope;
 					
 					if ( compare_left  &&  ! equal_atoms( ax.left, bx.left ) )
@@ -165,7 +165,7 @@ namespace vlib
 			
 			if ( collectible )
 			{
-				cull_unreachable_objects();
+				cull_unreachable_objects_if_due();
 			}
 			
 			return *target.addr;
@@ -247,7 +247,7 @@ namespace vlib
 				
 				if ( collectible )
 				{
-					cull_unreachable_objects();
+					cull_unreachable_objects_if_due();
 				}
 				
 				return right;
@@ -11,6 +11,7 @@
 // vlib
 #include "vlib/array-utils.hh"
 #include "vlib/assert.hh"
+#include "vlib/bytecode.hh"
 #include "vlib/collectible.hh"
 #include "vlib/eval.hh"
 #include "vlib/exceptions.hh"
@@ -61,7 +62,7 @@ namespace vlib
 	{
 		if ( symbol_list_with_values_is_collectible( its_symbol_list ) )
 		{
-			cull_unreachable_objects();
+			cull_unreachable_objects_if_due();
 		}
 	}
 	
@@ -103,9 +104,6 @@ namespace vlib
 		return Value( new_head, unshare_symbols( tail ) );
 	}
 	
-	static
-	Value_in_flight execute( const Value& tree, const Value& stack );
-	
 	static
 	Value_in_flight invoke_block( const Value& block, const Value& arguments )
 	{
@@ -545,6 +543,11 @@ namespace vlib
 		
 		if ( Expr* expr = tree.expr() )
 		{
+			if ( expr->op == Op_bytecode )
+			{
+				return run_bytecode( expr->right, stack );
+			}
+			
 			if ( expr->op == Op_for )
 			{
 				run_for_loop( expr->right, stack );
@@ -655,12 +658,19 @@ namespace vlib
 				return tree;
 			}
 			
+			/*
+				Operands are evaluated right to left.  They're named here
+				rather than passed straight to eval(), since C++ doesn't
+				specify the order in which arguments are evaluated, and the
+				bytecode compiler has to match.
+			*/
+			
 			if ( is_right_varop( expr->op ) )
 			{
-				return eval( resolve_symbol_expr( *left, stack ),
-				             expr->op,
-				             resolve_symbol_expr( *right, stack ),
-				             expr->source );
+				const Value b = resolve_symbol_expr( *right, stack );
+				const Value a = resolve_symbol_expr( *left,  stack );
+				
+				return eval( a, expr->op, b, expr->source );
 			}
 			
 			if ( is_left_varop( expr->op )  &&  ! is_type_annotation( *left ) )
@@ -670,10 +680,10 @@ namespace vlib
 					THROW( "function prototypes are unimplemented" );
 				}
 				
-				return eval( resolve_symbol_expr( *left, stack ),
-				             expr->op,
-				             execute( *right, stack ),
-				             expr->source );
+				const Value b = execute( *right, stack );
+				const Value a = resolve_symbol_expr( *left, stack );
+				
+				return eval( a, expr->op, b, expr->source );
 			}
 			
 			/*
@@ -682,10 +692,10 @@ namespace vlib
 				only make this easier.
 			*/
 			
-			return eval( execute( *left, stack ),
-			             expr->op,
-			             execute( *right, stack ),
-			             expr->source );
+			const Value b = execute( *right, stack );
+			const Value a = execute( *left,  stack );
+			
+			return eval( a, expr->op, b, expr->source );
 		}
 		
 		const Value& resolved = resolve_symbol( tree, stack );
@@ -7,6 +7,7 @@
 #define VLIB_EXECUTE_HH
 
 // vlib
+#include "vlib/in-flight.hh"
 #include "vlib/value.hh"
 
 
@@ -24,6 +25,8 @@ namespace vlib
 		return false;
 	}
 	
+	Value_in_flight execute( const Value& tree, const Value& stack );
+	
 	Value execute( const Value& root );
 	
 }
@@ -25,6 +25,7 @@
 
 // vlib
 #include "vlib/analyze.hh"
+#include "vlib/bytecode.hh"
 #include "vlib/exceptions.hh"
 #include "vlib/execute.hh"
 #include "vlib/parse.hh"
@@ -90,7 +91,14 @@ namespace vlib
 		{
 			static int startup = (inject_startup_header( globals ), 0);
 			
-			return execute( analyze( parse( program, file ), globals ) );
+			Value tree = analyze( parse( program, file ), globals );
+			
+			if ( bytecode_enabled )
+			{
+				tree = compile_bytecode( tree );
+			}
+			
+			return execute( tree );
 		}
 		catch ( const std::bad_alloc& )
 		{
@@ -25,6 +25,17 @@ namespace vlib
 		return Integer( i );
 	}
 	
+	static
+	Value make_int_value_of_same_type( long i, const Value& v )
+	{
+		if ( v.type() == Value_byte )
+		{
+			return Byte( i );
+		}
+		
+		return Integer( i );
+	}
+	
 	range_iterator::range_iterator( const Value& range )
 	{
 		if ( Expr* expr = range.expr() )
@@ -33,6 +44,29 @@ namespace vlib
 			
 			if ( op == Op_gamut  ||  op == Op_delta )
 			{
+				long low;
+				long high;
+				
+				/*
+					The high bound must be below fixnum_max, so that stepping
+					past it doesn't overflow.
+				*/
+				
+				its_bounds_are_fixnums = get_fixnum( expr->left,  low  )  &&
+				                         get_fixnum( expr->right, high )  &&
+				                         fixnum_subtract( high, op == Op_delta, high )  &&
+				                         high < fixnum_max;
+				
+				if ( its_bounds_are_fixnums )
+				{
+					its_fixnum_next = low;
+					its_fixnum_high = high;
+					
+					its_value = expr->left;
+					
+					return;
+				}
+				
 				its_next = expr->left .number();
 				its_high = expr->right.number() - (op == Op_delta);
 				
@@ -47,7 +81,14 @@ namespace vlib
 	
 	const Value& range_iterator::get() const
 	{
-		its_value = make_int_value_of_same_type( its_next, its_value );
+		if ( its_bounds_are_fixnums )
+		{
+			its_value = make_int_value_of_same_type( its_fixnum_next, its_value );
+		}
+		else
+		{
+			its_value = make_int_value_of_same_type( its_next, its_value );
+		}
 		
 		return its_value;
 	}
@@ -24,16 +24,39 @@ namespace vlib
 			bignum::integer its_next;
 			bignum::integer its_high;
 			
+			/*
+				If the bounds are fixnums, the iteration counts with longs
+				instead, and its_next and its_high aren't used.
+			*/
+			
+			long its_fixnum_next;
+			long its_fixnum_high;
+			bool its_bounds_are_fixnums;
+			
 			mutable Value its_value;
 		
 		public:
 			range_iterator( const Value& range );
 			
-			bool finished() const  { return its_next > its_high; }
+			bool finished() const
+			{
+				return its_bounds_are_fixnums ? its_fixnum_next > its_fixnum_high
+				                              : its_next > its_high;
+			}
 			
 			const Value& get() const;
 			
-			void step()  { ++its_next; }
+			void step()
+			{
+				if ( its_bounds_are_fixnums )
+				{
+					++its_fixnum_next;
+				}
+				else
+				{
+					++its_next;
+				}
+			}
 			
 			bool next()
 			{
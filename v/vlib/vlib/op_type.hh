@@ -154,6 +154,13 @@ namespace vlib
 		
 		Op_expression,
 		
+		/*
+			A bytecode expression pairs a block's code (on the left, for
+			display and comparison) with the bytecode compiled from it.
+		*/
+		
+		Op_bytecode,
+		
 		Op_invocation = 0x100 | Op_block,
 		Op_activation = 0x100 | Op_scope,
 	};
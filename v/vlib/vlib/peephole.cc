@@ -8,6 +8,9 @@
 // debug
 #include "debug/assert.hh"
 
+// vlib
+#include "vlib/bytecode.hh"
+
 
 namespace vlib
 {
@@ -76,7 +79,18 @@ namespace vlib
 		ASSERT( expr != 0 );  // NULL
 		ASSERT( expr->op == Op_activation );
 		
-		if ( !(expr = expr->right.expr())  ||  expr->op != Op_end    )  return;
+		// If the block was compiled, optimize its code and recompile it.
+		
+		Value code = expr->right;
+		
+		const bool compiled = (expr = code.expr())  &&  expr->op == Op_bytecode;
+		
+		if ( compiled )
+		{
+			code = expr->left;
+		}
+		
+		if ( !(expr = code.expr())         ||  expr->op != Op_end    )  return;
 		if ( !(expr = expr->left .expr())  ||  expr->op != Op_end    )  return;
 		if ( !(expr = expr->right.expr())  ||  expr->op != Op_return )  return;
 		
@@ -84,13 +98,18 @@ namespace vlib
 		Value& root = body.unshare().expr()->right.unshare().expr()->right;
 		
 		// Discard the last statement.
-		root = root.expr()->left;
+		root = code.expr()->left;
 		
 		// This is the `return` operation.
 		Value& end = root.unshare().expr()->right;
 		
 		// Elide the `return` operator.
 		end = end.expr()->right;
+		
+		if ( compiled )
+		{
+			root = compile_code( root );
+		}
 	}
 	
 }
@@ -7,6 +7,7 @@
 
 // vlib
 #include "vlib/analyze.hh"
+#include "vlib/bytecode.hh"
 #include "vlib/execute.hh"
 #include "vlib/parse.hh"
 #include "vlib/symbol.hh"
@@ -26,7 +27,7 @@ namespace vlib
 		const Value parsed = parse( startup, "<startup>" );
 		const Value analyzed = analyze( parsed, globals );
 		
-		execute( analyzed );
+		execute( bytecode_enabled ? compile_bytecode( analyzed ) : analyzed );
 		
 		const Value& symbols = analyzed.expr()->left;
 		
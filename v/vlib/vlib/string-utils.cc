@@ -311,6 +311,11 @@ namespace vlib
 		
 		ASSERT( expr != NULL );
 		
+		if ( expr->op == Op_bytecode )
+		{
+			return composite_length( expr->left, mode, print_parens );
+		}
+		
 		if ( (expr->op & 0xFF) == Op_block )
 		{
 			expr = expr->right.expr();
@@ -440,6 +445,11 @@ namespace vlib
 		
 		Expr* expr = value.expr();
 		
+		if ( expr->op == Op_bytecode )
+		{
+			return make_string( p, expr->left, mode, print_parens );
+		}
+		
 		if ( (expr->op & 0xFF) == Op_block )
 		{
 			expr = expr->right.expr();
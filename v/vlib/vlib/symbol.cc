@@ -35,6 +35,8 @@ namespace vlib
 			THROW( "type annotation of defined symbol" );
 		}
 		
+		note_modification();
+		
 		its_vtype = vtype;
 	}
 	
@@ -55,6 +57,8 @@ namespace vlib
 			THROW( "reassignment of constant" );
 		}
 		
+		note_modification();
+		
 		Target result = { &its_value, &its_vtype };
 		
 		return result;
@@ -96,6 +100,8 @@ namespace vlib
 			THROW( "modification of constant" );
 		}
 		
+		note_modification();
+		
 		its_value.unshare();
 		
 		return its_value;
@@ -12,6 +12,7 @@
 // vlib
 #include "vlib/value.hh"
 #include "vlib/target.hh"
+#include "vlib/tracker.hh"
 
 
 namespace vlib
@@ -19,9 +20,12 @@ namespace vlib
 	
 	enum mark_type
 	{
-		Mark_none,   // not participating in GC
-		Mark_white,  // not reached
-		Mark_black,  // reachable from a root
+		Mark_none,    // not participating in GC
+		Mark_white,   // not reached
+		Mark_black,   // reachable from a root
+		Mark_old,     // reached by an earlier cull, presumed still reachable
+		Mark_dirty,   // old, but modified since the last cull
+		Mark_shadow,  // not participating, but contained in an old value
 	};
 	
 	class Symbol
@@ -32,6 +36,14 @@ namespace vlib
 			Value         its_value;
 			symbol_type   its_type;
 			mark_type     its_mark;
+			
+			void note_modification()
+			{
+				if ( its_mark == Mark_old )
+				{
+					remember_modified_symbol( this );
+				}
+			}
 		
 		public:
 			Symbol() : its_type(), its_mark()
@@ -67,7 +79,12 @@ namespace vlib
 			
 			Value& deref();
 			
-			Value& deref_unsafe()  { return its_value; }
+			Value& deref_unsafe()
+			{
+				note_modification();
+				
+				return its_value;
+			}
 			
 			void set_mark( mark_type mark )  { its_mark = mark; }
 			
@@ -0,0 +1,482 @@
+/*
+	table-index.cc
+	--------------
+*/
+
+#include "vlib/table-index.hh"
+
+// Standard C++
+#include <vector>
+
+// bignum
+#include "bignum/integer.hh"
+
+// vlib
+#include "vlib/list-utils.hh"
+#include "vlib/table-utils.hh"
+#include "vlib/throw.hh"
+#include "vlib/iterators/array_iterator.hh"
+#include "vlib/types/boolean.hh"
+#include "vlib/types/mb32.hh"
+
+
+namespace vlib
+{
+	
+	struct index_slot
+	{
+		unsigned long  hash;
+		const Expr*    mapping;  // NULL if the slot is unused
+		Value*         place;    // where the mapping is stored, if owned
+	};
+	
+	typedef std::vector< index_slot > index_slots;
+	
+	/*
+		An index owns its array's cells if none of them are shared with any
+		other list.  Then the places where the mappings are stored are known,
+		and a mapping can be updated or appended in place, without walking
+		the array.  Anything that might share the cells (or move a mapping)
+		without going through the index disowns them.
+	*/
+	
+	struct table_index
+	{
+		index_slots    slots;  // always a power of two of them
+		unsigned long  count;
+		Value*         last;   // where the last mapping is stored, if owned
+	};
+	
+	/*
+		The index hangs off the array's Expr.  An array is only changed (or
+		destroyed) by a thread that holds the only reference to it, so only
+		the lazy building of the index (when a shared array is looked up)
+		and disowning its cells (when it's dereferenced) can happen in more
+		than one thread at once.  They use atomic operations.
+	*/
+	
+	static inline
+	table_index* load_index( const Expr* array )
+	{
+		return __atomic_load_n( &array->index, __ATOMIC_ACQUIRE );
+	}
+	
+	const unsigned long min_index_slots = 16;
+	
+	static inline
+	unsigned long mix( unsigned long h, unsigned long x )
+	{
+		return (h ^ x) * 16777619;  // FNV prime
+	}
+	
+	static
+	bool hash_key( const Value& key, unsigned long& hash )
+	{
+		unsigned long h = mix( 2166136261u, key.type() );
+		
+		switch ( key.type() )
+		{
+			case Value_boolean:
+				h = mix( h, (const Boolean&) key );
+				break;
+			
+			case Value_byte:
+			case Value_number:
+				h = mix( h, key.number().sign()    );
+				h = mix( h, key.number().clipped() );
+				break;
+			
+			case Value_mb32:
+				h = mix( h, ((const MB32&) key).get() );
+				break;
+			
+			case Value_string:
+			case Value_packed:
+				{
+					const plus::string& s = key.string();
+					
+					const char* p   = s.data();
+					const char* end = p + s.size();
+					
+					while ( p < end )
+					{
+						h = mix( h, (unsigned char) *p++ );
+					}
+				}
+				break;
+			
+			default:
+				return false;
+		}
+		
+		hash = h ^ (h >> 15);
+		
+		return true;
+	}
+	
+	static
+	index_slot& find_slot( table_index&   index,
+	                       unsigned long  hash,
+	                       const Value&   key )
+	{
+		const unsigned long mask = index.slots.size() - 1;
+		
+		unsigned long i = hash & mask;
+		
+		while ( true )
+		{
+			index_slot& slot = index.slots[ i ];
+			
+			if ( slot.mapping == NULL )
+			{
+				return slot;
+			}
+			
+			if ( slot.hash == hash  &&  equal_keys( key, slot.mapping->left ) )
+			{
+				return slot;
+			}
+			
+			i = (i + 1) & mask;
+		}
+	}
+	
+	static
+	void grow( table_index& index )
+	{
+		index_slots old_slots( index.slots.size() * 2 );
+		
+		old_slots.swap( index.slots );
+		
+		typedef index_slots::const_iterator Iter;
+		
+		for ( Iter it = old_slots.begin();  it != old_slots.end();  ++it )
+		{
+			if ( it->mapping )
+			{
+				const unsigned long mask = index.slots.size() - 1;
+				
+				unsigned long i = it->hash & mask;
+				
+				while ( index.slots[ i ].mapping )
+				{
+					i = (i + 1) & mask;
+				}
+				
+				index.slots[ i ] = *it;
+			}
+		}
+	}
+	
+	/*
+		Returns false if the value isn't a mapping.  Mappings whose keys
+		can't be hashed are left out, since they can't match a lookup anyway.
+	*/
+	
+	static
+	bool index_mapping( table_index&  index,
+	                    const Value&  mapping,
+	                    bool          replace,
+	                    Value*        place = NULL )
+	{
+		const Expr* expr = mapping.expr();
+		
+		if ( expr == NULL  ||  expr->op != Op_mapping )
+		{
+			return false;
+		}
+		
+		unsigned long hash;
+		
+		if ( ! hash_key( expr->left, hash ) )
+		{
+			return true;
+		}
+		
+		if ( (index.count + 1) * 2 > index.slots.size() )
+		{
+			grow( index );
+		}
+		
+		index_slot& slot = find_slot( index, hash, expr->left );
+		
+		if ( slot.mapping == NULL )
+		{
+			slot.hash    = hash;
+			slot.mapping = expr;
+			slot.place   = place;
+			
+			++index.count;
+		}
+		else if ( replace )
+		{
+			slot.mapping = expr;
+			slot.place   = place;
+		}
+		
+		return true;
+	}
+	
+	static
+	void build_index( table_index& index, const Value& array )
+	{
+		index.slots.resize( min_index_slots );
+		index.count = 0;
+		index.last  = NULL;
+		
+		array_iterator it( array );
+		
+		while ( it )
+		{
+			if ( ! index_mapping( index, it.use(), false ) )
+			{
+				THROW( "non-mapping in table" );
+			}
+		}
+	}
+	
+	bool is_indexable_key( const Value& key )
+	{
+		unsigned long hash;
+		
+		return hash_key( key, hash );
+	}
+	
+	const Expr* indexed_mapping( const Value& array, const Value& key )
+	{
+		unsigned long hash;
+		
+		if ( ! hash_key( key, hash ) )
+		{
+			// No indexed key can match it.
+			
+			return NULL;
+		}
+		
+		const Expr* array_expr = array.expr();
+		
+		table_index* index = load_index( array_expr );
+		
+		if ( index == NULL )
+		{
+			table_index built;
+			
+			build_index( built, array );
+			
+			index = new table_index;
+			
+			index->slots.swap( built.slots );
+			index->count = built.count;
+			index->last  = NULL;
+			
+			/*
+				If another thread indexed the same array in the meantime, use
+				its index instead.
+			*/
+			
+			table_index* other = NULL;
+			
+			if ( ! __atomic_compare_exchange_n( &array_expr->index,
+			                                    &other,
+			                                    index,
+			                                    false,
+			                                    __ATOMIC_ACQ_REL,
+			                                    __ATOMIC_ACQUIRE ) )
+			{
+				delete index;
+				
+				index = other;
+			}
+		}
+		
+		return find_slot( *index, hash, key ).mapping;
+	}
+	
+	static
+	void note_mappings( const Expr* array, const Value& mappings, bool replace )
+	{
+		table_index* index = array->index;
+		
+		if ( index == NULL )
+		{
+			return;
+		}
+		
+		// The array was changed by walking it, so its mappings may have moved.
+		
+		index->last = NULL;
+		
+		list_iterator next( mappings );
+		
+		while ( next )
+		{
+			if ( ! index_mapping( *index, next.use(), replace ) )
+			{
+				forget_table_index( array );
+				
+				break;
+			}
+		}
+	}
+	
+	void note_table_mapping( const Expr* array, const Value& mapping )
+	{
+		/*
+			The mapping was stored at (or is now) the first one with its key,
+			so it replaces any that's indexed already.
+		*/
+		
+		note_mappings( array, mapping, true );
+	}
+	
+	void note_table_mappings( const Expr* array, const Value& mappings )
+	{
+		/*
+			The mappings were appended, so they don't supersede any already
+			present with the same keys.
+		*/
+		
+		note_mappings( array, mappings, false );
+	}
+	
+	void own_table_cells( Value& array )
+	{
+		table_index index;
+		
+		index.slots.resize( min_index_slots );
+		index.count = 0;
+		
+		Value* it = &array.expr()->right;
+		
+		while ( true )
+		{
+			Value& mapping = first_mutable( *it );
+			
+			if ( ! index_mapping( index, mapping, false, &mapping ) )
+			{
+				THROW( "non-mapping in table" );
+			}
+			
+			if ( it->listexpr() == NULL )
+			{
+				index.last = &mapping;
+				break;
+			}
+			
+			it = &rest_mutable( *it );
+		}
+		
+		const Expr* array_expr = array.expr();
+		
+		if ( array_expr->index == NULL )
+		{
+			array_expr->index = new table_index;
+		}
+		
+		table_index& stored = *array_expr->index;
+		
+		stored.slots.swap( index.slots );
+		stored.count = index.count;
+		stored.last  = index.last;
+	}
+	
+	static
+	Value& append_mapping( table_index& index, const Value& key )
+	{
+		Value& last = *index.last;
+		
+		// The last mapping moves into a new cell, ahead of the new mapping.
+		
+		last = Value( last, empty_list );
+		
+		Expr* cell = last.expr();
+		
+		unsigned long hash;
+		
+		if ( hash_key( cell->left.expr()->left, hash ) )
+		{
+			index_slot& slot = find_slot( index, hash, cell->left.expr()->left );
+			
+			if ( slot.mapping == cell->left.expr() )
+			{
+				slot.place = &cell->left;
+			}
+		}
+		
+		cell->right = Value( key, Op_mapping, Value() );
+		
+		index.last = &cell->right;
+		
+		index_mapping( index, cell->right, false, &cell->right );
+		
+		return cell->right;
+	}
+	
+	Value* owned_table_mapping( Value& array, const Value& key )
+	{
+		unsigned long hash;
+		
+		table_index* owned = array.expr()->index;
+		
+		if ( owned == NULL  ||  owned->last == NULL  ||  ! hash_key( key, hash ) )
+		{
+			return NULL;
+		}
+		
+		table_index& index = *owned;
+		
+		/*
+			A copy of the list that's still around would share the first
+			cell.  (It can't share a later one without the first, except
+			through a dereference, which disowns the cells.)
+		*/
+		
+		Value& list = array.expr()->right;
+		
+		const Expr* first = list.expr();
+		
+		if ( list.unshare().expr() != first )
+		{
+			index.last = NULL;
+			
+			return NULL;
+		}
+		
+		index_slot& slot = find_slot( index, hash, key );
+		
+		if ( slot.mapping == NULL )
+		{
+			return &append_mapping( index, key );
+		}
+		
+		Value& mapping = slot.place->unshare();
+		
+		slot.mapping = mapping.expr();
+		
+		return &mapping;
+	}
+	
+	void disown_table_cells( const Expr* array )
+	{
+		/*
+			The array may be shared with other threads doing the same, so
+			only write if the cells are owned.
+		*/
+		
+		if ( table_index* index = load_index( array ) )
+		{
+			if ( __atomic_load_n( &index->last, __ATOMIC_RELAXED ) )
+			{
+				__atomic_store_n( &index->last, (Value*) NULL, __ATOMIC_RELAXED );
+			}
+		}
+	}
+	
+	void forget_table_index( const Expr* array )
+	{
+		delete array->index;
+		
+		array->index = NULL;
+	}
+	
+}
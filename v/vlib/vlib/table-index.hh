@@ -0,0 +1,51 @@
+/*
+	table-index.hh
+	--------------
+*/
+
+#ifndef VLIB_TABLEINDEX_HH
+#define VLIB_TABLEINDEX_HH
+
+// vlib
+#include "vlib/value.hh"
+
+
+namespace vlib
+{
+	
+	/*
+		A table's array can have a hash index of its keys, mapping each one
+		to the first mapping in the array with that key.  It belongs to the
+		array's Expr:  it's built the first time a keyed lookup in the array
+		runs long, kept current as mappings are stored into the array in
+		place, and forgotten when the array is destroyed.  Only the key types
+		that equal_keys() accepts are indexed.
+	*/
+	
+	bool is_indexable_key( const Value& key );
+	
+	const Expr* indexed_mapping( const Value& array, const Value& key );
+	
+	/*
+		For storing into a table:  Once own_table_cells() has unshared all of
+		the array's cells, owned_table_mapping() finds the mapping with a
+		given key (unsharing it) or appends one, without walking the array.
+		It returns NULL if the index doesn't own the cells (any more), or
+		can't hold the key.
+	*/
+	
+	void own_table_cells( Value& array );
+	
+	Value* owned_table_mapping( Value& array, const Value& key );
+	
+	void disown_table_cells( const Expr* array );
+	
+	void note_table_mapping( const Expr* array, const Value& mapping );
+	
+	void note_table_mappings( const Expr* array, const Value& mappings );
+	
+	void forget_table_index( const Expr* array );
+	
+}
+
+#endif
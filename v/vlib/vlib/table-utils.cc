@@ -9,6 +9,7 @@
 #include "vlib/array-utils.hh"
 #include "vlib/equal.hh"
 #include "vlib/list-utils.hh"
+#include "vlib/table-index.hh"
 #include "vlib/throw.hh"
 #include "vlib/iterators/array_iterator.hh"
 #include "vlib/iterators/list_builder.hh"
@@ -18,7 +19,6 @@
 namespace vlib
 {
 	
-	static
 	bool equal_keys( const Value& a, const Value& b )
 	{
 		if ( a.type() != b.type() )
@@ -45,12 +45,29 @@ namespace vlib
 		return equal( a, b );
 	}
 	
+	/*
+		Short tables are searched linearly.  Once a search gets this far, the
+		rest of it (and future ones in the same array) uses the hash index.
+	*/
+	
+	const int linear_search_limit = 8;
+	
 	Value keyed_subscript( const Value& array, const Value& key )
 	{
 		array_iterator it( array );
 		
-		while ( it )
+		for ( int i = 0;  it;  ++i )
 		{
+			if ( i == linear_search_limit )
+			{
+				if ( const Expr* expr = indexed_mapping( array, key ) )
+				{
+					return expr->right;
+				}
+				
+				break;
+			}
+			
 			const Value& mapping = it.use();
 			
 			if ( Expr* expr = mapping.expr() )
@@ -130,12 +147,12 @@ namespace vlib
 			
 			if ( equal_keys( next.expr()->left, key ) )
 			{
-				return next.unshare().expr()->right;
+				return next.unshare();
 			}
 			
 			if ( it->listexpr() == 0 )
 			{
-				// Key not found; create a new mapping.
+				// Key not found; make room for a new mapping.
 				
 				*it = Value( *it, empty_list );
 				
@@ -146,32 +163,88 @@ namespace vlib
 		}
 	}
 	
+	static
+	bool is_long( const Value& array )
+	{
+		const Value* next = &array.expr()->right;
+		
+		for ( int i = 0;  i < linear_search_limit;  ++i )
+		{
+			if ( ! next->listexpr() )
+			{
+				return false;
+			}
+			
+			next = &rest( *next );
+		}
+		
+		return true;
+	}
+	
 	Value* get_table_subscript_addr( Expr* array_expr, const Value& key )
 	{
+		const Expr* original = array_expr->right.expr();
+		
 		Value& array = array_expr->right.unshare();
 		
+		if ( array.expr() != original )
+		{
+			// The original array shares its cells with this copy now.
+			
+			disown_table_cells( original );
+		}
+		
 		Value* it;
 		
+		if ( ! is_empty_array( array )  &&  is_indexable_key( key ) )
+		{
+			/*
+				Past the short-table limit, store through the index, which
+				first has to own the array's cells.
+			*/
+			
+			Value* mapping = owned_table_mapping( array, key );
+			
+			if ( mapping == NULL  &&  is_long( array ) )
+			{
+				own_table_cells( array );
+				
+				mapping = owned_table_mapping( array, key );
+			}
+			
+			if ( mapping )
+			{
+				return &mapping->expr()->right;
+			}
+		}
+		
 		if ( ! is_empty_array( array ) )
 		{
 			Value& list  = array.expr()->right;
 			
 			it = &find_key_mutable( list, key );
 			
-			if ( ! is_empty_list( *it ) )
+			if ( is_empty_list( *it ) )
 			{
-				return it;
+				*it = Value( key, Op_mapping, Value() );
 			}
+			
+			/*
+				Either way, the mapping's Expr may be new, and any index of
+				the array has to point to it.
+			*/
+			
+			note_table_mapping( array.expr(), *it );
 		}
 		else
 		{
 			array = make_array( Value() );
 			
 			it = &array.expr()->right;
+			
+			*it = Value( key, Op_mapping, Value() );
 		}
 		
-		*it = Value( key, Op_mapping, Value() );
-		
 		return &it->expr()->right;
 	}
 	
@@ -13,6 +13,8 @@
 namespace vlib
 {
 	
+	bool equal_keys( const Value& a, const Value& b );
+	
 	Value keyed_subscript( const Value& array, const Value& key );
 	
 	Value associative_subscript( const Value& table, const Value& key );
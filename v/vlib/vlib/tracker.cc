@@ -7,6 +7,7 @@
 
 // POSIX
 #include <pthread.h>
+#include <time.h>
 
 // Standard C++
 #include <vector>
@@ -32,20 +33,39 @@ namespace vlib
 {
 	
 	/*
-		Reset (all roots and tracked symbols):
-			clear -> PRUNE
-			white -> PRUNE
+		Tracked symbols are divided into two generations:  The young ones
+		have been tracked since the last cull, and the old ones have survived
+		at least one.  A minor cull considers only the young symbols.  Old
+		symbols are presumed to be reachable, so marking stops at them --
+		except for the dirty ones (old symbols modified since the last cull),
+		whose values are marked from as though they were roots.  An untracked
+		symbol that marking reaches gets a shadow mark, so that if it's
+		tracked later, it starts out dirty instead of young, since it might
+		be contained in an old value that won't be traversed.  A full cull
+		considers every tracked symbol, including old ones that are no
+		longer reachable.
+		
+		Culls run when a young generation's worth of symbols have been
+		tracked since the last one, and a cull is a full one when the old
+		generation has doubled since the last full cull.
+		
+		Reset (tracked symbols, young only for a minor cull):
 			black -> white
+			old   -> white [full cull]
+			dirty -> white [full cull]
 		
-		Mark (roots only):
-			clear -> PRUNE
-			white -> black
-			black -> PRUNE
+		Mark (roots, and the values of dirty symbols):
+			clear  -> shadow, PRUNE
+			white  -> black
+			others -> PRUNE
 		
-		Sweep (tracked symbols only):
-			clear -> PRUNE
-			white -> clear [removed]
-			black -> PRUNE
+		Sweep (tracked symbols, young only for a minor cull):
+			white  -> clear [removed]
+			others -> PRUNE
+		
+		Promote (tracked symbols):
+			black -> old
+			dirty -> old
 	*/
 	
 	typedef std::vector< Value > tracked_set;
@@ -53,8 +73,22 @@ namespace vlib
 	static tracked_set tracked_symbols;
 	static tracked_set tracked_roots;
 	
+	static std::vector< Symbol* > dirty_symbols;
+	
+	const size_t young_budget = 256;
+	
+	const size_t min_old_budget = 1024;
+	
+	static size_t n_old = 0;  // tracked_symbols[ 0 .. n_old ) are old
+	
+	static size_t old_budget = min_old_budget;
+	
 	static size_t n_steps = 0;
 	static size_t n_culls = 0;
+	static size_t n_full_culls = 0;
+	static size_t n_freed = 0;
+	
+	static unsigned long long pause_usecs = 0;
 	
 	static pthread_mutex_t gc_mutex = PTHREAD_MUTEX_INITIALIZER;
 	
@@ -80,7 +114,7 @@ namespace vlib
 	static inline
 	bool is_tracked( const Symbol* sym )
 	{
-		return sym->mark() != Mark_none;
+		return sym->mark() != Mark_none  &&  sym->mark() != Mark_shadow;
 	}
 	
 	void track_symbol( const Value& v )
@@ -97,7 +131,28 @@ namespace vlib
 		{
 			tracked_symbols.push_back( v );
 			
-			sym->set_mark( Mark_black );
+			if ( sym->mark() == Mark_shadow )
+			{
+				dirty_symbols.push_back( sym );
+				
+				sym->set_mark( Mark_dirty );
+			}
+			else
+			{
+				sym->set_mark( Mark_black );
+			}
+		}
+	}
+	
+	void remember_modified_symbol( Symbol* sym )
+	{
+		gc_lock lock;
+		
+		if ( sym->mark() == Mark_old )
+		{
+			dirty_symbols.push_back( sym );
+			
+			sym->set_mark( Mark_dirty );
 		}
 	}
 	
@@ -160,39 +215,77 @@ namespace vlib
 	}
 	
 	static
-	void set_marks( const Value& src, mark_type old_mark, mark_type new_mark )
+	void reset_marks( size_t begin, bool full )
+	{
+		typedef tracked_set::iterator Iter;
+		
+		const Iter end = tracked_symbols.end();
+		
+		for ( Iter it = tracked_symbols.begin() + begin;  it != end;  ++it )
+		{
+			Symbol* sym = it->sym();
+			
+			if ( sym->mark() == Mark_black  ||  full )
+			{
+				sym->set_mark( Mark_white );
+			}
+		}
+		
+		if ( full )
+		{
+			dirty_symbols.clear();
+		}
+	}
+	
+	static
+	void mark( const Value& src )
 	{
 		full_iterator it( src );
 		
 		while ( Symbol* sym = next_symbol( it ) )
 		{
-			if ( sym->mark() == old_mark )
+			if ( sym->mark() == Mark_white )
 			{
-				sym->set_mark( new_mark );
+				sym->set_mark( Mark_black );
 				
 				++it;
 			}
 			else
 			{
+				if ( sym->mark() == Mark_none )
+				{
+					sym->set_mark( Mark_shadow );
+				}
+				
 				it.prune();
 			}
 		}
 	}
 	
 	static
-	void set_marks( tracked_set& set, mark_type old_mark, mark_type new_mark )
+	void mark()
 	{
 		typedef tracked_set::iterator Iter;
 		
-		const Iter begin = set.begin();
+		const Iter begin = tracked_roots.begin();
 		
-		Iter it = set.end();
+		Iter it = tracked_roots.end();
 		
 		while ( it > begin )
 		{
 			--it;
 			
-			set_marks( *it, old_mark, new_mark );
+			mark( *it );
+		}
+		
+		typedef std::vector< Symbol* >::const_iterator Jter;
+		
+		for ( Jter jt = dirty_symbols.begin();  jt != dirty_symbols.end();  ++jt )
+		{
+			const Symbol* sym = *jt;
+			
+			mark( sym->vtype() );
+			mark( sym->get()   );
 		}
 	}
 	
@@ -213,6 +306,8 @@ namespace vlib
 				sym->set_mark( Mark_none );
 				
 				sym->expire();
+				
+				++n_freed;
 			}
 			else
 			{
@@ -222,11 +317,11 @@ namespace vlib
 	}
 	
 	static
-	void sweep( tracked_set& garbage )
+	void sweep( size_t begin_index, tracked_set& garbage )
 	{
 		typedef tracked_set::iterator Iter;
 		
-		const Iter begin = tracked_symbols.begin();
+		const Iter begin = tracked_symbols.begin() + begin_index;
 		
 		Iter it = tracked_symbols.end();
 		
@@ -260,32 +355,115 @@ namespace vlib
 	}
 	
 	static
-	void cull_unreachable_objects( tracked_set& garbage )
+	void promote( size_t begin )
 	{
-		// Reset
-		set_marks( tracked_symbols, Mark_black, Mark_white );
-		set_marks( tracked_roots,   Mark_black, Mark_white );
+		typedef tracked_set::iterator Iter;
+		
+		const Iter end = tracked_symbols.end();
+		
+		for ( Iter it = tracked_symbols.begin() + begin;  it != end;  ++it )
+		{
+			Symbol* sym = it->sym();
+			
+			if ( sym->mark() == Mark_black )
+			{
+				sym->set_mark( Mark_old );
+			}
+		}
 		
-		// Mark
-		set_marks( tracked_roots, Mark_white, Mark_black );
+		typedef std::vector< Symbol* >::const_iterator Jter;
 		
-		sweep( garbage );
+		for ( Jter jt = dirty_symbols.begin();  jt != dirty_symbols.end();  ++jt )
+		{
+			(*jt)->set_mark( Mark_old );
+		}
+		
+		dirty_symbols.clear();
+		
+		n_old = tracked_symbols.size();
 	}
 	
-	void cull_unreachable_objects()
+	static
+	void cull_unreachable_objects( tracked_set& garbage, bool full )
+	{
+		const size_t begin = full ? 0 : n_old;
+		
+		reset_marks( begin, full );
+		
+		mark();
+		
+		sweep( begin, garbage );
+		
+		promote( begin );
+		
+		if ( full )
+		{
+			old_budget = n_old * 2;
+			
+			if ( old_budget < min_old_budget )
+			{
+				old_budget = min_old_budget;
+			}
+			
+			++n_full_culls;
+		}
+		
+		++n_culls;
+	}
+	
+	static inline
+	unsigned long long clock_usecs()
+	{
+		timespec ts;
+		
+		clock_gettime( CLOCK_MONOTONIC, &ts );
+		
+		return ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+	}
+	
+	/*
+		If only_if_due is set, cull only if enough young symbols have been
+		tracked, and only the young ones unless the old budget is exceeded
+		too.  Either way, the decision is made while holding the lock, since
+		other threads may be tracking symbols.
+	*/
+	
+	static
+	void cull_unreachable_objects( bool only_if_due )
 	{
 		tracked_set garbage;
 		
 		gc_lock lock;
 		
-		cull_unreachable_objects( garbage );
+		const size_t n = tracked_symbols.size();
 		
-		++n_culls;
+		if ( only_if_due  &&  n - n_old < young_budget )
+		{
+			return;
+		}
+		
+		const bool full = ! only_if_due  ||  n >= old_budget;
+		
+		const unsigned long long start = clock_usecs();
+		
+		cull_unreachable_objects( garbage, full );
+		
+		pause_usecs += clock_usecs() - start;
 		
 		// release lock
 		// dispose garbage
 	}
 	
+	void cull_unreachable_objects()
+	{
+		cull_unreachable_objects( false );
+	}
+	
+	void cull_unreachable_objects_if_due()
+	{
+		cull_unreachable_objects( true );
+	}
+	
 	struct garbage_collector
 	{
 		~garbage_collector()
@@ -329,6 +507,26 @@ namespace vlib
 			return Integer( n_culls );
 		}
 		
+		if ( name == "full-culls" )
+		{
+			return Integer( n_full_culls );
+		}
+		
+		if ( name == "young" )
+		{
+			return Integer( tracked_symbols.size() - n_old );
+		}
+		
+		if ( name == "freed" )
+		{
+			return Integer( n_freed );
+		}
+		
+		if ( name == "pause" )
+		{
+			return Integer( pause_usecs );
+		}
+		
 		if ( name == "cull" )
 		{
 			return Proc( proc_cull );
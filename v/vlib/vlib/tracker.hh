@@ -10,6 +10,7 @@
 namespace vlib
 {
 	
+	class Symbol;
 	class Value;
 	struct namespace_info;
 	
@@ -17,11 +18,15 @@ namespace vlib
 	
 	void track_symbol( const Value& v );
 	
+	void remember_modified_symbol( Symbol* sym );
+	
 	void add_root( const Value& v );
 	void del_root( const Value& v );
 	
 	void cull_unreachable_objects();
 	
+	void cull_unreachable_objects_if_due();
+	
 	class scoped_root
 	{
 		private:
@@ -63,6 +63,77 @@ namespace vlib
 	
 	extern const type_info integer_vtype;
 	
+	/*
+		An integer that fits in a machine word is stored inline in its ibox,
+		with no allocation.  Such a fixnum can be operated on directly as a
+		long, as long as the result is checked for overflow; only then does
+		the operation need to fall back to bignum arithmetic.
+	*/
+	
+	inline
+	bool get_fixnum( const Value& v, long& x )
+	{
+		if ( v.type() == Value_number )
+		{
+			const bignum::integer& i = v.number();
+			
+			if ( i.demotes_to< long >() )
+			{
+				x = i.clipped_to< long >();
+				
+				return true;
+			}
+		}
+		
+		return false;
+	}
+	
+	const long fixnum_max = long( ~0ul >> 1 );
+	const long fixnum_min = -fixnum_max - 1;
+	
+	inline
+	bool fixnum_add( long a, long b, long& sum )
+	{
+		if ( b > 0 ? a > fixnum_max - b : a < fixnum_min - b )
+		{
+			return false;
+		}
+		
+		sum = a + b;
+		
+		return true;
+	}
+	
+	inline
+	bool fixnum_subtract( long a, long b, long& difference )
+	{
+		if ( b < 0 ? a > fixnum_max + b : a < fixnum_min + b )
+		{
+			return false;
+		}
+		
+		difference = a - b;
+		
+		return true;
+	}
+	
+	inline
+	bool fixnum_multiply( long a, long b, long& product )
+	{
+		// Accept factors of up to half a word, whose product can't overflow.
+		
+		const long half = 1L << (sizeof (long) * 4 - 1);
+		
+		if ( a <= -half  ||  a >= half  ||  b <= -half  ||  b >= half )
+		{
+			return false;
+		}
+		
+		product = a * b;
+		
+		return true;
+	}
+	
 	struct bad_cast_thrower
 	{
 		void operator()() const;
@@ -9,6 +9,7 @@
 #include "vlib/array-utils.hh"
 #include "vlib/assign.hh"
 #include "vlib/is_type.hh"
+#include "vlib/table-index.hh"
 #include "vlib/throw.hh"
 #include "vlib/dispatch/dispatch.hh"
 #include "vlib/dispatch/operators.hh"
@@ -83,6 +84,8 @@ namespace vlib
 		const Target target = { &array, &array_type };
 		
 		push( target, new_elements );
+		
+		note_table_mappings( array.expr(), new_elements );
 	}
 	
 	static
@@ -14,6 +14,9 @@
 // plus
 #include "plus/extent.hh"
 
+// vlib
+#include "vlib/table-index.hh"
+
 
 namespace vlib
 {
@@ -40,6 +43,11 @@ namespace vlib
 				next_extent = (Expr*) next.its_box.transfer_extent();
 			}
 			
+			if ( expr->index )
+			{
+				forget_table_index( expr );
+			}
+			
 			expr->~Expr();
 			
 			if ( expr != pointer )
@@ -211,6 +219,11 @@ namespace vlib
 			}
 			
 			its_box.unshare();
+			
+			if ( Expr* exp = expr() )
+			{
+				exp->index = NULL;  // the original keeps its index
+			}
 		}
 		
 		return *this;
@@ -224,7 +237,8 @@ namespace vlib
 		op( op ),
 		left( a ),
 		right( b ),
-		source( s )
+		source( s ),
+		index()
 	{
 	}
 	
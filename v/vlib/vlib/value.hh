@@ -33,6 +33,7 @@ namespace vlib
 	};
 	
 	struct dispatch;
+	struct table_index;
 	struct type_info;
 	struct Expr;
 	class Symbol;
@@ -320,6 +321,8 @@ namespace vlib
 		
 		const source_spec source;
 		
+		mutable table_index* index;  // for an Op_array, see table-index.hh
+		
 		Expr( const Value&        a,
 		      op_type             op,
 		      const Value&        b,
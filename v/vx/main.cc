@@ -8,6 +8,7 @@
 
 // Standard C
 #include <signal.h>
+#include <stdlib.h>
 #include <string.h>
 
 // Standard C++
@@ -29,6 +30,7 @@
 
 // vlib
 #include "vlib/array-utils.hh"
+#include "vlib/bytecode.hh"
 #include "vlib/interpret.hh"
 #include "vlib/scope.hh"
 #include "vlib/types.hh"
@@ -43,6 +45,7 @@
 #include "empty_signal_handler.hh"
 #include "file_descriptor.hh"
 #include "library.hh"
+#include "parallel.hh"
 #include "posixfs.hh"
 #include "sockets.hh"
 #include "thread.hh"
@@ -68,12 +71,14 @@ const int thread_interrupt_signal = SIGUSR1;
 
 enum
 {
+	Opt_bytecode      = 'B',
 	Opt_unrestricted  = 'Z',
 	Opt_inline_script = 'e',
 };
 
 static command::option options[] =
 {
+	{ "bytecode",       Opt_bytecode },
 	{ "inline-script",  Opt_inline_script, Param_required },
 	{ "unrestricted",   Opt_unrestricted },
 	{ NULL }
@@ -100,10 +105,18 @@ static char* const* get_options( char** argv )
 	
 	++argv;  // skip arg 0
 	
+	// Setting V_BYTECODE runs a test suite with the bytecode interpreter.
+	
+	bytecode_enabled = getenv( "V_BYTECODE" ) != NULL;
+	
 	while ( (opt = command::get_option( (char* const**) &argv, options )) > 0 )
 	{
 		switch ( opt )
 		{
+			case Opt_bytecode:
+				bytecode_enabled = true;
+				break;
+			
 			case Opt_inline_script:
 				inline_script = command::global_result.param;
 				break;
@@ -268,7 +281,10 @@ int main( int argc, char** argv )
 	define( proc_listdir  );
 	define( proc_load     );
 	define( proc_lstat    );
+	define( proc_pfilter  );
 	define( proc_pipe     );
+	define( proc_pmap     );
+	define( proc_preduce  );
 	define( proc_print    );
 	define( proc_read     );
 	define( proc_reader   );
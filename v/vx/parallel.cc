@@ -0,0 +1,269 @@
+/*
+	parallel.cc
+	-----------
+*/
+
+#include "parallel.hh"
+
+// POSIX
+#include <unistd.h>
+
+// Standard C++
+#include <vector>
+
+// vlib
+#include "vlib/array-utils.hh"
+#include "vlib/list-utils.hh"
+#include "vlib/map-reduce.hh"
+#include "vlib/pure.hh"
+#include "vlib/throw.hh"
+#include "vlib/types.hh"
+#include "vlib/iterators/generic_iterator.hh"
+#include "vlib/iterators/list_builder.hh"
+#include "vlib/types/proc.hh"
+
+// vx
+#include "thread.hh"
+#include "thread_state.hh"
+
+
+#ifndef NULL
+#define NULL  0
+#endif
+
+
+namespace vlib
+{
+	
+	/*
+		pmap, pfilter, and preduce are parallel versions of map, ver, and per.
+		The container's elements are split into contiguous chunks, one for
+		each worker thread (of which there are no more than there are online
+		processors), and each worker runs the serial operation on its chunk.
+		The results are assembled in order.  preduce requires an associative
+		reducer, since each chunk is reduced separately before the partial
+		results are.
+		
+		A function that isn't pure might depend on the order in which it's
+		called, so in that case (or if there's only one processor), the
+		serial operation runs instead.
+	*/
+	
+	typedef std::vector< Value > value_vector;
+	
+	static
+	unsigned long max_workers()
+	{
+		const long n = sysconf( _SC_NPROCESSORS_ONLN );
+		
+		return n > 0 ? n : 1;
+	}
+	
+	static
+	Value v_map_chunk( const Value& v )
+	{
+		return map( first( v ), rest( v ) );
+	}
+	
+	static
+	Value v_filter_chunk( const Value& v )
+	{
+		return filter( first( v ), rest( v ) );
+	}
+	
+	static
+	Value v_reduce_chunk( const Value& v )
+	{
+		return reduce( first( v ), rest( v ) );
+	}
+	
+	static const proc_info proc_map_chunk    = { "pmap",    &v_map_chunk,    NULL };
+	static const proc_info proc_filter_chunk = { "pfilter", &v_filter_chunk, NULL };
+	static const proc_info proc_reduce_chunk = { "preduce", &v_reduce_chunk, NULL };
+	
+	/*
+		Returns false if the work should be done serially.  Otherwise, runs
+		the worker on each chunk of the container (with f) and stores each
+		chunk's result in results, in order.
+	*/
+	
+	static
+	bool run_chunks( const Value&      container,
+	                 const Value&      f,
+	                 const proc_info&  worker,
+	                 value_vector&     results )
+	{
+		const unsigned long n_workers = max_workers();
+		
+		if ( n_workers < 2  ||  ! is_pure( f ) )
+		{
+			return false;
+		}
+		
+		value_vector items;
+		
+		generic_iterator it( container );
+		
+		while ( it )
+		{
+			items.push_back( it.use() );
+		}
+		
+		const unsigned long n = items.size();
+		
+		if ( n < 2 )
+		{
+			return false;
+		}
+		
+		const unsigned long n_chunks = n < n_workers ? n : n_workers;
+		
+		// Each thread is joined when its Value is destroyed, if not before.
+		
+		value_vector threads;
+		
+		threads.reserve( n_chunks );
+		
+		unsigned long i = 0;
+		
+		for ( unsigned long k = 1;  k <= n_chunks;  ++k )
+		{
+			const unsigned long end = n * k / n_chunks;
+			
+			list_builder chunk;
+			
+			while ( i < end )
+			{
+				chunk.append( items[ i++ ] );
+			}
+			
+			const Value arguments( make_array( chunk ), f );
+			
+			threads.push_back( Thread( bind_args( Proc( worker ), arguments ) ) );
+		}
+		
+		results.reserve( n_chunks );
+		
+		typedef value_vector::const_iterator Iter;
+		
+		for ( Iter it = threads.begin();  it != threads.end();  ++it )
+		{
+			const Thread& thread = static_cast< const Thread& >( *it );
+			
+			// This joins the thread, and rethrows any exception it threw.
+			
+			results.push_back( **thread.get() );
+		}
+		
+		return true;
+	}
+	
+	static
+	Value concatenate( const value_vector& arrays )
+	{
+		list_builder result;
+		
+		typedef value_vector::const_iterator Iter;
+		
+		for ( Iter it = arrays.begin();  it != arrays.end();  ++it )
+		{
+			generic_iterator jt( *it );
+			
+			while ( jt )
+			{
+				result.append( jt.use() );
+			}
+		}
+		
+		return make_array( result );
+	}
+	
+	static
+	Value v_pmap( const Value& v )
+	{
+		const Value& container = first( v );
+		const Value& f         = rest ( v );
+		
+		if ( ! is_functional( f ) )
+		{
+			THROW( "pmap requires a function" );
+		}
+		
+		value_vector results;
+		
+		if ( ! run_chunks( container, f, proc_map_chunk, results ) )
+		{
+			return map( container, f );
+		}
+		
+		return concatenate( results );
+	}
+	
+	static
+	Value v_pfilter( const Value& v )
+	{
+		const Value& container = first( v );
+		const Value& f         = rest ( v );
+		
+		if ( ! is_functional( f ) )
+		{
+			THROW( "pfilter requires a function" );
+		}
+		
+		value_vector results;
+		
+		if ( ! run_chunks( container, f, proc_filter_chunk, results ) )
+		{
+			return filter( container, f );
+		}
+		
+		return concatenate( results );
+	}
+	
+	static
+	Value v_preduce( const Value& v )
+	{
+		const Value& container = first( v );
+		const Value& reducer   = rest ( v );
+		
+		const Value* f = &reducer;
+		
+		if ( Expr* expr = reducer.expr() )
+		{
+			if ( expr->op == Op_forward_init )
+			{
+				f = &expr->right;
+			}
+		}
+		
+		if ( ! is_functional( *f ) )
+		{
+			THROW( "preduce requires a function" );
+		}
+		
+		value_vector partials;
+		
+		if ( ! run_chunks( container, *f, proc_reduce_chunk, partials ) )
+		{
+			return reduce( container, reducer );
+		}
+		
+		list_builder result;
+		
+		typedef value_vector::const_iterator Iter;
+		
+		for ( Iter it = partials.begin();  it != partials.end();  ++it )
+		{
+			result.append( *it );
+		}
+		
+		// Any initial value is folded in here, before the first partial.
+		
+		return reduce( make_array( result ), reducer );
+	}
+	
+	const proc_info proc_pfilter = { "pfilter", &v_pfilter, NULL };
+	const proc_info proc_pmap    = { "pmap",    &v_pmap,    NULL };
+	const proc_info proc_preduce = { "preduce", &v_preduce, NULL };
+	
+}
@@ -0,0 +1,22 @@
+/*
+	parallel.hh
+	-----------
+*/
+
+#ifndef PARALLEL_HH
+#define PARALLEL_HH
+
+// vlib
+#include "vlib/proc_info.hh"
+
+
+namespace vlib
+{
+	
+	extern const proc_info proc_pfilter;
+	extern const proc_info proc_pmap;
+	extern const proc_info proc_preduce;
+	
+}
+
+#endif
@@ -0,0 +1,44 @@
+#!/usr/bin/env jtest
+
+$ vx -e 'def sq (x) { return x * x }; print rep pmap( 1 .. 10, sq )'
+1 >= '[1, 4, 9, 16, 25, 36, 49, 64, 81, 100]'
+
+%
+
+$ vx -e 'print rep pmap( [], half )'
+1 >= '[]'
+
+%
+
+$ vx -e 'print rep pfilter( 0 -> 20, {_ % 3 == 0} )'
+1 >= '[0, 3, 6, 9, 12, 15, 18]'
+
+%
+
+$ vx -e 'def add (x, y) { return x + y }; print rep preduce( 1 .. 100, add )'
+1 >= '5050'
+
+%
+
+$ vx -e 'def add (x, y) { return x + y }; print rep preduce( 1 .. 10, 100 >- add )'
+1 >= '155'
+
+%
+
+$ vx -e 'def add (x, y) { return x + y }; print rep preduce( [], add )'
+1 >= '()'
+
+%
+
+$ vx -e 'var n = 0; print rep pmap( 1 .. 5, {++n} )'
+1 >= '[1, 2, 3, 4, 5]'
+
+%
+
+$ vx -e 'print rep (try {pmap( 1 .. 5, {throw _} )} catch {"caught " _})'
+1 >= '"caught 1"'
+
+%
+
+$ vx -e 'try { pmap( 1 .. 5, "not a function" ) } catch { print "nope" }'
+1 >= 'nope'
@@ -0,0 +1,227 @@
+/*
+	fork_each.cc
+	------------
+*/
+
+#include "fork_each.hh"
+
+// Standard C
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+// POSIX
+#include <unistd.h>
+#include <sys/wait.h>
+
+// more
+#include "more/perror.hh"
+
+
+#pragma exceptions off
+
+
+struct child_run
+{
+	pid_t  pid;
+	int    out;  // captured standard output
+	int    err;  // captured standard error
+	int    status;
+	bool   done;
+};
+
+static
+int open_capture_file()
+{
+	char path[] = "/tmp/xv68k-XXXXXX";
+	
+	int fd = mkstemp( path );
+	
+	if ( fd >= 0 )
+	{
+		unlink( path );
+	}
+	
+	return fd;
+}
+
+static
+void replay( int fd, int dest )
+{
+	if ( fd < 0 )
+	{
+		return;
+	}
+	
+	char buffer[ 4096 ];
+	
+	ssize_t n_read;
+	
+	lseek( fd, 0, SEEK_SET );
+	
+	while ( (n_read = read( fd, buffer, sizeof buffer )) > 0 )
+	{
+		write( dest, buffer, n_read );
+	}
+	
+	close( fd );
+}
+
+static
+pid_t start( child_run& child, char* path, program_runner run, void* param )
+{
+	child.out = open_capture_file();
+	child.err = open_capture_file();
+	
+	if ( child.out < 0  ||  child.err < 0 )
+	{
+		return -1;
+	}
+	
+	pid_t pid = fork();
+	
+	if ( pid == 0 )
+	{
+		dup2( child.out, STDOUT_FILENO );
+		dup2( child.err, STDERR_FILENO );
+		
+		close( child.out );
+		close( child.err );
+		
+		exit( run( param, path ) );
+	}
+	
+	return pid;
+}
+
+static
+child_run* find_child( child_run* begin, child_run* end, pid_t pid )
+{
+	for ( child_run* it = begin;  it != end;  ++it )
+	{
+		if ( it->pid == pid  &&  ! it->done )
+		{
+			return it;
+		}
+	}
+	
+	return NULL;
+}
+
+static
+bool succeeded( const child_run& child, const char* path )
+{
+	const int status = child.status;
+	
+	if ( WIFSIGNALED( status ) )
+	{
+		more::perror( "xv68k", path, strsignal( WTERMSIG( status ) ) );
+	}
+	
+	return WIFEXITED( status )  &&  WEXITSTATUS( status ) == 0;
+}
+
+int fork_each( char* const*    programs,
+               int             n,
+               int             n_jobs,
+               program_runner  run,
+               void*           param )
+{
+	child_run* children = (child_run*) calloc( n, sizeof (child_run) );
+	
+	if ( children == NULL )
+	{
+		return 1;
+	}
+	
+	if ( n_jobs <= 0 )
+	{
+		n_jobs = sysconf( _SC_NPROCESSORS_ONLN );
+	}
+	
+	if ( n_jobs <= 0 )
+	{
+		n_jobs = 1;
+	}
+	
+	int n_started  = 0;
+	int n_running  = 0;
+	int n_replayed = 0;
+	
+	bool failed = false;
+	
+	while ( n_replayed < n )
+	{
+		while ( n_started < n  &&  n_running < n_jobs )
+		{
+			child_run& child = children[ n_started ];
+			
+			char* path = programs[ n_started++ ];
+			
+			child.pid = start( child, path, run, param );
+			
+			if ( child.pid < 0 )
+			{
+				more::perror( "xv68k", path );
+				
+				child.status = 1 << 8;  // as if by exit( 1 )
+				child.done   = true;
+				
+				continue;
+			}
+			
+			++n_running;
+		}
+		
+		/*
+			Replay output in program order, as soon as every earlier
+			program's output has been replayed.
+		*/
+		
+		while ( n_replayed < n  &&  children[ n_replayed ].done )
+		{
+			child_run& child = children[ n_replayed ];
+			
+			replay( child.out, STDOUT_FILENO );
+			replay( child.err, STDERR_FILENO );
+			
+			if ( ! succeeded( child, programs[ n_replayed ] ) )
+			{
+				failed = true;
+			}
+			
+			++n_replayed;
+		}
+		
+		if ( n_running == 0 )
+		{
+			continue;
+		}
+		
+		int status;
+		
+		const pid_t pid = wait( &status );
+		
+		if ( pid < 0 )
+		{
+			if ( errno == EINTR )
+			{
+				continue;
+			}
+			
+			abort();
+		}
+		
+		if ( child_run* child = find_child( children, children + n, pid ) )
+		{
+			child->status = status;
+			child->done   = true;
+			
+			--n_running;
+		}
+	}
+	
+	free( children );
+	
+	return failed;
+}
@@ -0,0 +1,31 @@
+/*
+	fork_each.hh
+	------------
+*/
+
+#ifndef FORKEACH_HH
+#define FORKEACH_HH
+
+
+/*
+	fork_each() runs each of n programs in its own forked child, with up to
+	n_jobs at a time (or one per online processor if n_jobs is zero).  The
+	children share the parent's booted machine (guest low memory and alloc
+	blocks included) copy-on-write, so each starts from the same state
+	without booting again.  In the child, run() is called with the
+	program's path, and its result becomes the exit status.
+
+	Each child's standard output and error are captured and then replayed
+	in program order, so the output matches that of running them serially.
+	The result is zero if every child exited zero, and one otherwise.
+*/
+
+typedef int (*program_runner)( void* param, char* path );
+
+int fork_each( char* const*    programs,
+               int             n,
+               int             n_jobs,
+               program_runner  run,
+               void*           param );
+
+#endif
@@ -0,0 +1,49 @@
+/*
+	idle.cc
+	-------
+*/
+
+#include "idle.hh"
+
+// Standard C
+#include <stddef.h>
+
+// POSIX
+#include <sys/select.h>
+
+// v68k-time
+#include "v68k-time/clock.hh"
+
+
+#pragma exceptions off
+
+
+void wait_for_tick_or_event( int events_fd )
+{
+	using namespace v68k::time;
+	
+	const uint64_t delta = microsecond_clock() - initial_clock;
+	
+	const unsigned microseconds_per_tick = 1000 * 1000 / 60;
+	
+	// Wake on the tick boundary, as get_Ticks() counts them.
+	
+	const long wakeup = microseconds_per_tick - delta % microseconds_per_tick;
+	
+	timeval timeout = { 0, wakeup };
+	
+	fd_set readfds;
+	
+	FD_ZERO( &readfds );
+	
+	int n_fds = 0;
+	
+	if ( events_fd >= 0 )
+	{
+		FD_SET( events_fd, &readfds );
+		
+		n_fds = events_fd + 1;
+	}
+	
+	select( n_fds, &readfds, NULL, NULL, &timeout );  // EINTR is fine too
+}
@@ -0,0 +1,20 @@
+/*
+	idle.hh
+	-------
+*/
+
+#ifndef IDLE_HH
+#define IDLE_HH
+
+
+/*
+	A processor stopped by STOP is idle until the host interrupts it, which
+	happens (when polling) on each tick and on input.  Rather than spin,
+	wait_for_tick_or_event() blocks until the next tick of guest time is
+	due, or until events_fd (unless negative) has input to read, whichever
+	comes first.
+*/
+
+void wait_for_tick_or_event( int events_fd );
+
+#endif
@@ -0,0 +1,94 @@
+/*
+	machine.cc
+	----------
+*/
+
+#include "machine.hh"
+
+// Standard C
+#include <stdlib.h>
+#include <string.h>
+
+// v68k-alloc
+#include "v68k-alloc/memory.hh"
+
+
+#pragma exceptions off
+
+
+machine::machine( uint8_t*            low_mem_base,
+                  uint32_t            low_mem_size,
+                  v68k::bkpt_handler  bkpt )
+:
+	low_memory( low_mem_base ),
+	low_memory_size( low_mem_size ),
+	memory( *this ),
+	emu( v68k::mc68000, memory, bkpt ),
+	program_address(),
+	n_instructions(),
+	exit_status()
+{
+}
+
+machine::~machine()
+{
+	uint32_t n;
+	uint32_t addr = 0;
+	
+	while ( (addr = v68k::alloc::next_block( alloc_pages, addr, n )) )
+	{
+		v68k::alloc::deallocate( alloc_pages, addr );
+	}
+}
+
+bool machine::copy( const machine& other )
+{
+	using namespace v68k::alloc;
+	
+	memcpy( low_memory, other.low_memory, low_memory_size );
+	
+	uint32_t n;
+	uint32_t addr = 0;
+	
+	while ( (addr = next_block( other.alloc_pages, addr, n )) )
+	{
+		const uint32_t size = n << page_size_bits;
+		
+		void* alloc = malloc( size );
+		
+		if ( alloc == NULL )
+		{
+			return false;
+		}
+		
+		memcpy( alloc, other.alloc_pages.pages[ (addr - start) / page_size ], size );
+		
+		if ( ! allocate_n_pages_at( alloc_pages, addr, n, alloc ) )
+		{
+			free( alloc );
+			
+			return false;
+		}
+		
+		addr += size;
+	}
+	
+	mac_globals       = other.mac_globals;
+	screen_lock_level = other.screen_lock_level;
+	
+	emu.set_SR( other.emu.get_SR() );
+	
+	memcpy( emu.regs, other.emu.regs, sizeof emu.regs );
+	
+	emu.opcode    = other.emu.opcode;
+	emu.condition = other.emu.condition;
+	
+	emu.set_instruction_count( other.emu.instruction_count() );
+	
+	program_address = other.program_address;
+	n_instructions  = other.n_instructions;
+	
+	tlb.flush();
+	
+	return true;
+}
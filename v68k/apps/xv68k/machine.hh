@@ -0,0 +1,81 @@
+/*
+	machine.hh
+	----------
+*/
+
+#ifndef MACHINE_HH
+#define MACHINE_HH
+
+// v68k
+#include "v68k/block_cache.hh"
+#include "v68k/emulator.hh"
+#include "v68k/tlb.hh"
+
+// v68k-mac
+#include "v68k-mac/memory.hh"
+
+// v68k-callouts
+#include "callout/context.hh"
+
+// xv68k
+#include "memory.hh"
+
+
+/*
+	A machine is one guest:  its low memory, alloc pages and Mac low memory
+	globals (the latter two via callout::context), its processor, and the
+	host's caches for it.  One process can run many machines, as long as
+	each is run by only one thread at a time.  Only one of them can have
+	the screen, which belongs to the process.
+	
+	The low memory buffer belongs to the caller.  Alloc blocks belong to
+	the machine, and are released when it's destroyed.
+*/
+
+class machine : public v68k::callout::context
+{
+	private:
+		// non-copyable
+		machine           ( const machine& );
+		machine& operator=( const machine& );
+	
+	public:
+		uint8_t* const  low_memory;
+		const uint32_t  low_memory_size;
+		
+		v68k::mac::globals  mac_globals;
+		
+		v68k::tlb          tlb;
+		v68k::block_cache  block_cache;
+		
+		const memory_manager  memory;
+		
+		v68k::emulator  emu;
+		
+		uint32_t       program_address;  // where the program was loaded
+		unsigned long  n_instructions;
+		
+		int  exit_status;  // set by exit() when contained
+		
+		machine( uint8_t*            low_mem_base,
+		         uint32_t            low_mem_size,
+		         v68k::bkpt_handler  bkpt );
+		
+		~machine();
+		
+		/*
+			Make this machine a copy of another (with the same low memory
+			size), as it stands between instructions.  Returns false if
+			an alloc block can't be duplicated.
+		*/
+		
+		bool copy( const machine& other );
+};
+
+inline
+machine& get_machine( const v68k::processor_state& s )
+{
+	return static_cast< machine& >( v68k::callout::get_context( s ) );
+}
+
+#endif
@@ -10,6 +10,7 @@
 
 // v68k
 #include "v68k/print.hh"
+#include "v68k/tlb.hh"
 
 // v68k-alloc
 #include "v68k-alloc/memory.hh"
@@ -24,6 +25,7 @@
 #include "screen/storage.hh"
 
 // xv68k
+#include "machine.hh"
 #include "screen.hh"
 
 
@@ -40,13 +42,28 @@ using v68k::mem_exec;
 
 const uint32_t screen_addr = 0x0001A700;
 
-static uint8_t* low_memory_base;
-static uint32_t low_memory_size;
+
+static inline
+uint8_t* cached( machine& m, uint8_t* p, addr_t addr, fc_t fc, mem_t access )
+{
+	if ( p != 0 )  // NULL
+	{
+		m.tlb.insert( addr, fc, access, p );
+	}
+	
+	return p;
+}
 
 
 static
-uint8_t* lowmem_translate( addr_t addr, uint32_t length, fc_t fc, mem_t access )
+uint8_t* lowmem_translate( machine&  m,
+                           addr_t    addr,
+                           uint32_t  length,
+                           fc_t      fc,
+                           mem_t     access )
 {
+	const uint32_t low_memory_size = m.low_memory_size;
+	
 	if ( addr < 1024 )
 	{
 		if ( fc <= user_program_space )
@@ -69,16 +86,19 @@ uint8_t* lowmem_translate( addr_t addr, uint32_t length, fc_t fc, mem_t access )
 		return 0;  // NULL
 	}
 	
-	return low_memory_base + addr;
+	return m.low_memory + addr;
 }
 
 static
-uint8_t* translate_with_diagnostic( uint32_t               addr,
+uint8_t* translate_with_diagnostic( void*                  context,
+                                    uint32_t               addr,
                                     uint32_t               length,
                                     v68k::function_code_t  fc,
                                     v68k::memory_access_t  access )
 {
-	uint8_t* p = memory_manager::translate( addr, length, fc, access );
+	machine& m = static_cast< machine& >( *(v68k::callout::context*) context );
+	
+	uint8_t* p = memory_manager::translate( m, addr, length, fc, access );
 	
 	if ( ! p )
 	{
@@ -89,30 +109,56 @@ uint8_t* translate_with_diagnostic( uint32_t               addr,
 	return p;
 }
 
-memory_manager::memory_manager( uint8_t*  low_mem_base,
-                                uint32_t  low_mem_size )
+static
+uint8_t* translate_quietly( void*                  context,
+                            uint32_t               addr,
+                            uint32_t               length,
+                            v68k::function_code_t  fc,
+                            v68k::memory_access_t  access )
+{
+	machine& m = static_cast< machine& >( *(v68k::callout::context*) context );
+	
+	return memory_manager::translate( m, addr, length, fc, access );
+}
+
+memory_manager::memory_manager( machine& m )
 :
-	v68k::memory( &translate_with_diagnostic )
+	v68k::memory( &translate_with_diagnostic,
+	              static_cast< v68k::callout::context* >( &m ),
+	              &m.tlb,
+	              &translate_quietly )
 {
-	low_memory_base = low_mem_base;
-	low_memory_size = low_mem_size;
 }
 
-uint8_t* memory_manager::translate( uint32_t               addr,
+uint8_t* memory_manager::translate( machine&               m,
+                                    uint32_t               addr,
                                     uint32_t               length,
                                     v68k::function_code_t  fc,
                                     v68k::memory_access_t  access )
 {
+	/*
+		Alloc pages and the part of low memory above the first TLB page
+		(which has the system vectors and Mac low memory globals) are plain
+		memory, so they go in the TLB.  The screen (whose updates have side
+		effects), Mac low memory and callouts don't.
+	*/
+	
 	if ( addr >= v68k::alloc::start  &&  addr < v68k::alloc::limit )
 	{
-		return v68k::alloc::translate( addr, length, fc, access );
+		uint8_t* p = v68k::alloc::translate( m.alloc_pages, addr, length, fc, access );
+		
+		return cached( m, p, addr, fc, access );
 	}
 	
 	const uint32_t screen_size = v68k::screen::the_screen_size;
 	
 	if ( addr >= screen_addr  &&  addr < screen_addr + screen_size )
 	{
-		return screen::translate( addr - screen_addr, length, fc, access );
+		return screen::translate( m.screen_lock_level,
+		                          addr - screen_addr,
+		                          length,
+		                          fc,
+		                          access );
 	}
 	
 	if ( addr < 3 * 1024  &&  (addr & 0x07FF) < 1024 )
@@ -120,13 +166,22 @@ uint8_t* memory_manager::translate( uint32_t               addr,
 		if ( fc <= v68k::user_program_space  &&  access != v68k::mem_exec )
 		{
 			// Mac OS low memory
-			return v68k::mac::translate( addr, length, fc, access );
+			return v68k::mac::translate( m.mac_globals, addr, length, fc, access );
 		}
 	}
 	
-	if ( addr < low_memory_size )
+	if ( addr < m.low_memory_size )
 	{
-		return lowmem_translate( addr, length, fc, access );
+		uint8_t* p = lowmem_translate( m, addr, length, fc, access );
+		
+		const uint32_t page_last = addr | v68k::tlb_page_mask;
+		
+		if ( addr >= v68k::tlb_page_size  &&  page_last < m.low_memory_size )
+		{
+			return cached( m, p, addr, fc, access );
+		}
+		
+		return p;
 	}
 	
 	return v68k::callout::translate( addr, length, fc, access );
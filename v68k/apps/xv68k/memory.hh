@@ -10,14 +10,16 @@
 #include "v68k/memory.hh"
 
 
+class machine;
+
 class memory_manager : public v68k::memory
 {
 	public:
-		memory_manager( uint8_t*  low_mem_base,
-		                uint32_t  low_mem_size );
+		memory_manager( machine& m );
 		
 		static
-		uint8_t* translate( uint32_t               addr,
+		uint8_t* translate( machine&               m,
+		                    uint32_t               addr,
 		                    uint32_t               length,
 		                    v68k::function_code_t  fc,
 		                    v68k::memory_access_t  access );
@@ -0,0 +1,1061 @@
+/*
+	native_traps.cc
+	---------------
+*/
+
+#include "native_traps.hh"
+
+// Standard C
+#include <string.h>
+
+// gear
+#include "gear/hexadecimal.hh"
+
+// v68k-alloc
+#include "v68k-alloc/memory.hh"
+
+// v68k-callouts
+#include "callout/bridge.hh"
+#include "callout/context.hh"
+
+
+#pragma exceptions off
+
+
+using v68k::A0;
+using v68k::A1;
+using v68k::A5;
+using v68k::D0;
+using v68k::SP;
+using v68k::PC;
+using v68k::function_code_t;
+using v68k::mem_read;
+using v68k::mem_write;
+using v68k::mem_update;
+
+
+const uint32_t os_trap_table_address = 1024;
+const uint32_t tb_trap_table_address = 3072;
+
+const uint16_t unimplemented_trap = 0xA89F;
+
+const uint32_t MemErr   = 0x0220;
+const uint32_t ScrnBase = 0x0824;
+
+enum
+{
+	noErr      = 0,
+	memFullErr = -108,
+};
+
+enum
+{
+	srcCopy,
+	srcOr,
+	srcXor,
+	srcBic,
+	
+	patCopy = 8,
+};
+
+enum
+{
+	kGrafPort_portBits  =   2,
+	kGrafPort_clipRgn   =  28,
+	kGrafPort_fillPat   =  40,
+	kGrafPort_pnMode    =  56,
+	kGrafPort_pnPat     =  58,
+	kGrafPort_pnVis     =  66,
+	kGrafPort_picSave   =  92,
+	kGrafPort_grafProcs = 104,
+};
+
+struct rect
+{
+	int16_t top;
+	int16_t left;
+	int16_t bottom;
+	int16_t right;
+};
+
+struct bitmap
+{
+	uint32_t  baseAddr;
+	int16_t   rowBytes;
+	rect      bounds;
+};
+
+typedef bool (*native_handler)( v68k::emulator& emu, uint16_t trap_word );
+
+struct native_trap_entry
+{
+	uint16_t        trap_word;
+	bool            enabled;
+	const char*     name;
+	native_handler  handler;
+	uint32_t        address;  // the trap's routine at boot, or 0
+};
+
+static bool any_native_traps_enabled;
+
+
+static inline
+bool is_toolbox_trap( uint16_t trap_word )
+{
+	return trap_word >= 0xA800;
+}
+
+static
+uint32_t get_trap_address( const v68k::emulator& emu, uint16_t trap_word )
+{
+	const uint32_t entry = is_toolbox_trap( trap_word )
+	                     ? tb_trap_table_address + 4 * (trap_word & 0x3FF)
+	                     : os_trap_table_address + 4 * (trap_word & 0x0FF);
+	
+	uint32_t trap_addr = 0;
+	emu.mem.get_long( entry, trap_addr, emu.data_space() );
+	
+	return trap_addr;
+}
+
+static
+bool get_rect( const v68k::emulator& emu, uint32_t addr, rect& r )
+{
+	const function_code_t data_space = emu.data_space();
+	
+	uint16_t* p = (uint16_t*) &r;
+	
+	return emu.mem.get_word( addr + 0, p[ 0 ], data_space )  &&
+	       emu.mem.get_word( addr + 2, p[ 1 ], data_space )  &&
+	       emu.mem.get_word( addr + 4, p[ 2 ], data_space )  &&
+	       emu.mem.get_word( addr + 6, p[ 3 ], data_space );
+}
+
+static
+bool get_bitmap( const v68k::emulator& emu, uint32_t addr, bitmap& bits )
+{
+	const function_code_t data_space = emu.data_space();
+	
+	uint16_t rowBytes;
+	
+	if ( ! emu.mem.get_long( addr, bits.baseAddr, data_space )  ||
+	     ! emu.mem.get_word( addr + 4, rowBytes, data_space )   ||
+	     ! get_rect( emu, addr + 6, bits.bounds ) )
+	{
+		return false;
+	}
+	
+	bits.rowBytes = rowBytes;
+	
+	// Decline PixMaps (high bit of rowBytes) and degenerate bitmaps.
+	
+	return bits.rowBytes > 0;
+}
+
+static
+bool equal_bitmaps( const bitmap& a, const bitmap& b )
+{
+	return a.baseAddr      == b.baseAddr       &&
+	       a.rowBytes      == b.rowBytes       &&
+	       a.bounds.top    == b.bounds.top     &&
+	       a.bounds.left   == b.bounds.left    &&
+	       a.bounds.bottom == b.bounds.bottom  &&
+	       a.bounds.right  == b.bounds.right;
+}
+
+static
+bool get_pattern( const v68k::emulator& emu, uint32_t addr, uint8_t* pat )
+{
+	const uint8_t* p = emu.mem.translate( addr, 8, emu.data_space(), mem_read );
+	
+	if ( p == NULL )
+	{
+		return false;
+	}
+	
+	memcpy( pat, p, 8 );
+	
+	return true;
+}
+
+static
+bool put_pattern( const v68k::emulator& emu, uint32_t addr, const uint8_t* pat )
+{
+	const function_code_t data_space = emu.data_space();
+	
+	uint8_t* p = emu.mem.translate( addr, 8, data_space, mem_write );
+	
+	if ( p == NULL )
+	{
+		return false;
+	}
+	
+	memcpy( p, pat, 8 );
+	
+	emu.mem.translate( addr, 8, data_space, mem_update );
+	
+	return true;
+}
+
+static
+bool is_on_screen( const v68k::emulator& emu, const bitmap& bits )
+{
+	/*
+		ams-qd hides the cursor while drawing into or out of the screen, and
+		the cursor code lives in the guest.  Leave those calls to it.
+	*/
+	
+	uint32_t screen_base = 0;
+	emu.mem.get_long( ScrnBase, screen_base, emu.data_space() );
+	
+	return bits.baseAddr == screen_base;
+}
+
+static
+bool get_rectangular_clip( const v68k::emulator& emu, uint32_t rgn, rect& r )
+{
+	const function_code_t data_space = emu.data_space();
+	
+	uint32_t ptr;
+	uint16_t rgnSize;
+	
+	return emu.mem.get_long( rgn, ptr, data_space )      &&
+	       emu.mem.get_word( ptr, rgnSize, data_space )  &&
+	       rgnSize <= 10                                 &&
+	       get_rect( emu, ptr + 2, r );
+}
+
+static inline
+int16_t max( int16_t a, int16_t b )
+{
+	return a > b ? a : b;
+}
+
+static inline
+int16_t min( int16_t a, int16_t b )
+{
+	return b < a ? b : a;
+}
+
+static
+bool sect_rect( const rect& a, const rect& b, rect& c )
+{
+	// Like SectRect(), an empty intersection is zeroed.
+	
+	c.top    = max( a.top,    b.top    );
+	c.left   = max( a.left,   b.left   );
+	c.bottom = min( a.bottom, b.bottom );
+	c.right  = min( a.right,  b.right  );
+	
+	if ( c.top >= c.bottom  ||  c.left >= c.right )
+	{
+		memset( &c, '\0', sizeof c );
+		
+		return false;
+	}
+	
+	return true;
+}
+
+static
+uint8_t* translate_rows( const v68k::emulator&  emu,
+                         const bitmap&          bits,
+                         int                    top,
+                         int                    left,
+                         int                    n_rows,
+                         int                    width,
+                         v68k::mem_t            access,
+                         uint32_t*              span = NULL )
+{
+	/*
+		Bitmap rows are contiguous, so the whole affected range translates
+		as one.  Returns a host pointer to the start of the top row.
+	*/
+	
+	const uint32_t first = bits.baseAddr + top * bits.rowBytes;
+	
+	const uint32_t begin = first + left / 8;
+	const uint32_t end   = first + (n_rows - 1) * bits.rowBytes
+	                             + (left + width - 1) / 8 + 1;
+	
+	uint8_t* p = emu.mem.translate( begin, end - begin, emu.data_space(), access );
+	
+	if ( p == NULL )
+	{
+		return NULL;
+	}
+	
+	if ( span )
+	{
+		span[ 0 ] = begin;
+		span[ 1 ] = end - begin;
+	}
+	
+	return p - left / 8;
+}
+
+static
+void fill_span( uint8_t* row, int left, int width, uint8_t pat, short mode )
+{
+	uint8_t* p = row + left / 8;
+	
+	int skip = left & 0x7;
+	
+	while ( width > 0 )
+	{
+		const int n = min( 8 - skip, width );
+		
+		const uint8_t mask = (0xFF << (8 - n) & 0xFF) >> skip;
+		
+		const uint8_t byte = pat & mask;
+		
+		switch ( mode )
+		{
+			case srcCopy:  *p &= ~mask;  // fall through
+			case srcOr:    *p |=  byte;  break;
+			case srcXor:   *p ^=  byte;  break;
+			case srcBic:   *p &= ~byte;  break;
+		}
+		
+		++p;
+		
+		width -= n;
+		skip   = 0;
+	}
+}
+
+static
+void copy_span( const uint8_t* src, int src_left, uint8_t* dst, int dst_left, int width )
+{
+	src += src_left / 8;
+	dst += dst_left / 8;
+	
+	int src_skip = src_left & 0x7;
+	int dst_skip = dst_left & 0x7;
+	
+	while ( width > 0 )
+	{
+		if ( src_skip == 0  &&  dst_skip == 0  &&  width >= 8 )
+		{
+			const int n_bytes = width / 8;
+			
+			memcpy( dst, src, n_bytes );
+			
+			src += n_bytes;
+			dst += n_bytes;
+			
+			width &= 0x7;
+			
+			continue;
+		}
+		
+		const int n = min( 8 - dst_skip, width );
+		
+		unsigned bits = src[ 0 ] << 8;
+		
+		if ( src_skip + n > 8 )
+		{
+			bits |= src[ 1 ];
+		}
+		
+		const uint8_t byte = uint8_t( bits << src_skip >> 8 ) >> dst_skip;
+		
+		const uint8_t mask = (0xFF << (8 - n) & 0xFF) >> dst_skip;
+		
+		*dst = (*dst & ~mask) | (byte & mask);
+		
+		++dst;
+		
+		src_skip += n;
+		src      += src_skip / 8;
+		src_skip &= 0x7;
+		
+		width   -= n;
+		dst_skip = 0;
+	}
+}
+
+static
+void finish_trap( v68k::emulator& emu, uint32_t n_arg_bytes = 0 )
+{
+	emu.regs[ SP ] += n_arg_bytes;
+	emu.regs[ PC ] += 2;
+	
+	emu.prefetch_instruction_word();
+}
+
+static
+void finish_OS_trap( v68k::emulator& emu )
+{
+	// The trap dispatcher ends with TST.W D0, so callers needn't.
+	
+	const int16_t d0 = emu.regs[ D0 ];
+	
+	const uint16_t N = d0 <  0 ? 0x8 : 0;
+	const uint16_t Z = d0 == 0 ? 0x4 : 0;
+	
+	emu.set_CCR( (emu.get_CCR() & 0x10) | N | Z );
+	
+	finish_trap( emu );
+}
+
+static
+bool routine_is_callout_glue( const v68k::emulator& emu, uint32_t addr, int callout )
+{
+	/*
+		ams-core's NewPtr and DisposePtr are just JSR to the callout followed
+		by MOVE.W D0,MemErr and RTS.  Anything else is someone else's patch.
+	*/
+	
+	const uint16_t glue[] =
+	{
+		0x4EB8, uint16_t( v68k::callout::callout_address( callout ) ),
+		0x31C0, MemErr,
+		0x4E75,
+	};
+	
+	const function_code_t program_space = emu.program_space();
+	
+	for ( unsigned i = 0;  i < sizeof glue / sizeof glue[ 0 ];  ++i )
+	{
+		uint16_t word;
+		
+		if ( ! emu.mem.get_word( addr + 2 * i, word, program_space )  ||  word != glue[ i ] )
+		{
+			return false;
+		}
+	}
+	
+	return true;
+}
+
+static
+bool callout_trap( const v68k::emulator& emu, uint16_t trap_word, int callout, bool& sets_MemErr )
+{
+	const uint32_t trap_addr = get_trap_address( emu, trap_word );
+	
+	sets_MemErr = trap_addr != v68k::callout::callout_address( callout );
+	
+	return !sets_MemErr  ||  routine_is_callout_glue( emu, trap_addr, callout );
+}
+
+static
+bool BlockMove_native( v68k::emulator& emu, uint16_t trap_word )
+{
+	const function_code_t data_space = emu.data_space();
+	
+	const uint32_t src = emu.regs[ A0 ];
+	const uint32_t dst = emu.regs[ A1 ];
+	
+	const uint32_t n = emu.regs[ D0 ];
+	
+	if ( n != 0 )
+	{
+		const uint8_t* p = emu.mem.translate( src, n, data_space, mem_read );
+		
+		uint8_t* q = emu.mem.translate( dst, n, data_space, mem_write );
+		
+		if ( p == NULL  ||  q == NULL )
+		{
+			return false;
+		}
+		
+		memmove( q, p, n );
+		
+		emu.mem.translate( dst, n, data_space, mem_update );
+	}
+	
+	// Like BlockMove_callout, leave D0 alone.
+	
+	finish_OS_trap( emu );
+	
+	return true;
+}
+
+static
+bool NewPtr_native( v68k::emulator& emu, uint16_t trap_word )
+{
+	bool sets_MemErr;
+	
+	if ( ! callout_trap( emu, trap_word, v68k::callout::alloc, sets_MemErr ) )
+	{
+		return false;
+	}
+	
+	v68k::alloc::page_map& pages = v68k::callout::get_context( emu ).alloc_pages;
+	
+	const uint32_t addr = v68k::alloc::allocate( pages, emu.regs[ D0 ] );
+	
+	if ( addr == 0 )
+	{
+		return false;  // let the callout report the failure
+	}
+	
+	if ( const bool keep_A0 = trap_word & 0x100 )
+	{
+		emu.regs[ A0 ] = addr;
+	}
+	
+	emu.regs[ D0 ] = noErr;
+	
+	if ( sets_MemErr )
+	{
+		emu.mem.put_word( MemErr, noErr, emu.data_space() );
+	}
+	
+	finish_OS_trap( emu );
+	
+	return true;
+}
+
+static
+bool DisposePtr_native( v68k::emulator& emu, uint16_t trap_word )
+{
+	bool sets_MemErr;
+	
+	if ( ! callout_trap( emu, trap_word, v68k::callout::dealloc, sets_MemErr ) )
+	{
+		return false;
+	}
+	
+	v68k::alloc::page_map& pages = v68k::callout::get_context( emu ).alloc_pages;
+	
+	v68k::alloc::deallocate( pages, emu.regs[ A0 ] );
+	
+	emu.mem.flush_translations();
+	
+	emu.regs[ D0 ] = noErr;
+	
+	if ( sets_MemErr )
+	{
+		emu.mem.put_word( MemErr, noErr, emu.data_space() );
+	}
+	
+	finish_OS_trap( emu );
+	
+	return true;
+}
+
+static
+bool get_plain_port( const v68k::emulator& emu, uint32_t& port, bitmap& portBits )
+{
+	/*
+		Get thePort, declining bottlenecks, picture recording and the screen.
+	*/
+	
+	const function_code_t data_space = emu.data_space();
+	
+	uint32_t a5_world;
+	uint32_t picSave;
+	uint32_t grafProcs;
+	
+	return emu.mem.get_long( emu.regs[ A5 ], a5_world, data_space )  &&
+	       emu.mem.get_long( a5_world, port, data_space )            &&
+	       emu.mem.get_long( port + kGrafPort_picSave,   picSave,   data_space )  &&
+	       emu.mem.get_long( port + kGrafPort_grafProcs, grafProcs, data_space )  &&
+	       picSave == 0  &&  grafProcs == 0                          &&
+	       get_bitmap( emu, port + kGrafPort_portBits, portBits )    &&
+	       ! is_on_screen( emu, portBits );
+}
+
+static
+bool draw_pattern_rect( v68k::emulator&  emu,
+                        uint32_t         port,
+                        const bitmap&    portBits,
+                        const rect&      r,
+                        uint8_t*         pat,
+                        short            mode,
+                        bool             sets_fillPat )
+{
+	/*
+		This mirrors ams-qd's StdRect() for a rectangular clip, including
+		its leaving the negated, rotated pattern in fillPat.
+	*/
+	
+	const function_code_t data_space = emu.data_space();
+	
+	uint32_t clipRgn;
+	rect clip;
+	
+	if ( ! emu.mem.get_long( port + kGrafPort_clipRgn, clipRgn, data_space )  ||
+	     ! get_rectangular_clip( emu, clipRgn, clip ) )
+	{
+		return false;
+	}
+	
+	const bool nonempty = sect_rect( r,    clip,            clip )  &&
+	                      sect_rect( clip, portBits.bounds, clip );
+	
+	const int top  = clip.top  - portBits.bounds.top;
+	const int left = clip.left - portBits.bounds.left;
+	
+	const int n_rows = clip.bottom - clip.top;
+	const int width  = clip.right - clip.left;
+	
+	uint32_t span[ 2 ];
+	
+	uint8_t* row = NULL;
+	
+	if ( nonempty )
+	{
+		row = translate_rows( emu, portBits, top, left, n_rows, width, mem_write, span );
+		
+		if ( row == NULL )
+		{
+			return false;
+		}
+	}
+	
+	if ( mode & 0x04 )
+	{
+		for ( int i = 0;  i < 8;  ++i )
+		{
+			pat[ i ] = ~pat[ i ];
+		}
+	}
+	
+	if ( const short h = portBits.bounds.left & 0x07 )
+	{
+		for ( int i = 0;  i < 8;  ++i )
+		{
+			pat[ i ] = pat[ i ] << h | pat[ i ] >> (8 - h);
+		}
+	}
+	
+	if ( sets_fillPat  &&  ! put_pattern( emu, port + kGrafPort_fillPat, pat ) )
+	{
+		return false;
+	}
+	
+	if ( nonempty )
+	{
+		short v = clip.top & 0x7;
+		
+		for ( int i = 0;  i < n_rows;  ++i )
+		{
+			fill_span( row, left, width, pat[ v ], mode & 0x03 );
+			
+			row += portBits.rowBytes;
+			
+			v = (v + 1) & 0x7;
+		}
+		
+		emu.mem.translate( span[ 0 ], span[ 1 ], data_space, mem_update );
+	}
+	
+	return true;
+}
+
+static
+bool PaintRect_native( v68k::emulator& emu, uint16_t trap_word )
+{
+	const function_code_t data_space = emu.data_space();
+	
+	uint32_t port;
+	bitmap portBits;
+	
+	uint32_t r_addr;
+	rect r;
+	
+	uint16_t pnMode;
+	uint16_t pnVis;
+	uint8_t  pat[ 8 ];
+	
+	if ( ! get_plain_port( emu, port, portBits )                             ||
+	     ! emu.mem.get_long( emu.regs[ SP ], r_addr, data_space )            ||
+	     ! get_rect( emu, r_addr, r )                                        ||
+	     ! emu.mem.get_word( port + kGrafPort_pnMode, pnMode, data_space )  ||
+	     ! emu.mem.get_word( port + kGrafPort_pnVis,  pnVis,  data_space )  ||
+	     ! get_pattern( emu, port + kGrafPort_pnPat, pat ) )
+	{
+		return false;
+	}
+	
+	if ( pnMode > 15 )
+	{
+		return false;
+	}
+	
+	if ( int16_t( pnVis ) >= 0 )
+	{
+		const uint8_t black[ 8 ] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+		
+		if ( (pnMode & 0x7) <= srcOr  &&  memcmp( pat, black, 8 ) == 0 )
+		{
+			// The optimized paint leaves fillPat alone.
+			
+			if ( ! draw_pattern_rect( emu, port, portBits, r, pat, srcOr, false ) )
+			{
+				return false;
+			}
+		}
+		else if ( ! draw_pattern_rect( emu, port, portBits, r, pat, pnMode, true ) )
+		{
+			return false;
+		}
+	}
+	
+	finish_trap( emu, 4 );
+	
+	return true;
+}
+
+static
+bool FillRect_native( v68k::emulator& emu, uint16_t trap_word )
+{
+	const function_code_t data_space = emu.data_space();
+	
+	uint32_t port;
+	bitmap portBits;
+	
+	uint32_t pat_addr;
+	uint32_t r_addr;
+	rect r;
+	
+	uint16_t pnVis;
+	uint8_t  pat[ 8 ];
+	
+	if ( ! get_plain_port( emu, port, portBits )                             ||
+	     ! emu.mem.get_long( emu.regs[ SP ] + 0, pat_addr, data_space )      ||
+	     ! emu.mem.get_long( emu.regs[ SP ] + 4, r_addr,   data_space )      ||
+	     ! get_rect( emu, r_addr, r )                                        ||
+	     ! emu.mem.get_word( port + kGrafPort_pnVis, pnVis, data_space )    ||
+	     ! get_pattern( emu, pat_addr, pat ) )
+	{
+		return false;
+	}
+	
+	if ( int16_t( pnVis ) < 0 )
+	{
+		// FillRect() sets fillPat even if the pen is hidden.
+		
+		if ( ! put_pattern( emu, port + kGrafPort_fillPat, pat ) )
+		{
+			return false;
+		}
+	}
+	else if ( ! draw_pattern_rect( emu, port, portBits, r, pat, patCopy, true ) )
+	{
+		return false;
+	}
+	
+	finish_trap( emu, 8 );
+	
+	return true;
+}
+
+static
+bool CopyBits_native( v68k::emulator& emu, uint16_t trap_word )
+{
+	/*
+		1-bit srcCopy between distinct off-screen bitmaps, without scaling
+		or a mask region, and with a rectangular clip region (if any).
+	*/
+	
+	const function_code_t data_space = emu.data_space();
+	
+	const uint32_t sp = emu.regs[ SP ];
+	
+	uint32_t maskRgn;
+	uint16_t mode;
+	uint32_t dstRect_addr;
+	uint32_t srcRect_addr;
+	uint32_t dstBits_addr;
+	uint32_t srcBits_addr;
+	
+	if ( ! emu.mem.get_long( sp +  0, maskRgn,      data_space )  ||
+	     ! emu.mem.get_word( sp +  4, mode,         data_space )  ||
+	     ! emu.mem.get_long( sp +  6, dstRect_addr, data_space )  ||
+	     ! emu.mem.get_long( sp + 10, srcRect_addr, data_space )  ||
+	     ! emu.mem.get_long( sp + 14, dstBits_addr, data_space )  ||
+	     ! emu.mem.get_long( sp + 18, srcBits_addr, data_space ) )
+	{
+		return false;
+	}
+	
+	if ( maskRgn != 0  ||  mode != srcCopy )
+	{
+		return false;
+	}
+	
+	uint32_t port;
+	bitmap portBits;
+	
+	bitmap srcBits;
+	bitmap dstBits;
+	
+	rect srcRect;
+	rect dstRect;
+	
+	if ( ! get_plain_port( emu, port, portBits )       ||
+	     ! get_bitmap( emu, srcBits_addr, srcBits )    ||
+	     ! get_bitmap( emu, dstBits_addr, dstBits )    ||
+	     ! get_rect( emu, srcRect_addr, srcRect )      ||
+	     ! get_rect( emu, dstRect_addr, dstRect ) )
+	{
+		return false;
+	}
+	
+	if ( srcBits.baseAddr == dstBits.baseAddr  ||
+	     is_on_screen( emu, srcBits )          ||
+	     is_on_screen( emu, dstBits ) )
+	{
+		return false;
+	}
+	
+	const int width  = srcRect.right - srcRect.left;
+	const int height = srcRect.bottom - srcRect.top;
+	
+	if ( width <= 0  ||  height <= 0 )
+	{
+		finish_trap( emu, 22 );
+		return true;
+	}
+	
+	if ( dstRect.right - dstRect.left != width  ||  dstRect.bottom - dstRect.top != height )
+	{
+		// ams-qd doesn't scale; it draws nothing.
+		
+		finish_trap( emu, 22 );
+		return true;
+	}
+	
+	/*
+		When dstBits isn't thePort's portBits, ams-qd draws through a fresh
+		port, whose clipRgn is wide open.
+	*/
+	
+	rect clip = { -32767, -32767, 32767, 32767 };
+	
+	const bool into_port = dstBits_addr == port + kGrafPort_portBits  ||
+	                       equal_bitmaps( dstBits, portBits );
+	
+	if ( into_port )
+	{
+		uint32_t clipRgn;
+		
+		if ( ! emu.mem.get_long( port + kGrafPort_clipRgn, clipRgn, data_space )  ||
+		     ! get_rectangular_clip( emu, clipRgn, clip ) )
+		{
+			return false;
+		}
+	}
+	
+	if ( sect_rect( dstRect, clip,           clip )  &&
+	     sect_rect( clip,    dstBits.bounds, clip ) )
+	{
+		const int clippedTop  = clip.top  - dstRect.top;
+		const int clippedLeft = clip.left - dstRect.left;
+		
+		const int srcTop  = srcRect.top  + clippedTop  - srcBits.bounds.top;
+		const int srcLeft = srcRect.left + clippedLeft - srcBits.bounds.left;
+		
+		const int dstTop  = clip.top  - dstBits.bounds.top;
+		const int dstLeft = clip.left - dstBits.bounds.left;
+		
+		const int n_rows = clip.bottom - clip.top;
+		const int n_cols = clip.right - clip.left;
+		
+		if ( srcTop < 0  ||  srcLeft < 0 )
+		{
+			return false;
+		}
+		
+		uint32_t span[ 2 ];
+		
+		const uint8_t* src = translate_rows( emu, srcBits, srcTop, srcLeft, n_rows, n_cols, mem_read );
+		
+		uint8_t* dst = translate_rows( emu, dstBits, dstTop, dstLeft, n_rows, n_cols, mem_write, span );
+		
+		if ( src == NULL  ||  dst == NULL )
+		{
+			return false;
+		}
+		
+		for ( int i = 0;  i < n_rows;  ++i )
+		{
+			copy_span( src, srcLeft, dst, dstLeft, n_cols );
+			
+			src += srcBits.rowBytes;
+			dst += dstBits.rowBytes;
+		}
+		
+		emu.mem.translate( span[ 0 ], span[ 1 ], data_space, mem_update );
+	}
+	
+	finish_trap( emu, 22 );
+	
+	return true;
+}
+
+static native_trap_entry the_native_traps[] =
+{
+	{ 0xA02E, false, "BlockMove",  &BlockMove_native  },
+	{ 0xA11E, false, "NewPtr",     &NewPtr_native     },
+	{ 0xA01F, false, "DisposePtr", &DisposePtr_native },
+	{ 0xA8A2, false, "PaintRect",  &PaintRect_native  },
+	{ 0xA8A5, false, "FillRect",   &FillRect_native   },
+	{ 0xA8EC, false, "CopyBits",   &CopyBits_native   },
+};
+
+static const int n_native_traps = sizeof the_native_traps / sizeof the_native_traps[ 0 ];
+
+static inline
+bool trap_matches( uint16_t entry_word, uint16_t trap_word )
+{
+	/*
+		Toolbox traps must match exactly (so auto-pop variants don't).
+		OS traps match by number, since the flag bits select variants
+		(e.g. NewPtrClear) that share a routine.
+	*/
+	
+	if ( is_toolbox_trap( entry_word ) )
+	{
+		return trap_word == entry_word;
+	}
+	
+	return ! is_toolbox_trap( trap_word )  &&  (trap_word & 0xFF) == (entry_word & 0xFF);
+}
+
+static
+bool is_hex_trap_word( const char* p, unsigned n )
+{
+	if ( n != 4 )
+	{
+		return false;
+	}
+	
+	for ( unsigned i = 0;  i < n;  ++i )
+	{
+		const char c = p[ i ] | ' ';
+		
+		if ( !( (c >= '0'  &&  c <= '9')  ||  (c >= 'a'  &&  c <= 'f') ) )
+		{
+			return false;
+		}
+	}
+	
+	return (gear::decode_16_bit_hex( p ) & 0xF000) == 0xA000;
+}
+
+static
+bool set_native_trap( const char* name, unsigned n, bool enabled )
+{
+	const bool all = n == 3  &&  memcmp( name, "all", n ) == 0;
+	
+	const bool by_word = ! all  &&  is_hex_trap_word( name, n );
+	
+	const uint16_t trap_word = by_word ? gear::decode_16_bit_hex( name ) : 0;
+	
+	bool found = false;
+	
+	for ( int i = 0;  i < n_native_traps;  ++i )
+	{
+		native_trap_entry& entry = the_native_traps[ i ];
+		
+		const bool match = all     ? true
+		                 : by_word ? trap_matches( entry.trap_word, trap_word )
+		                 :           strlen( entry.name ) == n  &&
+		                             memcmp( entry.name, name, n ) == 0;
+		
+		if ( match )
+		{
+			entry.enabled = enabled;
+			
+			found = true;
+		}
+	}
+	
+	return found;
+}
+
+bool set_native_traps( const char* list )
+{
+	while ( *list != '\0' )
+	{
+		const char* end = strchr( list, ',' );
+		
+		if ( end == NULL )
+		{
+			end = list + strlen( list );
+		}
+		
+		const bool enabled = *list != '-';
+		
+		const char* name = list + ! enabled;
+		
+		if ( ! set_native_trap( name, end - name, enabled ) )
+		{
+			return false;
+		}
+		
+		list = *end ? end + 1 : end;
+	}
+	
+	any_native_traps_enabled = false;
+	
+	for ( int i = 0;  i < n_native_traps;  ++i )
+	{
+		any_native_traps_enabled |= the_native_traps[ i ].enabled;
+	}
+	
+	return true;
+}
+
+void note_native_trap_routines( const v68k::emulator& emu )
+{
+	const uint32_t unimplemented = get_trap_address( emu, unimplemented_trap );
+	
+	for ( int i = 0;  i < n_native_traps;  ++i )
+	{
+		native_trap_entry& entry = the_native_traps[ i ];
+		
+		const uint32_t trap_addr = get_trap_address( emu, entry.trap_word );
+		
+		entry.address = trap_addr != unimplemented ? trap_addr : 0;
+	}
+}
+
+bool native_trap( v68k::emulator& emu )
+{
+	if ( ! any_native_traps_enabled )
+	{
+		return false;
+	}
+	
+	const uint16_t trap_word = emu.opcode;
+	
+	if ( (trap_word & 0xF000) != 0xA000  ||  emu.condition != v68k::normal )
+	{
+		return false;
+	}
+	
+	if ( const bool tracing = emu.sr.ttsm & 0xC )
+	{
+		return false;
+	}
+	
+	for ( int i = 0;  i < n_native_traps;  ++i )
+	{
+		const native_trap_entry& entry = the_native_traps[ i ];
+		
+		if ( entry.enabled  &&  trap_matches( entry.trap_word, trap_word ) )
+		{
+			/*
+				If the trap was unimplemented at boot, or has been patched
+				since (with SetTrapAddress), the native handler would bypass
+				whatever the guest has installed, so leave the call to it.
+			*/
+			
+			if ( entry.address == 0  ||
+			     entry.address != get_trap_address( emu, trap_word ) )
+			{
+				return false;
+			}
+			
+			return entry.handler( emu, trap_word );
+		}
+	}
+	
+	return false;
+}
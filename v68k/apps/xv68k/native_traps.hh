@@ -0,0 +1,43 @@
+/*
+	native_traps.hh
+	---------------
+*/
+
+#ifndef NATIVETRAPS_HH
+#define NATIVETRAPS_HH
+
+// v68k
+#include "v68k/emulator.hh"
+
+
+/*
+	Host implementations of a few hot traps (BlockMove, NewPtr, DisposePtr,
+	PaintRect, FillRect and CopyBits).  They're all disabled by default.
+	
+	set_native_traps() takes a comma-separated list of trap names or trap
+	words in hex (e.g. "BlockMove,A8EC").  A leading '-' disables an entry,
+	and "all" stands for every entry.  It returns false for an unknown name.
+*/
+
+bool set_native_traps( const char* list );
+
+/*
+	Note the routine installed for each trap, once the modules have been
+	installed (or a snapshot restored) and before any program runs.  The
+	table is read-only afterward, so machines on other threads can share
+	it.  A trap whose routine no longer matches has been patched, and its
+	native handler declines.
+*/
+
+void note_native_trap_routines( const v68k::emulator& emu );
+
+/*
+	If the next instruction is an A-line trap with an enabled native
+	handler, and the handler accepts the call, perform it and return true.
+	Handlers decline (returning false having changed nothing) whenever the
+	call strays from the cases they implement, so the 68K code can run.
+*/
+
+bool native_trap( v68k::emulator& emu );
+
+#endif
@@ -0,0 +1,117 @@
+/*
+	pair_profile.cc
+	---------------
+*/
+
+#include "pair_profile.hh"
+
+// POSIX
+#include <unistd.h>
+
+// gear
+#include "gear/hexadecimal.hh"
+#include "gear/inscribe_decimal.hh"
+
+// v68k
+#include "v68k/fusion.hh"
+
+// xv68k
+#include "tally.hh"
+
+
+#pragma exceptions off
+
+
+#define STR_LEN( s )  "" s, (sizeof s - 1)
+
+
+enum
+{
+	n_reported = 32,
+};
+
+static tally the_pairs;
+
+static unsigned long n_counted;
+
+void count_opcode_pair( uint16_t first, uint16_t second )
+{
+	the_pairs.add( first << 16 | second );
+	
+	++n_counted;
+}
+
+static
+char* right_aligned( char* p, unsigned long x, unsigned width )
+{
+	const unsigned length = gear::magnitude< 10 >( x );
+	
+	while ( width-- > length )
+	{
+		*p++ = ' ';
+	}
+	
+	return gear::inscribe_unsigned_r< 10 >( x, p );
+}
+
+void report_opcode_pairs()
+{
+	const unsigned long total = n_counted;
+	
+	if ( total == 0 )
+	{
+		return;
+	}
+	
+	const uint32_t n_pairs = the_pairs.size();
+	
+	const tally_entry* pair_counts = the_pairs.sorted();
+	
+	write( STDERR_FILENO, STR_LEN( "\n" "Top opcode pairs (* = fused):\n" ) );
+	
+	for ( unsigned i = 0;  i < n_pairs  &&  i < n_reported;  ++i )
+	{
+		const tally_entry& entry = pair_counts[ i ];
+		
+		const uint16_t first  = entry.key >> 16;
+		const uint16_t second = entry.key;
+		
+		const unsigned long permille = entry.count * 1000 / total;
+		
+		char line[ 64 ];  // e.g. "    123456   12.3%  4A40 6700  *\n"
+		
+		char* p = right_aligned( line, entry.count, 10 );
+		
+		*p++ = ' ';
+		*p++ = ' ';
+		
+		p = right_aligned( p, permille / 10, 3 );
+		
+		*p++ = '.';
+		*p++ = '0' + permille % 10;
+		*p++ = '%';
+		*p++ = ' ';
+		*p++ = ' ';
+		
+		gear::encode_16_bit_HEX( first, p );
+		
+		p += 4;
+		
+		*p++ = ' ';
+		
+		gear::encode_16_bit_HEX( second, p );
+		
+		p += 4;
+		
+		if ( v68k::fuse( first, second ) )
+		{
+			*p++ = ' ';
+			*p++ = ' ';
+			*p++ = '*';
+		}
+		
+		*p++ = '\n';
+		
+		write( STDERR_FILENO, line, p - line );
+	}
+}
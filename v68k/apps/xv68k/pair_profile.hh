@@ -0,0 +1,22 @@
+/*
+	pair_profile.hh
+	---------------
+*/
+
+#ifndef PAIRPROFILE_HH
+#define PAIRPROFILE_HH
+
+// C99
+#include <stdint.h>
+
+
+/*
+	The opcode pair profile counts each pair of consecutively executed
+	opcodes, to find idioms worth fusing (see v68k/fusion.hh).
+*/
+
+void count_opcode_pair( uint16_t first, uint16_t second );
+
+void report_opcode_pairs();
+
+#endif
@@ -0,0 +1,282 @@
+/*
+	pool.cc
+	-------
+*/
+
+#include "pool.hh"
+
+// Standard C
+#include <stdlib.h>
+
+// POSIX
+#include <pthread.h>
+#include <unistd.h>
+
+
+#pragma exceptions off
+
+
+struct job_queue
+{
+	pthread_mutex_t  mutex;
+	
+	void**    ring;  // capacity is the total number of jobs
+	unsigned  front;
+	unsigned  count;
+};
+
+struct pool
+{
+	job_queue*    queues;
+	int           n_queues;
+	unsigned      capacity;
+	slice_runner  run;
+	
+	/*
+		n_queued counts the jobs in all queues, and n_unfinished counts the
+		jobs not yet finished (queued or running).  Both are guarded by the
+		pool's mutex, so an idle thread can't miss a wakeup.
+	*/
+	
+	pthread_mutex_t  mutex;
+	pthread_cond_t   cond;
+	
+	int  n_queued;
+	int  n_unfinished;
+};
+
+struct worker
+{
+	pool*      p;
+	int        id;
+	pthread_t  thread;
+};
+
+static
+void push_back( job_queue& q, unsigned capacity, void* job )
+{
+	pthread_mutex_lock( &q.mutex );
+	
+	q.ring[ (q.front + q.count++) % capacity ] = job;
+	
+	pthread_mutex_unlock( &q.mutex );
+}
+
+static
+void* pop_front( job_queue& q, unsigned capacity )
+{
+	void* job = NULL;
+	
+	pthread_mutex_lock( &q.mutex );
+	
+	if ( q.count != 0 )
+	{
+		job = q.ring[ q.front ];
+		
+		q.front = (q.front + 1) % capacity;
+		
+		--q.count;
+	}
+	
+	pthread_mutex_unlock( &q.mutex );
+	
+	return job;
+}
+
+static
+void* pop_back( job_queue& q, unsigned capacity )
+{
+	void* job = NULL;
+	
+	pthread_mutex_lock( &q.mutex );
+	
+	if ( q.count != 0 )
+	{
+		job = q.ring[ (q.front + --q.count) % capacity ];
+	}
+	
+	pthread_mutex_unlock( &q.mutex );
+	
+	return job;
+}
+
+static
+void* take( pool& p, int id )
+{
+	void* job = pop_front( p.queues[ id ], p.capacity );
+	
+	for ( int i = 1;  job == NULL  &&  i < p.n_queues;  ++i )
+	{
+		job = pop_back( p.queues[ (id + i) % p.n_queues ], p.capacity );
+	}
+	
+	if ( job != NULL )
+	{
+		pthread_mutex_lock( &p.mutex );
+		
+		--p.n_queued;
+		
+		pthread_mutex_unlock( &p.mutex );
+	}
+	
+	return job;
+}
+
+static
+void work( pool& p, int id )
+{
+	while ( true )
+	{
+		void* job = take( p, id );
+		
+		if ( job == NULL )
+		{
+			pthread_mutex_lock( &p.mutex );
+			
+			while ( p.n_queued == 0  &&  p.n_unfinished > 0 )
+			{
+				pthread_cond_wait( &p.cond, &p.mutex );
+			}
+			
+			const bool done = p.n_unfinished == 0;
+			
+			pthread_mutex_unlock( &p.mutex );
+			
+			if ( done )
+			{
+				return;
+			}
+			
+			continue;
+		}
+		
+		if ( p.run( job ) )
+		{
+			push_back( p.queues[ id ], p.capacity, job );
+			
+			pthread_mutex_lock( &p.mutex );
+			
+			++p.n_queued;
+			
+			pthread_cond_signal( &p.cond );
+			pthread_mutex_unlock( &p.mutex );
+		}
+		else
+		{
+			pthread_mutex_lock( &p.mutex );
+			
+			if ( --p.n_unfinished == 0 )
+			{
+				pthread_cond_broadcast( &p.cond );
+			}
+			
+			pthread_mutex_unlock( &p.mutex );
+		}
+	}
+}
+
+static
+void* worker_start( void* param )
+{
+	worker& w = *(worker*) param;
+	
+	work( *w.p, w.id );
+	
+	return NULL;
+}
+
+void run_pool( void* const* jobs, int n, int n_threads, slice_runner run )
+{
+	if ( n <= 0 )
+	{
+		return;
+	}
+	
+	if ( n_threads <= 0 )
+	{
+		n_threads = sysconf( _SC_NPROCESSORS_ONLN );
+	}
+	
+	if ( n_threads <= 0 )
+	{
+		n_threads = 1;
+	}
+	
+	if ( n_threads > n )
+	{
+		n_threads = n;
+	}
+	
+	job_queue* queues  = (job_queue*) calloc( n_threads, sizeof (job_queue) );
+	worker*    workers = (worker*   ) calloc( n_threads, sizeof (worker   ) );
+	bool*      started = (bool*     ) calloc( n_threads, sizeof (bool) );
+	void**     rings   = (void**    ) calloc( n_threads * n, sizeof (void*) );
+	
+	if ( ! queues  ||  ! workers  ||  ! started  ||  ! rings )
+	{
+		abort();
+	}
+	
+	pool p = { queues, n_threads, unsigned( n ), run };
+	
+	pthread_mutex_init( &p.mutex, NULL );
+	pthread_cond_init ( &p.cond,  NULL );
+	
+	p.n_queued     = n;
+	p.n_unfinished = n;
+	
+	for ( int i = 0;  i < n_threads;  ++i )
+	{
+		pthread_mutex_init( &queues[ i ].mutex, NULL );
+		
+		queues[ i ].ring = rings + i * n;
+	}
+	
+	// Deal the jobs out round-robin, so each thread starts with a share.
+	
+	for ( int i = 0;  i < n;  ++i )
+	{
+		push_back( queues[ i % n_threads ], n, jobs[ i ] );
+	}
+	
+	/*
+		The calling thread is worker 0.  If a thread can't be created, the
+		others steal its queue, so we just run with fewer threads.
+	*/
+	
+	for ( int i = 0;  i < n_threads;  ++i )
+	{
+		workers[ i ].p  = &p;
+		workers[ i ].id = i;
+	}
+	
+	for ( int i = 1;  i < n_threads;  ++i )
+	{
+		worker& w = workers[ i ];
+		
+		started[ i ] = pthread_create( &w.thread, NULL, &worker_start, &w ) == 0;
+	}
+	
+	work( p, 0 );
+	
+	for ( int i = 1;  i < n_threads;  ++i )
+	{
+		if ( started[ i ] )
+		{
+			pthread_join( workers[ i ].thread, NULL );
+		}
+	}
+	
+	for ( int i = 0;  i < n_threads;  ++i )
+	{
+		pthread_mutex_destroy( &queues[ i ].mutex );
+	}
+	
+	pthread_cond_destroy ( &p.cond  );
+	pthread_mutex_destroy( &p.mutex );
+	
+	free( started );
+	free( rings   );
+	free( workers );
+	free( queues  );
+}
@@ -0,0 +1,27 @@
+/*
+	pool.hh
+	-------
+*/
+
+#ifndef POOL_HH
+#define POOL_HH
+
+
+/*
+	run_pool() runs n jobs in time slices on a pool of n_threads threads
+	(or one per online processor if n_threads is zero), and returns when
+	every job has finished.  run() runs one slice of a job, and returns
+	true if the job has more to do.
+	
+	Each thread has its own queue of jobs.  A thread requeues an unfinished
+	job at the back of its own queue and takes its next job from the front;
+	a thread whose queue is empty steals from the back of another's.  A job
+	is run by only one thread at a time, but may move between threads from
+	one slice to the next.
+*/
+
+typedef bool (*slice_runner)( void* job );
+
+void run_pool( void* const* jobs, int n, int n_threads, slice_runner run );
+
+#endif
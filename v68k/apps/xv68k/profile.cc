@@ -0,0 +1,141 @@
+/*
+	profile.cc
+	----------
+*/
+
+#include "profile.hh"
+
+// POSIX
+#include <fcntl.h>
+#include <unistd.h>
+
+// v68k
+#include "v68k/endian.hh"
+
+// v68k-utils
+#include "utils/profile_format.hh"
+
+// xv68k
+#include "tally.hh"
+
+
+#pragma exceptions off
+
+
+using v68k::big_longword;
+
+
+static tally the_opcodes;
+static tally the_PCs;
+static tally the_callouts;
+static tally the_syscalls;
+
+void profile_instruction( uint32_t pc, uint16_t opcode )
+{
+	the_opcodes.add( opcode );
+	the_PCs    .add( pc     );
+}
+
+void profile_callout( uint32_t call_number )
+{
+	the_callouts.add( call_number );
+}
+
+void profile_system_call( uint32_t call_number )
+{
+	the_syscalls.add( call_number );
+}
+
+static inline
+uint32_t high_word( uint64_t x )
+{
+	return x >> 32;
+}
+
+static
+bool write_words( int fd, const uint32_t* words, unsigned n )
+{
+	const ssize_t n_bytes = n * sizeof (uint32_t);
+	
+	return write( fd, words, n_bytes ) == n_bytes;
+}
+
+static
+bool write_section( int fd, uint32_t tag, tally& counts )
+{
+	using namespace v68k::utils;
+	
+	const uint32_t n = counts.size();
+	
+	const uint32_t header[] = { big_longword( tag ), big_longword( n ) };
+	
+	if ( !write_words( fd, header, 2 ) )
+	{
+		return false;
+	}
+	
+	const tally_entry* entries = counts.sorted();
+	
+	enum
+	{
+		n_buffered = 256,  // entries
+	};
+	
+	uint32_t buffer[ n_buffered * profile_entry_words ];
+	
+	uint32_t* p = buffer;
+	
+	for ( uint32_t i = 0;  i < n;  ++i )
+	{
+		const uint64_t count = entries[ i ].count;
+		
+		*p++ = big_longword( entries[ i ].key   );
+		*p++ = big_longword( high_word( count ) );
+		*p++ = big_longword( count              );
+		
+		if ( p == buffer + sizeof buffer / sizeof *buffer  ||  i + 1 == n )
+		{
+			if ( !write_words( fd, buffer, p - buffer ) )
+			{
+				return false;
+			}
+			
+			p = buffer;
+		}
+	}
+	
+	return true;
+}
+
+bool write_profile( const char* path, uint32_t program_address, unsigned long n_instructions )
+{
+	using namespace v68k::utils;
+	
+	int fd = open( path, O_WRONLY | O_CREAT | O_TRUNC, 0666 );
+	
+	if ( fd < 0 )
+	{
+		return false;
+	}
+	
+	const uint64_t count = n_instructions;
+	
+	const uint32_t header[ profile_header_words ] =
+	{
+		big_longword( profile_magic      ),
+		big_longword( profile_version    ),
+		big_longword( program_address    ),
+		big_longword( high_word( count ) ),
+		big_longword( count              ),
+	};
+	
+	bool ok = write_words( fd, header, profile_header_words )  &&
+	          write_section( fd, profile_opcodes,  the_opcodes  )  &&
+	          write_section( fd, profile_PCs,      the_PCs      )  &&
+	          write_section( fd, profile_callouts, the_callouts )  &&
+	          write_section( fd, profile_syscalls, the_syscalls );
+	
+	ok &= close( fd ) == 0;
+	
+	return ok;
+}
@@ -0,0 +1,28 @@
+/*
+	profile.hh
+	----------
+*/
+
+#ifndef PROFILE_HH
+#define PROFILE_HH
+
+// C99
+#include <stdint.h>
+
+
+/*
+	The guest profile counts executed instructions by opcode and by PC,
+	and invocations of callouts and system calls.  A-trap frequencies are
+	the counts of A-line opcodes.  See v68k-utils/utils/profile_format.hh
+	for the file format, and v68k-profile for a reader.
+*/
+
+void profile_instruction( uint32_t pc, uint16_t opcode );
+
+void profile_callout( uint32_t call_number );
+
+void profile_system_call( uint32_t call_number );
+
+bool write_profile( const char* path, uint32_t program_address, unsigned long n_instructions );
+
+#endif
@@ -14,9 +14,13 @@
 #include <string.h>
 
 // raster
+#include "raster/damage.hh"
+#include "raster/frames.hh"
 #include "raster/load.hh"
+#include "raster/sequence.hh"
 
 // v68k-screen
+#include "screen/damage.hh"
 #include "screen/lock.hh"
 #include "screen/storage.hh"
 #include "screen/surface.hh"
@@ -45,12 +49,10 @@ void close_without_errno( int fd )
 }
 
 static
-sync_relay& initialize( raster_load& raster, uint32_t screen_size )
+sync_relay& initialize( raster_load& raster )
 {
 	using namespace raster;
 	
-	raster.meta = (raster_metadata*) ((char*) raster.addr + screen_size);
-	
 	raster_metadata& meta = *raster.meta;
 	
 	raster_desc& desc = meta.desc;
@@ -91,10 +93,50 @@ int publish_raster( const char* path )
 	the_screen_size = raster.meta->desc.height
 	                * raster.meta->desc.stride;
 	
-	sync_relay& sync = initialize( raster, the_screen_size );
+	sync_relay& sync = initialize( raster );
 	
 	the_sync_relay = &sync;
 	
+	raster_note* damage = find_note( *raster.meta, Note_damage );
+	
+	if ( is_valid_damage( damage ) )
+	{
+		v68k::screen::the_damage_list = (damage_list*) data( damage );
+	}
+	
+	raster_note* frames_note = find_note( *raster.meta, Note_frames );
+	
+	if ( is_valid_frames( raster, frames_note ) )
+	{
+		frame_buffers& frames = data< frame_buffers >( *frames_note );
+		
+		/*
+			Draw into the buffer after the front one, starting from a copy
+			of the front.
+		*/
+		
+		const uint32_t front = front_index( frames );
+		
+		void* back = frame_buffer( raster, (front + 1) % frames.count );
+		
+		if ( back != the_screen_buffer )
+		{
+			memcpy( back, frame_buffer( raster, front ), the_screen_size );
+		}
+		
+		v68k::screen::the_frame_buffers = &frames;
+		v68k::screen::the_first_frame   = raster.addr;
+		
+		the_screen_buffer = back;
+	}
+	
+	raster_note* sequence = find_note( *raster.meta, Note_sequence );
+	
+	if ( is_valid_sequence( sequence ) )
+	{
+		v68k::screen::the_frame_sequence = (frame_sequence*) data( sequence );
+	}
+	
 	return 0;
 }
 
@@ -132,7 +174,11 @@ int set_screen_backing_store_file( const char* path, bool is_raster )
 
 namespace screen {
 
-uint8_t* translate( addr_t addr, uint32_t length, fc_t fc, mem_t access )
+uint8_t* translate( short     lock_level,
+                    addr_t    addr,
+                    uint32_t  length,
+                    fc_t      fc,
+                    mem_t     access )
 {
 	if ( access == v68k::mem_exec )
 	{
@@ -161,9 +207,14 @@ uint8_t* translate( addr_t addr, uint32_t length, fc_t fc, mem_t access )
 	
 	uint8_t* p = (uint8_t*) the_screen_buffer + addr;
 	
-	if ( access == v68k::mem_update  &&  is_unlocked() )
+	if ( access == v68k::mem_update )
 	{
-		v68k::screen::update();
+		v68k::screen::note_damage( addr, length );
+		
+		if ( is_unlocked( lock_level ) )
+		{
+			v68k::screen::update();
+		}
 	}
 	
 	return p;
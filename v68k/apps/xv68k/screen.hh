@@ -18,7 +18,11 @@ using v68k::addr_t;
 using v68k::fc_t;
 using v68k::mem_t;
 
-uint8_t* translate( addr_t addr, uint32_t length, fc_t fc, mem_t access );
+uint8_t* translate( short     lock_level,
+                    addr_t    addr,
+                    uint32_t  length,
+                    fc_t      fc,
+                    mem_t     access );
 
 }
 
@@ -0,0 +1,512 @@
+/*
+	snapshot.cc
+	-----------
+*/
+
+#include "snapshot.hh"
+
+// Standard C
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+// POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+// v68k-alloc
+#include "v68k-alloc/memory.hh"
+
+// v68k-screen
+#include "screen/damage.hh"
+#include "screen/lock.hh"
+#include "screen/storage.hh"
+#include "screen/update.hh"
+
+// v68k-syscalls
+#include "syscall/bridge.hh"
+
+// v68k-time
+#include "v68k-time/clock.hh"
+
+// xv68k
+#include "machine.hh"
+
+
+#pragma exceptions off
+
+
+const uint32_t snapshot_magic   = 0x78363853;  // 'x68S'
+const uint16_t snapshot_version = 1;
+
+const uint32_t section_alignment = v68k::alloc::page_size;
+
+const int max_sections = 5 + v68k::alloc::n_alloc_pages;
+
+enum section_kind
+{
+	section_processor,
+	section_machine,
+	section_low_memory,
+	section_mac_globals,
+	section_screen,
+	section_alloc,
+};
+
+struct snapshot_header
+{
+	uint32_t  magic;
+	uint16_t  version;
+	uint16_t  n_sections;
+};
+
+struct section_entry
+{
+	uint32_t  kind;
+	uint32_t  addr;
+	uint32_t  size;
+	uint32_t  offset;
+};
+
+struct processor_record
+{
+	uint32_t  regs[ v68k::n_registers ];
+	uint16_t  sr;
+	uint16_t  opcode;
+	uint32_t  condition;
+	uint64_t  instruction_count;
+};
+
+struct machine_record
+{
+	uint64_t  elapsed_microseconds;
+	uint32_t  errno_ptr_addr;
+	int16_t   lock_level;
+	uint8_t   ticking;
+	uint8_t   reserved;
+};
+
+
+static inline
+uint32_t aligned( uint32_t offset )
+{
+	return (offset + section_alignment - 1) & -section_alignment;
+}
+
+static
+bool write_section( int fd, const void* data, uint32_t size, uint32_t offset )
+{
+	return pwrite( fd, data, size, offset ) == size;
+}
+
+static
+bool read_section( int fd, void* data, uint32_t size, uint32_t offset )
+{
+	return pread( fd, data, size, offset ) == size;
+}
+
+int save_snapshot( const char* path, const machine& m )
+{
+	const v68k::emulator& emu = m.emu;
+	
+	processor_record processor = {};
+	
+	memcpy( processor.regs, emu.regs, sizeof processor.regs );
+	
+	processor.sr                = emu.get_SR();
+	processor.opcode            = emu.opcode;
+	processor.condition         = emu.condition;
+	processor.instruction_count = emu.instruction_count();
+	
+	using v68k::time::initial_clock;
+	using v68k::time::microsecond_clock;
+	
+	machine_record misc = {};
+	
+	misc.elapsed_microseconds = microsecond_clock() - initial_clock;
+	misc.errno_ptr_addr       = errno_ptr_addr;
+	misc.lock_level           = m.screen_lock_level;
+	misc.ticking              = m.mac_globals.ticking;
+	
+	section_entry* sections = (section_entry*) calloc( max_sections,
+	                                                   sizeof (section_entry) );
+	
+	if ( sections == NULL )
+	{
+		return errno;
+	}
+	
+	const void* data[ max_sections ];
+	
+	int n = 0;
+	
+	data[ n ] = &processor;
+	sections[ n ].kind = section_processor;
+	sections[ n ].size = sizeof processor;
+	++n;
+	
+	data[ n ] = &misc;
+	sections[ n ].kind = section_machine;
+	sections[ n ].size = sizeof misc;
+	++n;
+	
+	data[ n ] = m.low_memory;
+	sections[ n ].kind = section_low_memory;
+	sections[ n ].size = m.low_memory_size;
+	++n;
+	
+	data[ n ] = m.mac_globals.words;
+	sections[ n ].kind = section_mac_globals;
+	sections[ n ].size = sizeof m.mac_globals.words;
+	++n;
+	
+	if ( v68k::screen::the_screen_buffer )
+	{
+		data[ n ] = v68k::screen::the_screen_buffer;
+		sections[ n ].kind = section_screen;
+		sections[ n ].size = v68k::screen::the_screen_size;
+		++n;
+	}
+	
+	uint32_t n_pages;
+	uint32_t addr = 0;
+	
+	using v68k::alloc::next_block;
+	using v68k::alloc::page_size_bits;
+	
+	while ( (addr = next_block( m.alloc_pages, addr, n_pages )) )
+	{
+		const uint32_t size = n_pages << page_size_bits;
+		
+		data[ n ] = v68k::alloc::translate( m.alloc_pages,
+		                                    addr,
+		                                    size,
+		                                    v68k::user_data_space,
+		                                    v68k::mem_read );
+		
+		sections[ n ].kind = section_alloc;
+		sections[ n ].addr = addr;
+		sections[ n ].size = size;
+		++n;
+		
+		addr += size;
+	}
+	
+	const snapshot_header header = { snapshot_magic, snapshot_version, uint16_t( n ) };
+	
+	const uint32_t table_size = n * sizeof (section_entry);
+	
+	uint32_t offset = aligned( sizeof header + table_size );
+	
+	for ( int i = 0;  i < n;  ++i )
+	{
+		sections[ i ].offset = offset;
+		
+		offset = aligned( offset + sections[ i ].size );
+	}
+	
+	int saved_errno = 0;
+	
+	int fd = open( path, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+	
+	bool ok = fd >= 0;
+	
+	ok = ok  &&  write_section( fd, &header, sizeof header, 0 );
+	ok = ok  &&  write_section( fd, sections, table_size, sizeof header );
+	
+	for ( int i = 0;  ok  &&  i < n;  ++i )
+	{
+		const section_entry& section = sections[ i ];
+		
+		ok = write_section( fd, data[ i ], section.size, section.offset );
+	}
+	
+	/*
+		Extend the file to the end of the last section's last page, so
+		that a mapping never reaches past the end of the file.
+	*/
+	
+	ok = ok  &&  ftruncate( fd, offset ) == 0;
+	
+	if ( ! ok )
+	{
+		saved_errno = errno ? errno : EIO;
+	}
+	
+	if ( fd >= 0 )
+	{
+		close( fd );
+	}
+	
+	free( sections );
+	
+	return saved_errno;
+}
+
+static
+uint8_t* map_low_memory( int fd, const section_entry& section )
+{
+	void* addr = mmap( NULL,
+	                   section.size,
+	                   PROT_READ | PROT_WRITE,
+	                   MAP_PRIVATE,
+	                   fd,
+	                   section.offset );
+	
+	return addr != MAP_FAILED ? (uint8_t*) addr : NULL;
+}
+
+static
+bool restore_alloc_block( machine& m, int fd, const section_entry& section )
+{
+	using namespace v68k::alloc;
+	
+	const uint32_t n = section.size >> page_size_bits;
+	
+	/*
+		Alloc blocks are released with free(), so they can't be mapped.
+	*/
+	
+	void* alloc = calloc( n, page_size );
+	
+	if ( alloc == NULL )
+	{
+		return false;
+	}
+	
+	if ( read_section( fd, alloc, section.size, section.offset ) )
+	{
+		if ( allocate_n_pages_at( m.alloc_pages, section.addr, n, alloc ) )
+		{
+			return true;
+		}
+		
+		errno = ENOEXEC;
+	}
+	
+	free( alloc );
+	
+	return false;
+}
+
+static
+bool restore_section( machine& m, int fd, const section_entry& section )
+{
+	v68k::emulator& emu = m.emu;
+	
+	uint32_t size;
+	uint8_t* data = NULL;
+	
+	processor_record processor;
+	machine_record   misc;
+	
+	switch ( section.kind )
+	{
+		case section_processor:
+			if ( section.size != sizeof processor )
+			{
+				break;
+			}
+			
+			if ( ! read_section( fd, &processor, sizeof processor, section.offset ) )
+			{
+				return false;
+			}
+			
+			emu.set_SR( processor.sr );
+			
+			memcpy( emu.regs, processor.regs, sizeof emu.regs );
+			
+			emu.opcode    = processor.opcode;
+			emu.condition = v68k::processor_condition( processor.condition );
+			
+			emu.set_instruction_count( processor.instruction_count );
+			
+			return true;
+		
+		case section_machine:
+			if ( section.size != sizeof misc )
+			{
+				break;
+			}
+			
+			if ( ! read_section( fd, &misc, sizeof misc, section.offset ) )
+			{
+				return false;
+			}
+			
+			using v68k::time::microsecond_clock;
+			
+			v68k::time::initial_clock = microsecond_clock()
+			                          - misc.elapsed_microseconds;
+			
+			errno_ptr_addr         = misc.errno_ptr_addr;
+			m.screen_lock_level    = misc.lock_level;
+			m.mac_globals.ticking  = misc.ticking;
+			
+			return true;
+		
+		case section_low_memory:
+			return true;  // already mapped
+		
+		case section_mac_globals:
+			data = (uint8_t*) m.mac_globals.words;
+			size = sizeof m.mac_globals.words;
+			break;
+		
+		case section_screen:
+			if ( v68k::screen::the_screen_buffer == NULL )
+			{
+				return true;  // running headless this time
+			}
+			
+			data = (uint8_t*) v68k::screen::the_screen_buffer;
+			size = v68k::screen::the_screen_size;
+			break;
+		
+		case section_alloc:
+			return restore_alloc_block( m, fd, section );
+		
+		default:
+			break;
+	}
+	
+	if ( data == NULL  ||  section.size != size )
+	{
+		errno = ENOEXEC;
+		
+		return false;
+	}
+	
+	return read_section( fd, data, size, section.offset );
+}
+
+static
+section_entry* read_section_table( int fd, int& n_sections )
+{
+	snapshot_header header;
+	
+	if ( ! read_section( fd, &header, sizeof header, 0 ) )
+	{
+		return NULL;
+	}
+	
+	if ( header.magic      != snapshot_magic    ||
+	     header.version    != snapshot_version  ||
+	     header.n_sections >  max_sections )
+	{
+		errno = ENOEXEC;
+		
+		return NULL;
+	}
+	
+	const uint32_t table_size = header.n_sections * sizeof (section_entry);
+	
+	section_entry* sections = (section_entry*) malloc( table_size );
+	
+	if ( sections  &&  ! read_section( fd, sections, table_size, sizeof header ) )
+	{
+		free( sections );
+		
+		return NULL;
+	}
+	
+	n_sections = header.n_sections;
+	
+	return sections;
+}
+
+static
+void close_preserving_errno( int fd )
+{
+	const int saved_errno = errno;
+	
+	close( fd );
+	
+	errno = saved_errno;
+}
+
+uint8_t* map_snapshot( const char* path, uint32_t mem_size )
+{
+	int fd = open( path, O_RDONLY );
+	
+	if ( fd < 0 )
+	{
+		return NULL;
+	}
+	
+	uint8_t* mem = NULL;
+	
+	int n_sections;
+	
+	if ( section_entry* sections = read_section_table( fd, n_sections ) )
+	{
+		for ( int i = 0;  i < n_sections;  ++i )
+		{
+			const section_entry& section = sections[ i ];
+			
+			if ( section.kind == section_low_memory )
+			{
+				if ( section.size == mem_size )
+				{
+					mem = map_low_memory( fd, section );
+					
+					break;
+				}
+				
+				errno = ENOEXEC;
+				
+				break;
+			}
+			
+			errno = ENOEXEC;  // no low memory section (yet)
+		}
+		
+		free( sections );
+	}
+	
+	close_preserving_errno( fd );
+	
+	return mem;
+}
+
+bool restore_snapshot( const char* path, machine& m )
+{
+	int fd = open( path, O_RDONLY );
+	
+	if ( fd < 0 )
+	{
+		return false;
+	}
+	
+	int n_sections;
+	
+	section_entry* sections = read_section_table( fd, n_sections );
+	
+	bool ok = sections != NULL;
+	
+	for ( int i = 0;  ok  &&  i < n_sections;  ++i )
+	{
+		ok = restore_section( m, fd, sections[ i ] );
+	}
+	
+	free( sections );
+	
+	close_preserving_errno( fd );
+	
+	using v68k::screen::the_screen_buffer;
+	using v68k::screen::is_unlocked;
+	
+	if ( ok  &&  the_screen_buffer )
+	{
+		v68k::screen::note_damage( 0, v68k::screen::the_screen_size );
+		
+		if ( is_unlocked( m.screen_lock_level ) )
+		{
+			v68k::screen::update();
+		}
+	}
+	
+	return ok;
+}
@@ -0,0 +1,39 @@
+/*
+	snapshot.hh
+	-----------
+*/
+
+#ifndef SNAPSHOT_HH
+#define SNAPSHOT_HH
+
+// Standard C
+#include <stdint.h>
+
+
+/*
+	A snapshot is the state of a machine whose modules have been installed:
+	processor registers, low memory (including the vectors and trap tables),
+	the Mac low memory globals, the screen, the v68k-alloc blocks and a few
+	odds and ends (lock level, elapsed guest time).  Sections are aligned to
+	64K in the file, so low memory is mapped copy-on-write rather than read.
+	
+	Snapshots are specific to the host (they're in native byte order), and
+	don't capture host file descriptors, which must be supplied again.
+*/
+
+class machine;
+
+int save_snapshot( const char* path, const machine& m );
+
+/*
+	Restoring takes two steps, since a machine is constructed with its low
+	memory:  map_snapshot() maps the low memory (returning NULL, with errno
+	set, on failure), and restore_snapshot() restores everything else into
+	a machine built on it.
+*/
+
+uint8_t* map_snapshot( const char* path, uint32_t mem_size );
+
+bool restore_snapshot( const char* path, machine& m );
+
+#endif
@@ -0,0 +1,133 @@
+/*
+	tally.cc
+	--------
+*/
+
+#include "tally.hh"
+
+// Standard C
+#include <stdlib.h>
+
+
+#pragma exceptions off
+
+
+enum
+{
+	initial_capacity = 4096,
+};
+
+static inline
+uint32_t hash( uint32_t key )
+{
+	return (key ^ key >> 15) * 0x9E3779B1u;
+}
+
+static inline
+tally_entry& find( tally_entry* slots, uint32_t capacity, uint32_t key )
+{
+	uint32_t i = hash( key ) & (capacity - 1);
+	
+	while ( slots[ i ].count != 0  &&  slots[ i ].key != key )
+	{
+		i = (i + 1) & (capacity - 1);
+	}
+	
+	return slots[ i ];
+}
+
+tally::~tally()
+{
+	free( its_slots );
+}
+
+bool tally::grow()
+{
+	const uint32_t capacity = its_capacity ? its_capacity * 2 : initial_capacity;
+	
+	tally_entry* slots = (tally_entry*) calloc( capacity, sizeof (tally_entry) );
+	
+	if ( slots == NULL )
+	{
+		return false;
+	}
+	
+	for ( uint32_t i = 0;  i < its_capacity;  ++i )
+	{
+		const tally_entry& entry = its_slots[ i ];
+		
+		if ( entry.count )
+		{
+			find( slots, capacity, entry.key ) = entry;
+		}
+	}
+	
+	free( its_slots );
+	
+	its_slots    = slots;
+	its_capacity = capacity;
+	
+	return true;
+}
+
+void tally::add( uint32_t key )
+{
+	if ( its_capacity == 0  &&  !grow() )
+	{
+		++its_dropped;
+		return;
+	}
+	
+	tally_entry* entry = &find( its_slots, its_capacity, key );
+	
+	if ( entry->count == 0 )
+	{
+		if ( its_size >= its_capacity / 4 * 3 )
+		{
+			if ( !grow() )
+			{
+				++its_dropped;
+				return;
+			}
+			
+			entry = &find( its_slots, its_capacity, key );
+		}
+		
+		entry->key = key;
+		
+		++its_size;
+	}
+	
+	++entry->count;
+}
+
+static
+int descending_count( const void* a, const void* b )
+{
+	const unsigned long x = ((const tally_entry*) a)->count;
+	const unsigned long y = ((const tally_entry*) b)->count;
+	
+	return (x < y) - (x > y);
+}
+
+const tally_entry* tally::sorted()
+{
+	tally_entry* end = its_slots;
+	
+	for ( uint32_t i = 0;  i < its_capacity;  ++i )
+	{
+		if ( its_slots[ i ].count )
+		{
+			*end++ = its_slots[ i ];
+		}
+	}
+	
+	for ( tally_entry* p = end;  p < its_slots + its_capacity;  ++p )
+	{
+		p->count = 0;
+	}
+	
+	qsort( its_slots, its_size, sizeof (tally_entry), &descending_count );
+	
+	return its_slots;
+}
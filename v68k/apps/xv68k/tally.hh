@@ -0,0 +1,61 @@
+/*
+	tally.hh
+	--------
+*/
+
+#ifndef TALLY_HH
+#define TALLY_HH
+
+// C99
+#include <stdint.h>
+
+
+struct tally_entry
+{
+	uint32_t       key;
+	unsigned long  count;  // zero for an empty slot
+};
+
+/*
+	A tally counts occurrences of 32-bit keys in an open-addressed hash
+	table that grows as needed.  If it can't grow, further new keys are
+	counted only as dropped.
+*/
+
+class tally
+{
+	private:
+		tally_entry*   its_slots;
+		uint32_t       its_capacity;  // power of two, or zero
+		uint32_t       its_size;
+		unsigned long  its_dropped;
+		
+		bool grow();
+		
+		// non-copyable
+		tally           ( const tally& );
+		tally& operator=( const tally& );
+	
+	public:
+		tally() : its_slots(), its_capacity(), its_size(), its_dropped()
+		{
+		}
+		
+		~tally();
+		
+		uint32_t size() const  { return its_size; }
+		
+		unsigned long dropped() const  { return its_dropped; }
+		
+		void add( uint32_t key );
+		
+		/*
+			Moves the entries to the front of the table, sorted by count in
+			descending order, and returns them.  The tally is then no longer
+			usable for counting (but may be sorted again).
+		*/
+		
+		const tally_entry* sorted();
+};
+
+#endif
@@ -55,9 +55,16 @@
 
 // xv68k
 #include "diagnostics.hh"
-#include "memory.hh"
+#include "fork_each.hh"
+#include "idle.hh"
+#include "machine.hh"
 #include "native.hh"
+#include "native_traps.hh"
+#include "pair_profile.hh"
+#include "pool.hh"
+#include "profile.hh"
 #include "screen.hh"
+#include "snapshot.hh"
 
 
 #pragma exceptions off
@@ -82,8 +89,25 @@ static bool polling;
 static bool tracing;
 static bool verbose;
 static bool has_screen;
+static bool single_step;
+static bool profile_pairs;
+static bool each;
+static bool threaded;
 
-static unsigned long n_instructions;
+static int n_jobs;
+static int n_threads;
+
+static int events_fd = -1;
+
+static const char* profile_path;
+static const char* snapshot_path;
+static const char* restore_path;
+
+static const char* instruction_limit_var;
+
+static unsigned long max_steps;
+
+static machine* the_machine;  // the machine run directly, if any
 
 struct module_spec
 {
@@ -111,6 +135,16 @@ enum
 	Opt_pid,
 	Opt_raster,
 	Opt_screen,
+	Opt_single_step,
+	Opt_profile_pairs,
+	Opt_profile,
+	Opt_native_traps,
+	Opt_snapshot,
+	Opt_restore,
+	Opt_each,
+	Opt_jobs,
+	Opt_threads,
+	Opt_events_fd,
 	Opt_ignore_screen_locks,
 };
 
@@ -127,6 +161,16 @@ static command::option options[] =
 	{ "screen",     Opt_screen, command::Param_required },
 	{ "module",     Opt_module, command::Param_required },
 	
+	{ "single-step",         Opt_single_step         },
+	{ "profile-pairs",       Opt_profile_pairs       },
+	{ "profile",             Opt_profile, command::Param_required },
+	{ "native-traps",        Opt_native_traps, command::Param_required },
+	{ "snapshot",            Opt_snapshot,     command::Param_required },
+	{ "restore",             Opt_restore,      command::Param_required },
+	{ "each",                Opt_each },
+	{ "jobs",                Opt_jobs,         command::Param_required },
+	{ "threads",             Opt_threads,      command::Param_required },
+	{ "events-fd",           Opt_events_fd,    command::Param_required },
 	{ "ignore-screen-locks", Opt_ignore_screen_locks },
 	
 	{ NULL }
@@ -143,16 +187,44 @@ void exit_with_message( const char* msg, unsigned len, int status )
 	exit( status );
 }
 
+static
+void report_instruction_count( unsigned long n_instructions )
+{
+	const char* count = gear::inscribe_unsigned_decimal( n_instructions );
+	
+	write( STDERR_FILENO, STR_LEN( "### Instruction count: " ) );
+	write( STDERR_FILENO, count, strlen( count ) );
+	write( STDERR_FILENO, STR_LEN( "\n" ) );
+}
+
 static
 void atexit_report()
 {
+	if ( the_machine == NULL )
+	{
+		return;
+	}
+	
+	const unsigned long n_instructions = the_machine->n_instructions;
+	
 	if ( verbose )
 	{
-		const char* count = gear::inscribe_unsigned_decimal( n_instructions );
+		report_instruction_count( n_instructions );
+	}
+	
+	if ( profile_pairs )
+	{
+		report_opcode_pairs();
+	}
+	
+	if ( profile_path )
+	{
+		const uint32_t program_address = the_machine->program_address;
 		
-		write( STDERR_FILENO, STR_LEN( "### Instruction count: " ) );
-		write( STDERR_FILENO, count, strlen( count ) );
-		write( STDERR_FILENO, STR_LEN( "\n" ) );
+		if ( !write_profile( profile_path, program_address, n_instructions ) )
+		{
+			more::perror( "xv68k", profile_path );
+		}
 	}
 }
 
@@ -164,9 +236,25 @@ void dump( const v68k::processor_state& s )
 	print_register_dump( s.regs, s.get_SR() );
 }
 
+/*
+	A contained machine's fatal signal is recorded and its processor halted,
+	rather than raising it in a process that's running other machines.
+*/
+
 static
-void dump_and_raise( const v68k::processor_state& s, int signo )
+void dump_and_raise( v68k::processor_state& s, int signo )
 {
+	machine& m = get_machine( s );
+	
+	if ( m.contained )
+	{
+		m.signal_number = signo;
+		
+		s.condition = v68k::halted;
+		
+		return;
+	}
+	
 	dump( s );
 	
 	atexit_report();
@@ -451,10 +539,10 @@ void load_argv( uint8_t* mem, int argc, char* const* argv )
 }
 
 static
-void load_file( uint8_t* mem, const char* path );
+void load_file( machine& m, uint8_t* mem, const char* path );
 
 static
-void load_code( uint8_t* mem, const char* path )
+void load_code( machine& m, uint8_t* mem, const char* path )
 {
 	int fd;
 	
@@ -464,11 +552,13 @@ void load_code( uint8_t* mem, const char* path )
 	}
 	else
 	{
-		load_file( mem, path );
+		load_file( m, mem, path );
 		
 		return;
 	}
 	
+	m.program_address = code_address;
+	
 	ssize_t n_read = read( fd, mem + code_address, code_max_size );
 	
 	if ( n_read < 0 )
@@ -487,9 +577,38 @@ void load_code( uint8_t* mem, const char* path )
 	}
 }
 
+static
+v68k::op_result contained_exit( v68k::processor_state& s )
+{
+	uint32_t status;
+	
+	if ( ! s.mem.get_long( s.a(7) + 4, status, s.data_space() ) )
+	{
+		return v68k::Bus_error;
+	}
+	
+	get_machine( s ).exit_status = status & 0xFF;  // as by exit()
+	
+	s.condition = v68k::finished;
+	
+	s.acknowledge_breakpoint( 0x4E75 );  // RTS
+	
+	return v68k::Ok;
+}
+
 static
 v68k::op_result bkpt_2( v68k::processor_state& s )
 {
+	if ( profile_path )
+	{
+		profile_system_call( s.d(0) );
+	}
+	
+	if ( s.d(0) == 1  &&  get_machine( s ).contained )
+	{
+		return contained_exit( s );
+	}
+	
 	v68k::op_result result = bridge_call( s );
 	
 	if ( result >= 0 )
@@ -513,6 +632,13 @@ v68k::op_result bkpt_2( v68k::processor_state& s )
 static
 v68k::op_result bkpt_3( v68k::processor_state& s )
 {
+	if ( profile_path )
+	{
+		const int32_t pc = s.pc();
+		
+		profile_callout( pc / -2 - 1 );
+	}
+	
 	int32_t new_opcode = v68k::callout::bridge( s );
 	
 	if ( new_opcode < 0 )
@@ -555,24 +681,121 @@ unsigned parse_instruction_limit( const char* var )
 	return gear::parse_unsigned_decimal( var );
 }
 
+static inline
+bool step( machine& m )
+{
+	v68k::emulator& emu = m.emu;
+	
+	if ( profile_pairs )
+	{
+		static uint16_t previous_opcode;
+		
+		if ( emu.instruction_count() != 0 )
+		{
+			count_opcode_pair( previous_opcode, emu.opcode );
+		}
+		
+		previous_opcode = emu.opcode;
+	}
+	
+	if ( profile_path )
+	{
+		profile_instruction( emu.pc(), emu.opcode );
+	}
+	
+	// A trap handled natively was still executed, so profile it first.
+	
+	if ( native_trap( emu )  ||  (turbo  &&  native_override( emu )) )
+	{
+		return true;
+	}
+	
+	if ( single_step )
+	{
+		return emu.step();
+	}
+	
+	/*
+		Stop each block exactly at the next multiple of 64Ki instructions
+		(where we poll for interrupts) and just past the instruction limit,
+		so the checks below see the same counts they would when stepping.
+	*/
+	
+	const unsigned long n = emu.instruction_count();
+	
+	unsigned long n_max = 0x10000 - (n & 0xFFFF);
+	
+	if ( max_steps != 0  &&  max_steps + 1 - n < n_max )
+	{
+		n_max = max_steps + 1 - n;
+	}
+	
+	return emu.step_block( m.block_cache, n_max );
+}
+
+const int poll_interrupt_level  = 1;
+const int poll_interrupt_vector = 64;
+
+/*
+	If the processor is stopped but can be woken by the poll interrupt,
+	wait until there's a reason to deliver one and then do so, returning
+	true.  Otherwise (or without polling), STOP stops the emulation.
+*/
+
 static
-void emulation_loop( v68k::emulator& emu )
+bool wake_from_stop( v68k::emulator& emu )
 {
-	emu.regs[ 8 + 6 ] = 0;
+	if ( ! polling  ||  emu.condition != v68k::stopped )
+	{
+		return false;
+	}
+	
+	const int mask = emu.get_SR() >> 8 & 0x7;
 	
-	const char* instruction_limit_var = getenv( "XV68K_INSTRUCTION_LIMIT" );
+	if ( mask >= poll_interrupt_level )
+	{
+		return false;  // nothing will ever wake it
+	}
 	
-	const unsigned max_steps = parse_instruction_limit( instruction_limit_var );
+	wait_for_tick_or_event( events_fd );
 	
-	while ( (turbo  &&  native_override( emu ))  ||  emu.step() )
+	return emu.interrupt( poll_interrupt_level, poll_interrupt_vector );
+}
+
+static
+void reset( machine& m )
+{
+	m.emu.reset();
+	
+	m.emu.regs[ 8 + 6 ] = 0;
+}
+
+/*
+	Run the machine until it stops, or if slice is nonzero, until it has run
+	that many more instructions (give or take a block).  Returns true if it
+	was interrupted at the end of a slice, and false if it stopped.
+*/
+
+static
+bool emulate( machine& m, unsigned long slice )
+{
+	v68k::emulator& emu = m.emu;
+	
+	const unsigned long slice_end = m.n_instructions + slice;
+	
+	while ( step( m )  ||  wake_from_stop( emu ) )
 	{
-		n_instructions = emu.instruction_count();
+		const unsigned long n_instructions = emu.instruction_count();
 		
-		if ( max_steps != 0  &&  emu.instruction_count() > max_steps )
+		m.n_instructions = n_instructions;
+		
+		if ( max_steps != 0  &&  n_instructions > max_steps )
 		{
 			print_instruction_limit_exceeded( instruction_limit_var );
 			
 			dump_and_raise( emu, SIGXCPU );
+			
+			return false;  // contained
 		}
 		
 	#ifdef __RELIX__
@@ -584,18 +807,22 @@ void emulation_loop( v68k::emulator& emu )
 		
 	#endif
 		
-		using v68k::mac::ticking;
+		bool& ticking = m.mac_globals.ticking;
 		
 		if ( (short( n_instructions ) == 0  ||  ticking)  &&  polling )
 		{
 			ticking = false;
 			
-			const int level  = 1;
-			const int vector = 64;
-			
-			emu.interrupt( level, vector );
+			emu.interrupt( poll_interrupt_level, poll_interrupt_vector );
+		}
+		
+		if ( slice != 0  &&  n_instructions >= slice_end )
+		{
+			return true;
 		}
 	}
+	
+	return false;
 }
 
 static
@@ -623,7 +850,7 @@ void report_condition( v68k::emulator& emu )
 }
 
 static
-void load_module( uint8_t* mem, const char* module )
+void load_module( machine& m, const char* module )
 {
 	if ( strchr( module, '/' ) == NULL )
 	{
@@ -653,10 +880,10 @@ void load_module( uint8_t* mem, const char* module )
 		*p = '\0';
 	}
 	
-	load_file( mem, module );
+	load_file( m, m.low_memory, module );
 }
 
-void load_file( uint8_t* mem, const char* path )
+void load_file( machine& m, uint8_t* mem, const char* path )
 {
 	typedef uint32_t u32;
 	
@@ -680,7 +907,11 @@ void load_file( uint8_t* mem, const char* path )
 	
 	const int n = (size + page_size - 1) / page_size;  // round up
 	
-	const u32 addr = allocate_n_pages_for_existing_alloc_unchecked( n, alloc );
+	page_map& pages = m.alloc_pages;
+	
+	const u32 addr = allocate_n_pages_for_existing_alloc_unchecked( pages,
+	                                                                n,
+	                                                                alloc );
 	
 	if ( addr == 0 )
 	{
@@ -689,6 +920,8 @@ void load_file( uint8_t* mem, const char* path )
 		exit( 1 );
 	}
 	
+	m.program_address = addr;
+	
 	uint16_t* p = (uint16_t*) (mem + code_address);
 	
 	*p++ = iota::big_u16( 0x4EF9 );
@@ -698,22 +931,9 @@ void load_file( uint8_t* mem, const char* path )
 }
 
 static
-int execute_68k( int argc, char* const* argv )
+void install_modules( machine& booting )
 {
-	uint8_t* mem = (uint8_t*) calloc( 1, mem_size );
-	
-	if ( mem == NULL )
-	{
-		abort();
-	}
-	
-	const memory_manager memory( mem, mem_size );
-	
-	v68k::emulator emu( v68k::mc68000, memory, bkpt_handler );
-	
-	errno_ptr_addr = params_addr + 2 * sizeof (uint32_t);
-	
-	atexit( &atexit_report );
+	uint8_t* mem = booting.low_memory;
 	
 	v68k::user::os_load_spec load = { mem, mem_size, os_address };
 	
@@ -737,19 +957,25 @@ int execute_68k( int argc, char* const* argv )
 		
 		load_argv( mem, module_argc, module_argv );
 		
-		load_module( mem, m->name );
+		load_module( booting, m->name );
 		
-		emu.reset();
+		reset( booting );
 		
-		emulation_loop( emu );
+		emulate( booting, 0 );
 		
-		if ( emu.condition != v68k::startup )
+		if ( booting.emu.condition != v68k::startup )
 		{
 			more::perror( "xv68k", m->name, "Module installation failed" );
 			
 			exit( 1 );
 		}
 	}
+}
+
+static
+void load_program( machine& m, int argc, char* const* argv )
+{
+	uint8_t* mem = m.low_memory;
 	
 	load_argv( mem, argc, argv );
 	
@@ -765,19 +991,219 @@ int execute_68k( int argc, char* const* argv )
 		mem += 4;
 	}
 	
-	load_code( mem, path );
+	load_code( m, mem, path );
 	
-	emu.reset();
+	reset( m );
+}
+
+static
+int run_program( machine& m, int argc, char* const* argv )
+{
+	load_program( m, argc, argv );
 	
-	emulation_loop( emu );
+	emulate( m, 0 );
 	
-	report_condition( emu );
+	report_condition( m.emu );
 	
-	dump( emu );
+	dump( m.emu );
 	
 	return 1;
 }
 
+static
+int run_forked_program( void* param, char* path )
+{
+	machine& booted = *(machine*) param;
+	
+	char* argv[] = { path, NULL };
+	
+	return run_program( booted, 1, argv );
+}
+
+/*
+	In a pool, each program gets its own machine, copied from the booted
+	one.  Programs share the process's file descriptors, so their output
+	isn't sorted by program (unlike with --jobs).
+*/
+
+const unsigned long instructions_per_slice = 0x10000;
+
+static
+bool run_slice( void* job )
+{
+	return emulate( *(machine*) job, instructions_per_slice );
+}
+
+static
+bool report_pooled_program( const machine& m, const char* path )
+{
+	if ( verbose )
+	{
+		report_instruction_count( m.n_instructions );
+	}
+	
+	const char* error = NULL;
+	
+	switch ( m.emu.condition )
+	{
+		case v68k::finished:
+			return m.exit_status == 0;
+		
+		case v68k::halted:
+			error = strsignal( m.signal_number ? m.signal_number : SIGSEGV );
+			break;
+		
+		default:
+			error = "Processor stopped";
+			break;
+	}
+	
+	more::perror( "xv68k", path, error );
+	
+	return false;
+}
+
+static
+int run_pooled_programs( const machine& booted, char* const* programs, int n )
+{
+	machine** machines = (machine**) calloc( n, sizeof (machine*) );
+	
+	if ( machines == NULL )
+	{
+		abort();
+	}
+	
+	for ( int i = 0;  i < n;  ++i )
+	{
+		uint8_t* mem = (uint8_t*) malloc( mem_size );
+		
+		if ( mem == NULL )
+		{
+			abort();
+		}
+		
+		machine* m = new machine( mem, mem_size, &bkpt_handler );
+		
+		if ( ! m->copy( booted ) )
+		{
+			more::perror( "xv68k", programs[ i ], ENOMEM );
+			
+			exit( 1 );
+		}
+		
+		m->contained = true;
+		
+		char* argv[] = { programs[ i ], NULL };
+		
+		load_program( *m, 1, argv );
+		
+		machines[ i ] = m;
+	}
+	
+	run_pool( (void**) machines, n, n_threads, &run_slice );
+	
+	bool failed = false;
+	
+	for ( int i = 0;  i < n;  ++i )
+	{
+		machine* m = machines[ i ];
+		
+		if ( ! report_pooled_program( *m, programs[ i ] ) )
+		{
+			failed = true;
+		}
+		
+		uint8_t* mem = m->low_memory;
+		
+		delete m;
+		
+		free( mem );
+	}
+	
+	free( machines );
+	
+	return failed;
+}
+
+static
+int execute_68k( int argc, char* const* argv )
+{
+	uint8_t* mem;
+	
+	if ( restore_path )
+	{
+		mem = map_snapshot( restore_path, mem_size );
+		
+		if ( mem == NULL )
+		{
+			more::perror( "xv68k", restore_path );
+			
+			exit( 1 );
+		}
+	}
+	else
+	{
+		mem = (uint8_t*) calloc( 1, mem_size );
+		
+		if ( mem == NULL )
+		{
+			abort();
+		}
+	}
+	
+	instruction_limit_var = getenv( "XV68K_INSTRUCTION_LIMIT" );
+	
+	max_steps = parse_instruction_limit( instruction_limit_var );
+	
+	machine booted( mem, mem_size, &bkpt_handler );
+	
+	the_machine = &booted;
+	
+	errno_ptr_addr = params_addr + 2 * sizeof (uint32_t);
+	
+	atexit( &atexit_report );
+	
+	if ( restore_path )
+	{
+		if ( ! restore_snapshot( restore_path, booted ) )
+		{
+			more::perror( "xv68k", restore_path );
+			
+			exit( 1 );
+		}
+	}
+	else
+	{
+		install_modules( booted );
+	}
+	
+	note_native_trap_routines( booted.emu );
+	
+	if ( snapshot_path )
+	{
+		if ( int err = save_snapshot( snapshot_path, booted ) )
+		{
+			more::perror( "xv68k", snapshot_path, err );
+			
+			exit( 1 );
+		}
+	}
+	
+	if ( threaded )
+	{
+		the_machine = NULL;  // each program reports its own count
+		
+		exit( run_pooled_programs( booted, argv, argc ) );
+	}
+	
+	if ( each )
+	{
+		_exit( fork_each( argv, argc, n_jobs, &run_forked_program, &booted ) );
+	}
+	
+	exit( run_program( booted, argc, argv ) );  // report while booted lives
+}
+
 static inline
 bool begins_array( const char* param )
 {
@@ -835,6 +1261,57 @@ char* const* get_options( char** argv )
 				turbo = true;
 				break;
 			
+			case Opt_single_step:
+				single_step = true;
+				break;
+			
+			case Opt_profile_pairs:
+				profile_pairs = true;
+				single_step   = true;  // see every instruction
+				break;
+			
+			case Opt_profile:
+				profile_path = global_result.param;
+				single_step  = true;  // see every instruction
+				break;
+			
+			case Opt_snapshot:
+				snapshot_path = global_result.param;
+				break;
+			
+			case Opt_restore:
+				restore_path = global_result.param;
+				break;
+			
+			case Opt_each:
+				each = true;
+				break;
+			
+			case Opt_jobs:
+				n_jobs = gear::parse_unsigned_decimal( global_result.param );
+				break;
+			
+			case Opt_events_fd:
+				events_fd = gear::parse_unsigned_decimal( global_result.param );
+				break;
+			
+			case Opt_threads:
+				n_threads = gear::parse_unsigned_decimal( global_result.param );
+				threaded  = true;
+				each      = true;
+				break;
+			
+			case Opt_native_traps:
+				if ( ! set_native_traps( global_result.param ) )
+				{
+					write( STDERR_FILENO,
+					       STR_LEN( "xv68k: unknown trap in --native-traps\n" ) );
+					
+					exit( 2 );
+				}
+				
+				break;
+			
 			case Opt_verbose:
 				verbose = true;
 				break;
@@ -933,6 +1410,21 @@ char* const* get_options( char** argv )
 		}
 	}
 	
+	if ( each  &&  has_screen )
+	{
+		EXIT( 2, "xv68k: --each can't share a screen among programs" );
+	}
+	
+	if ( threaded  &&  single_step )
+	{
+		EXIT( 2, "xv68k: --threads can't be combined with profiling or single-stepping" );
+	}
+	
+	if ( restore_path  &&  module != module_specs )
+	{
+		EXIT( 2, "xv68k: --restore can't be combined with --module" );
+	}
+	
 	module->name = NULL;
 	
 	return argv;
@@ -18,10 +18,7 @@
 namespace v68k  {
 namespace alloc {
 
-static void* alloc_pages[ n_alloc_pages + 1 ];
-
-
-static int find_n_pages_at( int n, void* alloc, int i )
+static int find_n_pages_at( void* const* alloc_pages, int n, void* alloc, int i )
 {
 	// Returns 0 on success, or next index to try
 	
@@ -51,7 +48,7 @@ static int find_n_pages_at( int n, void* alloc, int i )
 	return 0;
 }
 
-static int find_n_pages( int n, void* alloc )
+static int find_n_pages( void* const* alloc_pages, int n, void* alloc )
 {
 	// Returns index of first page on success, otherwise 0
 	
@@ -61,7 +58,7 @@ static int find_n_pages( int n, void* alloc )
 	
 	while ( i < end )
 	{
-		int next = find_n_pages_at( n, alloc, i );
+		int next = find_n_pages_at( alloc_pages, n, alloc, i );
 		
 		if ( next == 0 )
 		{
@@ -74,14 +71,18 @@ static int find_n_pages( int n, void* alloc )
 	return 0;
 }
 
-uint32_t allocate_n_pages_for_existing_alloc_unchecked( uint32_t n, void* alloc )
+uint32_t allocate_n_pages_for_existing_alloc_unchecked( page_map&  map,
+                                                        uint32_t   n,
+                                                        void*      alloc )
 {
+	void** alloc_pages = map.pages;
+	
 	if ( alloc == NULL )
 	{
 		return 0;  // NULL
 	}
 	
-	int i = find_n_pages( n, alloc );
+	int i = find_n_pages( alloc_pages, n, alloc );
 	
 	if ( i == 0 )
 	{
@@ -100,7 +101,7 @@ uint32_t allocate_n_pages_for_existing_alloc_unchecked( uint32_t n, void* alloc
 	return result;
 }
 
-uint32_t allocate( uint32_t size )
+uint32_t allocate( page_map& map, uint32_t size )
 {
 	if ( size > n_alloc_bytes )
 	{
@@ -111,7 +112,7 @@ uint32_t allocate( uint32_t size )
 	
 	void* alloc = calloc( n, page_size );
 	
-	const uint32_t result = allocate_n_pages_for_existing_alloc_unchecked( n, alloc );
+	const uint32_t result = allocate_n_pages_for_existing_alloc_unchecked( map, n, alloc );
 	
 	if ( result == 0 )
 	{
@@ -121,8 +122,93 @@ uint32_t allocate( uint32_t size )
 	return result;
 }
 
-void* deallocate_existing( uint32_t addr )
+uint32_t allocate_n_pages_at( page_map& map, uint32_t addr, uint32_t n, void* alloc )
+{
+	void** alloc_pages = map.pages;
+	
+	if ( alloc == NULL  ||  addr & (page_size - 1) )
+	{
+		return 0;
+	}
+	
+	if ( addr < start  ||  addr >= limit  ||  n > (limit - addr) / page_size )
+	{
+		return 0;
+	}
+	
+	const int first = (addr - start) / page_size;
+	
+	for ( int i = first;  i != first + n;  ++i )
+	{
+		if ( alloc_pages[ i ] != NULL )
+		{
+			return 0;
+		}
+	}
+	
+	/*
+		Blocks are told apart by their host memory being discontiguous,
+		so refuse an alloc that would seem to continue a neighbor.
+	*/
+	
+	void* const ante = (char*) alloc - page_size;
+	void* const post = (char*) alloc + n * page_size;
+	
+	if ( (first > 0  &&  alloc_pages[ first - 1 ] == ante)  ||  alloc_pages[ first + n ] == post )
+	{
+		return 0;
+	}
+	
+	for ( int i = first;  i != first + n;  ++i )
+	{
+		alloc_pages[ i ] = alloc;
+		
+		alloc = (char*) alloc + page_size;
+	}
+	
+	return addr;
+}
+
+uint32_t next_block( const page_map& map, uint32_t addr, uint32_t& n )
 {
+	void* const* alloc_pages = map.pages;
+	
+	int i = addr > start ? (addr - start + page_size - 1) / page_size : 0;
+	
+	for ( ;  i < n_alloc_pages;  ++i )
+	{
+		void* alloc = alloc_pages[ i ];
+		
+		if ( alloc == NULL  ||  alloc == (void*) -1L )
+		{
+			continue;
+		}
+		
+		if ( i > 0  &&  (char*) alloc - (char*) alloc_pages[ i - 1 ] == page_size )
+		{
+			continue;  // middle of a block
+		}
+		
+		int j = i;
+		
+		do
+		{
+			alloc = (char*) alloc + page_size;
+		}
+		while ( alloc_pages[ ++j ] == alloc );
+		
+		n = j - i;
+		
+		return start + i * page_size;
+	}
+	
+	return 0;
+}
+
+void* deallocate_existing( page_map& map, uint32_t addr )
+{
+	void** alloc_pages = map.pages;
+	
 	if ( start <= addr  &&  addr < limit )
 	{
 		int i = (addr - start) / page_size;
@@ -160,13 +246,13 @@ void* deallocate_existing( uint32_t addr )
 	return NULL;
 }
 
-void deallocate( uint32_t addr )
+void deallocate( page_map& map, uint32_t addr )
 {
-	free( deallocate_existing( addr ) );
+	free( deallocate_existing( map, addr ) );
 }
 
 static
-unsigned verify_n_pages( unsigned first, unsigned n )
+unsigned verify_n_pages( void* const* alloc_pages, unsigned first, unsigned n )
 {
 	if ( first >= n_alloc_pages  ||  first + n > n_alloc_pages )
 	{
@@ -198,7 +284,11 @@ unsigned verify_n_pages( unsigned first, unsigned n )
 }
 
 
-uint8_t* translate( addr_t addr, uint32_t length, fc_t fc, mem_t access )
+uint8_t* translate( const page_map&  map,
+                   addr_t           addr,
+                   uint32_t         length,
+                   fc_t             fc,
+                   mem_t            access )
 {
 	if ( access == mem_exec )
 	{
@@ -224,14 +314,14 @@ uint8_t* translate( addr_t addr, uint32_t length, fc_t fc, mem_t access )
 	
 	const unsigned count = (offset + length - 1) / page_size + 1;
 	
-	if ( ! verify_n_pages( index, count ) )
+	if ( ! verify_n_pages( map.pages, index, count ) )
 	{
 		// Access runs off end of block
 		
 		return 0;
 	}
 	
-	void* page_alloc = alloc_pages[ index ];
+	void* page_alloc = map.pages[ index ];
 	
 	return (uint8_t*) page_alloc + offset;
 }
@@ -23,20 +23,32 @@ const uint32_t n_alloc_bytes = limit - start;  // 7 MiB
 
 const uint32_t n_alloc_pages = n_alloc_bytes / page_size;
 
+/*
+	A page map holds one machine's allocations:  for each page, the host
+	memory backing it (or NULL).  The extra entry at the end is always NULL.
+*/
+
+struct page_map
+{
+	void* pages[ n_alloc_pages + 1 ];
+};
+
 
-uint32_t allocate_n_pages_for_existing_alloc_unchecked( uint32_t n, void* alloc );
+uint32_t allocate_n_pages_for_existing_alloc_unchecked( page_map&  map,
+                                                        uint32_t   n,
+                                                        void*      alloc );
 
-inline uint32_t allocate_n_pages( void* alloc, uint32_t n )
+inline uint32_t allocate_n_pages( page_map& map, void* alloc, uint32_t n )
 {
 	if ( n > n_alloc_pages )
 	{
 		return 0;
 	}
 	
-	return allocate_n_pages_for_existing_alloc_unchecked( n, alloc );
+	return allocate_n_pages_for_existing_alloc_unchecked( map, n, alloc );
 }
 
-inline uint32_t allocate( void* alloc, uint32_t size )
+inline uint32_t allocate( page_map& map, void* alloc, uint32_t size )
 {
 	if ( size & (page_size - 1) )
 	{
@@ -45,16 +57,31 @@ inline uint32_t allocate( void* alloc, uint32_t size )
 	
 	const uint32_t n = size >> page_size_bits;
 	
-	return allocate_n_pages( alloc, n );
+	return allocate_n_pages( map, alloc, n );
 }
 
-uint32_t allocate( uint32_t size );
+uint32_t allocate( page_map& map, uint32_t size );
+
+/*
+	allocate_n_pages_at() maps an existing alloc of n pages at a given
+	address (as when restoring a snapshot), returning 0 if any of the pages
+	are in use.  next_block() returns the address of the first block at or
+	after addr and sets n to its length in pages, or returns 0 if none.
+*/
+
+uint32_t allocate_n_pages_at( page_map& map, uint32_t addr, uint32_t n, void* alloc );
+
+uint32_t next_block( const page_map& map, uint32_t addr, uint32_t& n );
 
-void* deallocate_existing( uint32_t addr );
+void* deallocate_existing( page_map& map, uint32_t addr );
 
-void deallocate( uint32_t addr );
+void deallocate( page_map& map, uint32_t addr );
 
-uint8_t* translate( addr_t addr, uint32_t length, fc_t fc, mem_t access );
+uint8_t* translate( const page_map&  map,
+                   addr_t           addr,
+                   uint32_t         length,
+                   fc_t             fc,
+                   mem_t            access );
 
 }  // namespace alloc
 }  // namespace v68k
@@ -4,6 +4,7 @@
 */
 
 #include "callout/bridge.hh"
+#include "callout/context.hh"
 
 // POSIX
 #include <fcntl.h>
@@ -64,7 +65,6 @@ namespace callout {
 
 using v68k::auth::fully_authorized;
 using v68k::auth::supervisor_mode_switch_allowed;
-using v68k::screen::lock_level;
 
 
 enum
@@ -100,12 +100,23 @@ void print( code32_t x )
 	logofwar::print( buffer );
 }
 
-static void dump_and_raise( const v68k::processor_state& s, int signo )
+static void dump_and_raise( v68k::processor_state& s, int signo )
 {
 	using v68k::utils::print_register_dump;
 	
 	print_register_dump( s.regs, s.get_SR() );
 	
+	context& machine = get_context( s );
+	
+	if ( machine.contained )
+	{
+		machine.signal_number = signo;
+		
+		s.condition = halted;
+		
+		return;
+	}
+	
 	raise( signo );
 }
 
@@ -169,7 +180,7 @@ int32_t load_callout( v68k::processor_state& s )
 	
 	const size_t n = (s.d(0) + page_size - 1) >> page_size_bits;  // round up
 	
-	const uint32_t addr = allocate_n_pages( alloc, n );
+	const uint32_t addr = allocate_n_pages( get_context( s ).alloc_pages, alloc, n );
 	
 	if ( addr == 0 )
 	{
@@ -315,7 +326,7 @@ int32_t ScrnBitMap_callout( v68k::processor_state& s )
 static
 int32_t lock_screen_callout( v68k::processor_state& s )
 {
-	--lock_level;
+	--get_context( s ).screen_lock_level;
 	
 	return rts;
 }
@@ -323,7 +334,7 @@ int32_t lock_screen_callout( v68k::processor_state& s )
 static
 int32_t unlock_screen_callout( v68k::processor_state& s )
 {
-	if ( ++lock_level == 0 )
+	if ( ++get_context( s ).screen_lock_level == 0 )
 	{
 		v68k::screen::update();
 	}
@@ -375,7 +386,7 @@ int32_t alloc_callout( v68k::processor_state& s )
 	
 	const uint32_t size = s.d(0);
 	
-	uint32_t addr = v68k::alloc::allocate( size );
+	uint32_t addr = v68k::alloc::allocate( get_context( s ).alloc_pages, size );
 	
 	s.a(0) = addr;
 	
@@ -396,7 +407,9 @@ int32_t dealloc_callout( v68k::processor_state& s )
 {
 	const uint32_t addr = s.a(0);
 	
-	v68k::alloc::deallocate( addr );
+	v68k::alloc::deallocate( get_context( s ).alloc_pages, addr );
+	
+	s.mem.flush_translations();
 	
 	s.d(0) = noErr;
 	
@@ -539,26 +552,12 @@ int32_t BlockMove_callout( v68k::processor_state& s )
 	
 	const uint32_t n = s.d(0);
 	
-	const uint8_t* p = s.mem.translate( src, n, v68k::user_data_space, v68k::mem_read );
-	
-	if ( p == NULL )
-	{
-		abort();
-		return nil;  // FIXME
-	}
-	
-	uint8_t* q = s.mem.translate( dst, n, v68k::user_data_space, v68k::mem_write );
-	
-	if ( q == NULL )
+	if ( !s.mem.copy_block( src, dst, n, v68k::user_data_space ) )
 	{
 		abort();
 		return nil;  // FIXME
 	}
 	
-	memmove( q, p, n );
-	
-	s.mem.translate( dst, n, v68k::user_data_space, v68k::mem_update );
-	
 	return rts;
 }
 
@@ -591,6 +590,8 @@ int32_t Gestalt_callout( v68k::processor_state& s )
 			break;
 	}
 	
+	s.materialize_CCR();
+	
 	s.sr.nzvc = result ? 0x8 : 0x4;  // either N or Z
 	
 	s.d(0) = result;
@@ -0,0 +1,53 @@
+/*
+	context.hh
+	----------
+*/
+
+#ifndef CALLOUTCONTEXT_HH
+#define CALLOUTCONTEXT_HH
+
+// v68k
+#include "v68k/state.hh"
+
+// v68k-alloc
+#include "v68k-alloc/memory.hh"
+
+
+namespace v68k    {
+namespace callout {
+
+/*
+	Callouts reach the state of their machine through the context of its
+	memory, which must point to a callout::context (typically the base of
+	the host's own machine class).
+	
+	If contained is set, a guest exception halts the processor and records
+	the corresponding signal in signal_number, rather than raising it in the
+	host process (which may be running other machines).
+*/
+
+struct context
+{
+	v68k::alloc::page_map  alloc_pages;
+	
+	short  screen_lock_level;
+	
+	bool  contained;
+	int   signal_number;
+	
+	context() : alloc_pages(), screen_lock_level(), contained(), signal_number()
+	{
+	}
+};
+
+inline
+context& get_context( const processor_state& s )
+{
+	return *(context*) s.mem.context();
+}
+
+}  // namespace callout
+}  // namespace v68k
+
+
+#endif
@@ -24,12 +24,10 @@
 namespace v68k {
 namespace mac  {
 
-uint32_t get_Ticks()
+uint32_t get_Ticks( uint32_t& Ticks )
 {
 	using namespace v68k::time;
 	
-	static uint32_t Ticks = 0;
-	
 	const uint64_t delta = microsecond_clock() - initial_clock;
 	
 	const unsigned microseconds_per_tick = 1000 * 1000 / 60;
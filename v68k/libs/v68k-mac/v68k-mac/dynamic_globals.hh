@@ -13,7 +13,7 @@
 namespace v68k {
 namespace mac  {
 
-uint32_t get_Ticks();
+uint32_t get_Ticks( uint32_t& last_Ticks );
 uint32_t get_Time();
 
 }  // namespace mac
@@ -21,8 +21,6 @@
 namespace v68k {
 namespace mac  {
 
-bool ticking;
-
 enum
 {
 	tag_ScreenRow,
@@ -114,19 +112,22 @@ enum
 	n_words
 };
 
-static uint16_t words[ n_words ];
+// Fails to compile if the header's n_global_words is out of date
+typedef char n_global_words_is_n_words[ n_global_words == n_words ? 1 : -1 ];
 
-static
-void initialize()
+globals::globals()
+:
+	Ticks(),
+	ticking()
 {
+	memset( words, '\0', sizeof words );
+	
 	words[ tag_ROM85      ] = 0xFFFF;  // indicates 64K ROM
 	words[ tag_SaveUpdate ] = 0xFFFF;  // initially true
 	words[ tag_PaintWhite ] = 0xFFFF;  // initially true
 	words[ tag_MBarHeight ] = 0xFFFF;  // signals to use default menu bar height
 }
 
-static int initialization = (initialize(), 0);
-
 struct global
 {
 	uint16_t  addr;
@@ -143,7 +144,7 @@ static inline bool operator<( const global& g, uint16_t addr )
 	return g.addr + g.size() <= addr;
 }
 
-static const global globals[] =
+static const global global_table[] =
 {
 	{ 0x0102, 0x84, 72              },  // ScrVRes, ScrHRes
 	{ 0x0106, 2,    tag_ScreenRow   },
@@ -209,6 +210,9 @@ static const global globals[] =
 	{ 0x0BFE, 2,    tag_last_A_trap }
 };
 
+static const global* const global_table_end =
+	global_table + sizeof global_table / sizeof global_table[0];
+
 static
 const global* find( const global* begin, const global* end, uint16_t address )
 {
@@ -227,8 +231,8 @@ const global* find( const global* begin, const global* end, uint16_t address )
 
 static const global* find_global( uint16_t address )
 {
-	const global* begin = globals;
-	const global* end   = globals + sizeof globals / sizeof globals[0];
+	const global* begin = global_table;
+	const global* end   = global_table_end;
 	
 	const global* it = find( begin, end, address );
 	
@@ -245,9 +249,9 @@ static const global* find_global( uint16_t address )
 	return it;
 }
 
-static void refresh_dynamic_global( uint8_t tag )
+static void refresh_dynamic_global( globals& state, uint8_t tag )
 {
-	uint16_t* address = &words[ tag ];
+	uint16_t* address = &state.words[ tag ];
 	
 	uint32_t longword;
 	
@@ -261,11 +265,11 @@ static void refresh_dynamic_global( uint8_t tag )
 				1984 original makes two consecutive calls.
 			*/
 			
-			((uint8_t*) &words[ tag_MBState_esc ])[ 1 ] = 2;  // big-endian
+			((uint8_t*) &state.words[ tag_MBState_esc ])[ 1 ] = 2;  // big-endian
 			
-			ticking = true;
+			state.ticking = true;
 			
-			longword = get_Ticks();
+			longword = get_Ticks( state.Ticks );
 			
 			*(uint32_t*) address = big_longword( longword );
 			
@@ -283,10 +287,13 @@ static void refresh_dynamic_global( uint8_t tag )
 	}
 }
 
-static uint8_t buffer[ 32 ];  // needs to be as big as the largest global
-
-static uint8_t* read_globals( const global* g, uint32_t addr, uint32_t size )
+static uint8_t* read_globals( globals&       state,
+                              const global*  g,
+                              uint32_t       addr,
+                              uint32_t       size )
 {
+	uint8_t* buffer = state.buffer;
+	
 	// size == 1 -> offset = 0
 	// size == 2 -> offset = addr & 1
 	// size == 4 -> offset = addr & 3
@@ -332,10 +339,10 @@ static uint8_t* read_globals( const global* g, uint32_t addr, uint32_t size )
 		{
 			if ( g->size_ >= 0x40 )
 			{
-				refresh_dynamic_global( g->index );
+				refresh_dynamic_global( state, g->index );
 			}
 			
-			return (uint8_t*) &words[ g->index ] + (addr - g->addr);
+			return (uint8_t*) &state.words[ g->index ] + (addr - g->addr);
 		}
 		
 		addr += width;
@@ -345,7 +352,7 @@ static uint8_t* read_globals( const global* g, uint32_t addr, uint32_t size )
 			return buffer + offset;
 		}
 		
-		if ( ++g == (globals + sizeof globals / sizeof globals[0]) )
+		if ( ++g == global_table_end )
 		{
 			return NULL;
 		}
@@ -359,28 +366,38 @@ static uint8_t* read_globals( const global* g, uint32_t addr, uint32_t size )
 	return buffer + offset;
 }
 
-static uint8_t* write_globals( const global* g, uint32_t addr, uint32_t size )
+static uint8_t* write_globals( globals&       state,
+                               const global*  g,
+                               uint32_t       addr,
+                               uint32_t       size )
 {
 	const uint32_t offset = addr - g->addr;
 	
 	if ( offset + size <= g->size_ )
 	{
-		return buffer + offset;
+		return state.buffer + offset;
 	}
 	
 	return NULL;
 }
 
-static uint8_t* update_globals( const global* g, uint32_t addr, uint32_t size )
+static uint8_t* update_globals( globals&       state,
+                                const global*  g,
+                                uint32_t       addr,
+                                uint32_t       size )
 {
 	const uint32_t offset = addr - g->addr;
 	
-	memcpy( (char*) &words[ g->index ] + offset, buffer + offset, size );
+	memcpy( (char*) &state.words[ g->index ] + offset, state.buffer + offset, size );
 	
-	return buffer;
+	return state.buffer;
 }
 
-uint8_t* translate( addr_t addr, uint32_t length, fc_t fc, mem_t access )
+uint8_t* translate( globals&  state,
+                   addr_t    addr,
+                   uint32_t  length,
+                   fc_t      fc,
+                   mem_t     access )
 {
 	if ( access == mem_exec )
 	{
@@ -393,15 +410,15 @@ uint8_t* translate( addr_t addr, uint32_t length, fc_t fc, mem_t access )
 	{
 		if ( access == mem_read )
 		{
-			return read_globals( g, addr, length );
+			return read_globals( state, g, addr, length );
 		}
 		else if ( access == mem_write )
 		{
-			return write_globals( g, addr, length );
+			return write_globals( state, g, addr, length );
 		}
 		else  // mem_update
 		{
-			return update_globals( g, addr, length );
+			return update_globals( state, g, addr, length );
 		}
 	}
 	
@@ -13,9 +13,29 @@
 namespace v68k {
 namespace mac  {
 
-extern bool ticking;
+const int n_global_words = 141;  // the number of tags in memory.cc
 
-uint8_t* translate( addr_t addr, uint32_t length, fc_t fc, mem_t access );
+/*
+	The writable Mac low memory globals are per machine.  ticking is set
+	whenever the guest reads Ticks, and cleared by the host when it next
+	delivers a tick interrupt.
+*/
+
+struct globals
+{
+	uint16_t  words[ n_global_words ];
+	uint8_t   buffer[ 32 ];  // needs to be as big as the largest global
+	uint32_t  Ticks;         // the last value of Ticks read
+	bool      ticking;
+	
+	globals();
+};
+
+uint8_t* translate( globals&  state,
+                    addr_t    addr,
+                    uint32_t  length,
+                    fc_t      fc,
+                    mem_t     access );
 
 }  // namespace mac
 }  // namespace v68k
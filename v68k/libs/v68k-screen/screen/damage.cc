@@ -0,0 +1,166 @@
+/*
+	damage.cc
+	---------
+*/
+
+#include "screen/damage.hh"
+
+// Standard C
+#include <string.h>
+
+// raster
+#include "raster/damage.hh"
+
+// v68k-screen
+#include "screen/surface.hh"
+
+
+#pragma exceptions off
+
+
+namespace v68k   {
+namespace screen {
+
+using raster::damage_rect;
+using raster::max_damage_rects;
+
+
+raster::damage_list* the_damage_list;
+
+static damage_rect pending[ max_damage_rects ];
+
+static uint16_t n_pending;
+
+
+static inline
+bool touches( const damage_rect& a, const damage_rect& b )
+{
+	return a.top  <= b.bottom  &&  b.top  <= a.bottom  &&
+	       a.left <= b.right   &&  b.left <= a.right;
+}
+
+static inline
+void merge( damage_rect& a, const damage_rect& b )
+{
+	if ( b.top    < a.top    )  a.top    = b.top;
+	if ( b.left   < a.left   )  a.left   = b.left;
+	if ( b.bottom > a.bottom )  a.bottom = b.bottom;
+	if ( b.right  > a.right  )  a.right  = b.right;
+}
+
+static inline
+uint32_t area( const damage_rect& r )
+{
+	return uint32_t( r.bottom - r.top ) * (r.right - r.left);
+}
+
+static
+void add_damage( const damage_rect& r )
+{
+	for ( int i = 0;  i < n_pending;  ++i )
+	{
+		if ( touches( pending[ i ], r ) )
+		{
+			merge( pending[ i ], r );
+			return;
+		}
+	}
+	
+	if ( n_pending < max_damage_rects )
+	{
+		pending[ n_pending++ ] = r;
+		return;
+	}
+	
+	// Out of rects, so merge with the one that grows the least.
+	
+	int best = 0;
+	
+	uint32_t least_growth = 0xFFFFFFFF;
+	
+	for ( int i = 0;  i < n_pending;  ++i )
+	{
+		damage_rect merged = pending[ i ];
+		
+		merge( merged, r );
+		
+		const uint32_t growth = area( merged ) - area( pending[ i ] );
+		
+		if ( growth < least_growth )
+		{
+			least_growth = growth;
+			best         = i;
+		}
+	}
+	
+	merge( pending[ best ], r );
+}
+
+void note_damage( uint32_t offset, uint32_t length )
+{
+	if ( the_damage_list == 0  ||  length == 0 )  // NULL
+	{
+		return;
+	}
+	
+	const uint32_t stride = the_surface_shape.stride;
+	
+	const uint32_t last = offset + length - 1;
+	
+	damage_rect r;
+	
+	r.top    = offset / stride;
+	r.bottom = last   / stride + 1;
+	
+	if ( r.bottom - r.top == 1 )
+	{
+		r.left  = offset % stride;
+		r.right = last   % stride + 1;
+	}
+	else
+	{
+		r.left  = 0;
+		r.right = stride;
+	}
+	
+	add_damage( r );
+}
+
+bool copy_damage( const void* src, void* dst )
+{
+	if ( the_damage_list == 0 )  // NULL
+	{
+		return false;
+	}
+	
+	const uint32_t stride = the_surface_shape.stride;
+	
+	for ( int i = 0;  i < n_pending;  ++i )
+	{
+		const damage_rect& r = pending[ i ];
+		
+		const uint32_t width = r.right - r.left;
+		
+		for ( uint32_t row = r.top;  row < r.bottom;  ++row )
+		{
+			const uint32_t offset = row * stride + r.left;
+			
+			memcpy( (char*) dst + offset, (const char*) src + offset, width );
+		}
+	}
+	
+	return true;
+}
+
+void publish_damage( uint16_t seed )
+{
+	if ( the_damage_list )
+	{
+		raster::publish_damage( *the_damage_list, seed, pending, n_pending );
+		
+		n_pending = 0;
+	}
+}
+
+}  // namespace screen
+}  // namespace v68k
@@ -0,0 +1,47 @@
+/*
+	damage.hh
+	---------
+*/
+
+#ifndef SCREENDAMAGE_HH
+#define SCREENDAMAGE_HH
+
+// Standard C
+#include <stdint.h>
+
+
+namespace raster
+{
+	
+	struct damage_list;
+	
+}
+
+namespace v68k   {
+namespace screen {
+
+extern raster::damage_list* the_damage_list;
+
+/*
+	Writes to the screen buffer (given as an offset and length within it)
+	accumulate as damage, which update() publishes in the raster's damage
+	note (if it has one) along with the next frame.  Damage is coarsened
+	by merging rectangles rather than allowed to overflow the note.
+*/
+
+void note_damage( uint32_t offset, uint32_t length );
+
+void publish_damage( uint16_t seed );
+
+/*
+	Copy the pending damage (within the screen's shape) from one buffer to
+	another, returning false if damage isn't being tracked.
+*/
+
+bool copy_damage( const void* src, void* dst );
+
+}  // namespace screen
+}  // namespace v68k
+
+
+#endif
@@ -12,8 +12,6 @@
 namespace v68k   {
 namespace screen {
 
-short lock_level;
-
 static bool ignoring_screen_locks;
 
 
@@ -22,7 +20,7 @@ void ignore_screen_locks()
 	ignoring_screen_locks = true;
 }
 
-bool is_unlocked()
+bool is_unlocked( short lock_level )
 {
 	return lock_level >= 0  ||  ignoring_screen_locks;
 }
@@ -10,11 +10,16 @@
 namespace v68k   {
 namespace screen {
 
-extern short lock_level;
-
 void ignore_screen_locks();
 
-bool is_unlocked();
+/*
+	A machine's lock level (kept by the machine, since it's guest state)
+	is decremented by the lock_screen callout and incremented by the
+	unlock_screen callout.  The screen is unlocked at levels of zero and
+	up, or when screen locks are ignored.
+*/
+
+bool is_unlocked( short lock_level );
 
 }  // namespace screen
 }  // namespace v68k
@@ -12,9 +12,13 @@
 #include <string.h>
 
 // raster
+#include "raster/frames.hh"
 #include "raster/relay.hh"
+#include "raster/relay_detail.hh"
+#include "raster/sequence.hh"
 
 // v68k-screen
+#include "screen/damage.hh"
 #include "screen/storage.hh"
 
 
@@ -29,6 +33,64 @@ using raster::sync_relay;
 
 sync_relay* the_sync_relay;
 
+raster::frame_sequence* the_frame_sequence;
+
+raster::frame_buffers* the_frame_buffers;
+void*                  the_first_frame;
+
+
+static
+void flip_frame_buffers()
+{
+	if ( the_frame_buffers == 0  ||  the_frame_buffers->count < 2 )  // NULL
+	{
+		return;
+	}
+	
+	raster::frame_buffers& frames = *the_frame_buffers;
+	
+	const uint32_t size = the_screen_size;
+	
+	char* first = (char*) the_first_frame;
+	char* back  = (char*) the_screen_buffer;
+	
+	const uint32_t front = (back - first) / size;
+	
+	raster::flip( frames, front );
+	
+	char* next = first + (front + 1) % frames.count * size;
+	
+	/*
+		With two buffers, the next one was the front before this frame, so
+		it only lacks this frame's damage.  Otherwise, copy everything.
+	*/
+	
+	if ( frames.count != 2  ||  ! copy_damage( back, next ) )
+	{
+		memcpy( next, back, size );
+	}
+	
+	the_screen_buffer = next;
+}
+
+
+/*
+	The damage note is keyed by the frame about to be published:  the
+	sequence's frame count if there is one (since that's what its readers
+	wait on), or else the relay's seed.
+*/
+
+static
+uint16_t next_frame_key()
+{
+	if ( the_frame_sequence )
+	{
+		return the_frame_sequence->frame + 1;
+	}
+	
+	return the_sync_relay->seed + 1;
+}
+
 
 struct end_sync
 {
@@ -38,7 +100,18 @@ struct end_sync
 		{
 			memset( the_screen_buffer, '\xFF', the_screen_size );
 			
+			note_damage( 0, the_screen_size );
+			
+			flip_frame_buffers();
+			
+			publish_damage( next_frame_key() );
+			
 			terminate( *the_sync_relay );
+			
+			if ( the_frame_sequence )
+			{
+				terminate( *the_frame_sequence );
+			}
 		}
 	}
 };
@@ -60,7 +133,16 @@ void update()
 	
 	if ( the_sync_relay != 0 )  // NULL
 	{
+		flip_frame_buffers();
+		
+		publish_damage( next_frame_key() );
+		
 		raster::broadcast( *the_sync_relay );
+		
+		if ( the_frame_sequence )
+		{
+			raster::broadcast( *the_frame_sequence );
+		}
 	}
 	
 #endif
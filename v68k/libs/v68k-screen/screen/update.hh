@@ -10,6 +10,8 @@
 namespace raster
 {
 	
+	struct frame_buffers;
+	struct frame_sequence;
 	struct sync_relay;
 	
 }
@@ -19,6 +21,17 @@ namespace screen {
 
 extern raster::sync_relay* the_sync_relay;
 
+extern raster::frame_sequence* the_frame_sequence;  // optional
+
+/*
+	If the raster has several frame buffers, the_screen_buffer is the back
+	buffer (one of the_frame_buffers->count, starting at the_first_frame),
+	and update() flips it to the front (see "Frame buffers" in raster.hh).
+*/
+
+extern raster::frame_buffers* the_frame_buffers;  // optional
+extern void*                  the_first_frame;
+
 void update();
 
 
@@ -44,19 +44,16 @@ static int32_t emulated_pid()
 
 static bool get_stacked_args( const v68k::processor_state& s, uint32_t* out, int n )
 {
-	uint32_t sp = s.a(7);
+	const uint32_t sp = s.a(7);
 	
-	while ( n > 0 )
+	if ( !s.mem.get_block( sp + 4, out, n * sizeof (uint32_t), s.data_space() ) )
 	{
-		sp += 4;
-		
-		if ( !s.mem.get_long( sp, *out, s.data_space() ) )
-		{
-			return false;
-		}
-		
-		++out;
-		--n;
+		return false;
+	}
+	
+	for ( int i = 0;  i < n;  ++i )
+	{
+		out[ i ] = v68k::longword_from_big( out[ i ] );
 	}
 	
 	return true;
@@ -117,24 +114,53 @@ v68k::op_result emu_read( v68k::processor_state& s )
 	
 	const int fd = int32_t( args[0] );
 	
-	const uint32_t buffer = args[1];
+	uint32_t buffer = args[1];
+	uint32_t length = args[2];
 	
-	const size_t length = args[2];
+	const v68k::function_code_t data_space = s.data_space();
 	
-	uint8_t* p = s.mem.translate( buffer, length, s.data_space(), v68k::mem_write );
+	/*
+		Read directly into emulated memory, one contiguous run at a time.
+		Usually that's the whole buffer.  Otherwise, stop after a short
+		count or error, as a single read() would.
+	*/
 	
-	int result;
+	int result = 0;
 	
-	if ( p == NULL )
+	do
 	{
-		result = -1;
+		uint32_t run = length;
 		
-		errno = EFAULT;
-	}
-	else
-	{
-		result = read( fd, p, length );
+		uint8_t* p = s.mem.translate_run( buffer, run, data_space, v68k::mem_write );
+		
+		if ( p == NULL )
+		{
+			errno = EFAULT;
+			
+			result = result ? result : -1;
+			break;
+		}
+		
+		const int n_read = read( fd, p, run );
+		
+		if ( n_read < 0 )
+		{
+			result = result ? result : -1;
+			break;
+		}
+		
+		s.mem.translate( buffer, n_read, data_space, v68k::mem_update );
+		
+		result += n_read;
+		buffer += n_read;
+		length -= n_read;
+		
+		if ( uint32_t( n_read ) < run )
+		{
+			break;
+		}
 	}
+	while ( length > 0 );
 	
 	return set_result( s, result );
 }
@@ -151,24 +177,45 @@ v68k::op_result emu_write( v68k::processor_state& s )
 	
 	const int fd = int32_t( args[0] );
 	
-	const uint32_t buffer = args[1];
+	uint32_t buffer = args[1];
+	uint32_t length = args[2];
 	
-	const size_t length = args[2];
+	const v68k::function_code_t data_space = s.data_space();
 	
-	const uint8_t* p = s.mem.translate( buffer, length, s.data_space(), v68k::mem_read );
-	
-	int result;
+	int result = 0;
 	
-	if ( p == NULL )
+	do
 	{
-		result = -1;
+		uint32_t run = length;
 		
-		errno = EFAULT;
-	}
-	else
-	{
-		result = write( fd, p, length );
+		const uint8_t* p = s.mem.translate_run( buffer, run, data_space, v68k::mem_read );
+		
+		if ( p == NULL )
+		{
+			errno = EFAULT;
+			
+			result = result ? result : -1;
+			break;
+		}
+		
+		const int n_written = write( fd, p, run );
+		
+		if ( n_written < 0 )
+		{
+			result = result ? result : -1;
+			break;
+		}
+		
+		result += n_written;
+		buffer += n_written;
+		length -= n_written;
+		
+		if ( uint32_t( n_written ) < run )
+		{
+			break;
+		}
 	}
+	while ( length > 0 );
 	
 	return set_result( s, result );
 }
@@ -530,51 +577,94 @@ v68k::op_result emu_writev( v68k::processor_state& s )
 	
 	const size_t n = args[2];
 	
-	const size_t size = n * sizeof (iovec_68k);
+	const v68k::function_code_t data_space = s.data_space();
 	
-	struct iovec* iov = (struct iovec*) malloc( sizeof (struct iovec) * n );
+	/*
+		A buffer that isn't contiguous in host memory takes more than one
+		host iovec, so the host vector grows as its runs are translated.
+		Most buffers are a single run, so start with one iovec for each.
+	*/
 	
-	const iovec_68k* iov_mem = (iovec_68k*) s.mem.translate( iov_addr,
-	                                                         size,
-	                                                         s.data_space(),
-	                                                         v68k::mem_read );
+	size_t n_runs = 0;
+	size_t n_slots = n;
 	
-	if ( iov == NULL )
+	struct iovec* iov = NULL;
+	
+	iovec_68k* iov_68k = (iovec_68k*) malloc( sizeof (iovec_68k) * n );
+	
+	if ( iov_68k == NULL )
 	{
 		errno = ENOMEM;
 		
 		goto end;
 	}
 	
-	if ( iov_mem == NULL )
+	if ( !s.mem.get_block( iov_addr, iov_68k, n * sizeof (iovec_68k), data_space ) )
 	{
 		errno = EFAULT;
 		
 		goto end;
 	}
 	
-	for ( int i = 0;  i < n;  ++i )
+	iov = (struct iovec*) malloc( sizeof (struct iovec) * n_slots );
+	
+	if ( iov == NULL )
 	{
-		const uint32_t ptr = v68k::longword_from_big( iov_mem[i].ptr );
-		const uint32_t len = v68k::longword_from_big( iov_mem[i].len );
+		errno = ENOMEM;
 		
-		const uint8_t* p = s.mem.translate( ptr, len, s.data_space(), v68k::mem_read );
+		goto end;
+	}
+	
+	for ( int i = 0;  i < n;  ++i )
+	{
+		uint32_t ptr = v68k::longword_from_big( iov_68k[i].ptr );
+		uint32_t len = v68k::longword_from_big( iov_68k[i].len );
 		
-		if ( p == NULL )
+		do
 		{
-			errno = EFAULT;
+			uint32_t run = len;
+			
+			const uint8_t* p = s.mem.translate_run( ptr, run, data_space, v68k::mem_read );
+			
+			if ( p == NULL )
+			{
+				errno = EFAULT;
+				
+				goto end;
+			}
 			
-			goto end;
+			if ( n_runs == n_slots )
+			{
+				n_slots *= 2;
+				
+				void* more = realloc( iov, sizeof (struct iovec) * n_slots );
+				
+				if ( more == NULL )
+				{
+					errno = ENOMEM;
+					
+					goto end;
+				}
+				
+				iov = (struct iovec*) more;
+			}
+			
+			iov[ n_runs ].iov_base = (void*) p;
+			iov[ n_runs ].iov_len  = run;
+			
+			++n_runs;
+			
+			ptr += run;
+			len -= run;
 		}
-		
-		iov[i].iov_base = (void*) p;
-		iov[i].iov_len  = len;
+		while ( len > 0 );
 	}
 	
-	result = writev( fd, iov, n );
+	result = writev( fd, iov, n_runs );
 	
 end:
 	
+	free( iov_68k );
 	free( iov );
 	
 	return set_result( s, result );
@@ -30,7 +30,7 @@ uint64_t microsecond_clock()
 	       + tv.tv_usec;
 }
 
-const uint64_t initial_clock = microsecond_clock();
+uint64_t initial_clock = microsecond_clock();
 
 }  // namespace time
 }  // namespace v68k
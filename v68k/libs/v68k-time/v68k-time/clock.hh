@@ -15,7 +15,12 @@ namespace time {
 
 uint64_t microsecond_clock();
 
-extern const uint64_t initial_clock;
+/*
+	initial_clock is the microsecond_clock() reading that guest time counts
+	from.  A restored snapshot moves it back by the time already elapsed.
+*/
+
+extern uint64_t initial_clock;
 
 }  // namespace time
 }  // namespace v68k
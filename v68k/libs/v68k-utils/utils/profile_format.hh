@@ -0,0 +1,46 @@
+/*
+	profile_format.hh
+	-----------------
+*/
+
+#ifndef UTILS_PROFILEFORMAT_HH
+#define UTILS_PROFILEFORMAT_HH
+
+
+namespace v68k  {
+namespace utils {
+
+/*
+	An xv68k profile (see `xv68k --profile`) is a sequence of big-endian
+	32-bit words:
+	
+		magic, version, program address, instruction count (high, low)
+	
+	followed by any number of sections, each of which is
+	
+		tag, n, then n entries of:  key, count (high, low)
+	
+	The program address is where the program file was loaded in guest
+	memory.  Entries are sorted by count, highest first.  The keys are opcodes,
+	PCs, callout numbers or system call numbers, according to the tag.
+*/
+
+enum
+{
+	profile_magic   = 0x76363850,  // 'v68P'
+	profile_version = 1,
+	
+	profile_header_words = 5,
+	profile_entry_words  = 3,
+	
+	profile_opcodes  = 0x4F50434F,  // 'OPCO'
+	profile_PCs      = 0x50435320,  // 'PCS '
+	profile_callouts = 0x43414C4C,  // 'CALL'
+	profile_syscalls = 0x53595343,  // 'SYSC'
+};
+
+}  // namespace utils
+}  // namespace v68k
+
+
+#endif
@@ -0,0 +1,64 @@
+/*
+	block_cache.cc
+	--------------
+*/
+
+#include "v68k/block_cache.hh"
+
+// Standard C
+#include <stdlib.h>
+#include <string.h>
+
+
+#pragma exceptions off
+
+
+namespace v68k
+{
+	
+	enum
+	{
+		n_cached_blocks = 1024,  // power of two
+	};
+	
+	block_cache::~block_cache()
+	{
+		free( its_blocks );
+	}
+	
+	cached_block* block_cache::slot( addr_t address )
+	{
+		if ( its_blocks == 0 )  // NULL
+		{
+			its_blocks = (cached_block*) calloc( n_cached_blocks, sizeof (cached_block) );
+			
+			if ( its_blocks == 0 )  // NULL
+			{
+				return 0;  // NULL
+			}
+		}
+		
+		return &its_blocks[ (address >> 1) & (n_cached_blocks - 1) ];
+	}
+	
+	void block_cache::flush()
+	{
+		if ( its_blocks )
+		{
+			memset( its_blocks, '\0', n_cached_blocks * sizeof (cached_block) );
+		}
+	}
+	
+	bool block_is_current( const cached_block& block, const memory& mem )
+	{
+		const uint32_t n_bytes = block.n_words * sizeof (uint16_t);
+		
+		const uint8_t* p = mem.translate( block.address,
+		                                  n_bytes,
+		                                  function_code_t( block.fc ),
+		                                  mem_exec );
+		
+		return p != 0  &&  memcmp( p, block.code, n_bytes ) == 0;  // NULL
+	}
+	
+}
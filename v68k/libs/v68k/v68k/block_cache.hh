@@ -0,0 +1,90 @@
+/*
+	block_cache.hh
+	--------------
+*/
+
+#ifndef V68K_BLOCKCACHE_HH
+#define V68K_BLOCKCACHE_HH
+
+// C99
+#include <stdint.h>
+
+// v68k
+#include "v68k/fusion.hh"
+#include "v68k/memory.hh"
+
+
+namespace v68k
+{
+	
+	struct instruction;
+	
+	enum
+	{
+		max_block_instructions = 16,
+		max_block_words        = 64,
+		
+		block_segment_size = 4096,  // blocks never cross a segment boundary
+	};
+	
+	/*
+		A cached block is a run of instructions that was last seen to execute
+		straight through, from the first instruction to the last.  Its code
+		(opcodes and extension words) is kept so the block can be validated
+		against guest memory before it's reused.  Instructions with special
+		dispatch (invalid opcodes, A-line and F-line traps, and BKPT) aren't
+		cached, and a privileged instruction always ends a block.
+		
+		Pairs of adjacent instructions that form a common idiom are fused
+		(see fusion.hh), so they're replayed with a single dispatch.
+	*/
+	
+	struct cached_block
+	{
+		addr_t    address;  // address of the first instruction
+		uint8_t   fc;       // program space, or 0 for an empty slot
+		uint8_t   n_instructions;
+		uint16_t  n_words;  // length of the block's code
+		
+		uint8_t   offsets[ max_block_instructions ];  // word offsets
+		uint16_t  opcodes[ max_block_instructions ];
+		
+		const instruction* decoded[ max_block_instructions ];
+		
+		fused_microcode fused[ max_block_instructions ];  // with the next one
+		
+		uint16_t  code[ max_block_words ];  // big-endian, as in guest memory
+	};
+	
+	class block_cache
+	{
+		private:
+			cached_block* its_blocks;
+			
+			// non-copyable
+			block_cache           ( const block_cache& );
+			block_cache& operator=( const block_cache& );
+		
+		public:
+			block_cache() : its_blocks()
+			{
+			}
+			
+			~block_cache();
+			
+			/*
+				Returns the slot for a block starting at the given address,
+				which may hold some other block or nothing.  Returns NULL if
+				the cache can't be allocated.
+			*/
+			
+			cached_block* slot( addr_t address );
+			
+			void flush();
+	};
+	
+	bool block_is_current( const cached_block& block, const memory& mem );
+	
+}
+
+#endif
@@ -0,0 +1,113 @@
+/*
+	decode_table.cc
+	---------------
+*/
+
+#include "v68k/decode_table.hh"
+
+// Standard C
+#include <stdlib.h>
+
+// v68k
+#include "v68k/decode.hh"
+#include "v68k/instruction.hh"
+
+
+#pragma exceptions off
+
+
+namespace v68k
+{
+	
+	enum
+	{
+		n_opcodes = 65536,
+		n_models  = (mc68040 >> 4) + 1
+	};
+	
+	static instruction* decode_tables[ n_models ];
+	
+	
+	static inline
+	op_size_t resolved_size( op_size_t size, uint16_t opcode )
+	{
+		if ( size > max_actual_size )
+		{
+			const uint16_t size_mask = size;
+			
+			const int bit_offset = size & op_size_shift_mask;
+			
+			// 1 if 0 means byte-sized, 2 if 0 means word-sized
+			const uint32_t index_of_zero = 1 + (size & 1);
+			
+			size = op_size_t( ((opcode & size_mask) >> bit_offset) + index_of_zero );
+		}
+		
+		return size;
+	}
+	
+	const instruction& predecode( uint16_t         opcode,
+	                              processor_model  model,
+	                              instruction&     storage )
+	{
+		instruction scratch = { 0 };
+		
+		const instruction* decoded = decode( opcode, scratch );
+		
+		if ( decoded == 0  ||  (decoded->flags & not_before_mask) > model )  // NULL
+		{
+			const instruction invalid = { 0 };
+			
+			return storage = invalid;
+		}
+		
+		storage = *decoded;
+		
+		storage.size = resolved_size( storage.size, opcode );
+		
+		/*
+			Privileged instructions are checked against the S bit alone.
+			The 68000 allows MOVE from SR in user mode; later models don't.
+		*/
+		
+		const int privilege = storage.flags & privilege_mask;
+		
+		storage.flags = instruction_flags_t( storage.flags & ~privilege_mask );
+		
+		if ( privilege > (model == mc68000) )
+		{
+			storage.flags |= privileged;
+		}
+		
+		return storage;
+	}
+	
+	static
+	instruction* build_decode_table( processor_model model )
+	{
+		instruction* table = (instruction*) malloc( sizeof (instruction) * n_opcodes );
+		
+		if ( table != 0 )  // NULL
+		{
+			for ( unsigned i = 0;  i < n_opcodes;  ++i )
+			{
+				predecode( i, model, table[ i ] );
+			}
+		}
+		
+		return table;
+	}
+	
+	const instruction* decode_table( processor_model model )
+	{
+		instruction*& table = decode_tables[ model >> 4 ];
+		
+		if ( table == 0 )  // NULL
+		{
+			table = build_decode_table( model );
+		}
+		
+		return table;
+	}
+	
+}
@@ -0,0 +1,47 @@
+/*
+	decode_table.hh
+	---------------
+*/
+
+#ifndef V68K_DECODETABLE_HH
+#define V68K_DECODETABLE_HH
+
+// C99
+#include <stdint.h>
+
+// v68k
+#include "v68k/state.hh"
+
+
+namespace v68k
+{
+	
+	struct instruction;
+	
+	/*
+		predecode() runs decode() and then applies everything about the
+		result that depends only on the opcode and the processor model:
+		
+		  * instructions not present on the model decode as invalid,
+		  * the privilege flags are reduced to `privileged` or nothing,
+		  * an opcode-dependent operand size is resolved to an actual size.
+		
+		An invalid opcode yields an instruction whose code is NULL.
+		The result is always `storage`.
+	*/
+	
+	const instruction& predecode( uint16_t         opcode,
+	                              processor_model  model,
+	                              instruction&     storage );
+	
+	/*
+		Returns a table of 65536 predecoded instructions, indexed by opcode.
+		Tables are built on first use, once per processor model, and shared
+		by all emulators of that model.  Returns NULL if allocation fails.
+	*/
+	
+	const instruction* decode_table( processor_model model );
+	
+}
+
+#endif
@@ -5,8 +5,13 @@
 
 #include "v68k/emulator.hh"
 
+// Standard C
+#include <string.h>
+
 // v68k
-#include "v68k/decode.hh"
+#include "v68k/block_cache.hh"
+#include "v68k/decode_table.hh"
+#include "v68k/fusion.hh"
 #include "v68k/instruction.hh"
 #include "v68k/load_store.hh"
 #include "v68k/update_CCR.hh"
@@ -21,7 +26,9 @@ namespace v68k
 	emulator::emulator( processor_model model, const memory& mem, bkpt_handler bkpt )
 	:
 		processor_state( model, mem, bkpt ),
-		its_instruction_counter()
+		its_decode_table( decode_table( model ) ),
+		its_instruction_counter(),
+		its_fall_through()
 	{
 	}
 	
@@ -51,6 +58,8 @@ namespace v68k
 			
 			sr. iii = 7;  // set max Interrupt mask
 			
+			discard_pending_CCR_updates();
+			
 			sr.   x = 0;  // clear CCR
 			sr.nzvc = 0;
 			
@@ -69,11 +78,12 @@ namespace v68k
 		}
 		
 		// decode (prefetched)
-		instruction storage = { 0 };
+		instruction storage;
 		
-		const instruction* decoded = decode( opcode, storage );
+		const instruction* decoded = its_decode_table ? &its_decode_table[ opcode ]
+		                                              : &predecode( opcode, model, storage );
 		
-		if ( !decoded )
+		if ( decoded->code == 0 )  // NULL
 		{
 			switch ( opcode >> 12 )
 			{
@@ -88,40 +98,275 @@ namespace v68k
 			}
 		}
 		
-		if ( (decoded->flags & not_before_mask) > model )
+		const execution_result result = execute( *decoded );
+		
+		if ( result == execution_restart )
 		{
-			return illegal_instruction();
+			goto bkpt_acknowledge;
 		}
 		
-		if ( (decoded->flags & privilege_mask) > ((sr.ttsm & 0x2) | (model == mc68000)) )
+		if ( result != execution_completed )
 		{
-			return privilege_violation();
+			return result == execution_diverted;
 		}
 		
-		const uint32_t instruction_address = pc();
+		// prefetch next
+		prefetch_instruction_word();
 		
-		// advance pc
-		pc() += 2;
+		return condition == normal;
+	}
+	
+	static inline
+	bool cacheable( const instruction& decoded, uint16_t opcode )
+	{
+		const uint16_t BKPT = 0x4848;
 		
-		// fetch
-		fetcher* fetch = decoded->fetch;
+		return decoded.code != 0  &&  (opcode & 0xFFF8) != BKPT;  // NULL
+	}
+	
+	bool emulator::step_block( block_cache& cache, unsigned long n_max )
+	{
+		if ( condition != normal  ||  its_decode_table == 0  ||  n_max <= 1 )
+		{
+			return step();
+		}
 		
-		op_params pb;
+		const uint32_t address = pc();
 		
-		pb.size = decoded->size;
+		cached_block* block = cache.slot( address );
 		
-		if ( pb.size > max_actual_size )
+		if ( block == 0  ||  !cacheable( its_decode_table[ opcode ], opcode ) )  // NULL
 		{
-			const uint16_t size_mask = pb.size;
+			return step();
+		}
+		
+		if ( block->address == address       &&
+		     block->fc == program_space()    &&
+		     block->opcodes[ 0 ] == opcode   &&
+		     block_is_current( *block, mem ) )
+		{
+			return replay_block( *block, n_max );
+		}
+		
+		return record_block( *block, n_max );
+	}
+	
+	bool emulator::record_block( cached_block& block, unsigned long n_max )
+	{
+		const uint32_t address = pc();
+		
+		const function_code_t fc = program_space();
+		
+		const uint32_t limit = address + max_block_words * sizeof (uint16_t);
+		
+		const uint32_t segment_end = (address | (block_segment_size - 1)) + 1;
+		
+		block.fc = 0;  // empty until complete
+		
+		unsigned n = 0;
+		
+		uint32_t end = address;
+		
+		bool ok;
+		
+		while ( true )
+		{
+			const instruction& decoded = its_decode_table[ opcode ];
+			
+			if ( n == n_max  ||  !cacheable( decoded, opcode ) )
+			{
+				ok = true;
+				break;
+			}
 			
-			const int bit_offset = pb.size & op_size_shift_mask;
+			const uint32_t instruction_address = pc();
 			
-			// 1 if 0 means byte-sized, 2 if 0 means word-sized
-			const uint32_t index_of_zero = 1 + (pb.size & 1);
+			const uint16_t instruction_opcode = opcode;
 			
-			pb.size = op_size_t( ((opcode & size_mask) >> bit_offset) + index_of_zero );
+			const execution_result result = execute( decoded );
+			
+			if ( result != execution_completed )
+			{
+				// The faulting instruction is left out of the block.
+				
+				ok = result == execution_diverted;
+				break;
+			}
+			
+			const uint32_t fall_through = its_fall_through;
+			
+			prefetch_instruction_word();
+			
+			ok = condition == normal;
+			
+			if ( fall_through > limit  ||  fall_through > segment_end )
+			{
+				break;
+			}
+			
+			block.offsets [ n ] = (instruction_address - address) / 2;
+			block.opcodes [ n ] = instruction_opcode;
+			block.decoded [ n ] = &decoded;
+			
+			end = fall_through;
+			
+			if ( ++n == max_block_instructions  ||  !ok )
+			{
+				break;
+			}
+			
+			if ( pc() != fall_through  ||  program_space() != fc )
+			{
+				break;
+			}
+			
+			if ( decoded.flags & privileged )
+			{
+				break;
+			}
+		}
+		
+		if ( n == 0 )
+		{
+			return ok;
 		}
 		
+		const uint32_t n_bytes = end - address;
+		
+		const uint8_t* p = mem.translate( address, n_bytes, fc, mem_exec );
+		
+		if ( p == 0 )  // NULL
+		{
+			return ok;
+		}
+		
+		memcpy( block.code, p, n_bytes );
+		
+		for ( unsigned i = 0;  i < n;  ++i )
+		{
+			const uint8_t* code = (const uint8_t*) &block.code[ block.offsets[ i ] ];
+			
+			if ( (code[ 0 ] << 8 | code[ 1 ]) != block.opcodes[ i ] )
+			{
+				// The block modified its own code while running.
+				
+				return ok;
+			}
+		}
+		
+		for ( unsigned i = 0;  i < n;  ++i )
+		{
+			const bool last = i + 1 == n;
+			
+			block.fused[ i ] = last ? 0  // NULL
+			                        : fuse( block.opcodes[ i ], block.opcodes[ i + 1 ] );
+		}
+		
+		block.address        = address;
+		block.n_instructions = n;
+		block.n_words        = n_bytes / sizeof (uint16_t);
+		block.fc             = fc;
+		
+		return ok;
+	}
+	
+	bool emulator::replay_block( const cached_block& block, unsigned long n_max )
+	{
+		/*
+			The block's code has just been checked against memory, so the
+			first opcode (already prefetched) and the rest of them are known
+			to be current.  Stores by the block into its own code end it.
+			
+			A block that branches back to its own start (e.g. a DBRA loop)
+			is replayed again directly, until it exits or n_max runs out.
+		*/
+		
+		const unsigned n = block.n_instructions;
+		
+		mem.watch( block.address, block.n_words * sizeof (uint16_t) );
+		
+		unsigned long n_left = n_max;
+		
+		unsigned i = 0;
+		
+		while ( true )
+		{
+			fused_microcode fused = block.fused[ i ];
+			
+			const bool tracing = sr.ttsm >> 2;
+			
+			if ( fused  &&  n_left >= 2  &&  !tracing  &&
+			     fused( *this, (const uint8_t*) &block.code[ block.offsets[ i ] ] ) )
+			{
+				its_instruction_counter += 2;
+				
+				i      += 2;
+				n_left -= 2;
+			}
+			else
+			{
+				const execution_result result = execute( *block.decoded[ i ] );
+				
+				if ( result != execution_completed )
+				{
+					mem.watch( 0, 0 );
+					
+					return result == execution_diverted;
+				}
+				
+				i      += 1;
+				n_left -= 1;
+			}
+			
+			if ( n_left == 0  ||  condition != normal  ||  mem.watch_hit() )
+			{
+				break;
+			}
+			
+			if ( i == n )
+			{
+				if ( pc() != block.address  ||  program_space() != block.fc )
+				{
+					break;
+				}
+				
+				i = 0;
+			}
+			else if ( pc() != block.address + block.offsets[ i ] * sizeof (uint16_t) )
+			{
+				break;
+			}
+			
+			opcode = block.opcodes[ i ];
+		}
+		
+		mem.watch( 0, 0 );
+		
+		// prefetch next
+		prefetch_instruction_word();
+		
+		return condition == normal;
+	}
+	
+	emulator::execution_result emulator::execute( const instruction& decoded )
+	{
+		if ( (decoded.flags & privileged) > (sr.ttsm & 0x2) )
+		{
+			return execution_result( privilege_violation() );
+		}
+		
+		const uint32_t instruction_address = pc();
+		
+		// advance pc
+		pc() += 2;
+		
+		// fetch
+		fetcher* fetch = decoded.fetch;
+		
+		op_params pb;
+		
+		pb.size = decoded.size;
+		
 		pb.target  = uint32_t( -1 );
 		pb.address = pc();
 		
@@ -131,50 +376,52 @@ namespace v68k
 			
 			if ( result < 0 )
 			{
-				return fault( result, instruction_address );
+				return execution_result( fault( result, instruction_address ) );
 			}
 			
 			if ( condition != normal )
 			{
-				return false;
+				return execution_failed;
 			}
 		}
 		
+		its_fall_through = pc();
+		
 		// load/store prep
 		
 		if (
 			+ pb.size > byte_sized              &&
 			+ badly_aligned_data( pb.address )  &&
-			+ !decoded->accesses_bytes_only()   &&
+			+ !decoded.accesses_bytes_only()    &&
 			+ true )
 		{
 			// pb.address is left set to the PC (which is always even) if unused.
-			return fault( Address_error, instruction_address );
+			return execution_result( fault( Address_error, instruction_address ) );
 		}
 		
 		// load
 		
-		if ( decoded->flags & loads_and )
+		if ( decoded.flags & loads_and )
 		{
 			const op_result result = load( *this, pb );
 			
 			if ( result < 0 )
 			{
-				return fault( result, instruction_address );
+				return execution_result( fault( result, instruction_address ) );
 			}
 		}
 		
 		const uint8_t saved_ttsm = sr.ttsm;
 		
 		// execute
-		const op_result result = decoded->code( *this, pb );
+		const op_result result = decoded.code( *this, pb );
 		
 		if ( result < 0 )
 		{
 			switch ( result )
 			{
 				case Breakpoint:
-					goto bkpt_acknowledge;
+					return execution_restart;
 				
 				case Illegal_instruction:
 				case Trap_0:  case Trap_1:  case Trap_2:  case Trap_3:
@@ -199,7 +446,7 @@ namespace v68k
 				default:
 					condition = halted;
 					
-					return false;
+					return execution_failed;
 			}
 		}
 		
@@ -207,28 +454,39 @@ namespace v68k
 		
 		typedef instruction_flags_t flags_t;
 		
-		if ( const flags_t ccr_flags = flags_t( decoded->flags & CCR_update_mask ) )
+		if ( const flags_t ccr_flags = flags_t( decoded.flags & CCR_update_mask ) )
 		{
-			if ( int32_t( pb.target ) <= 7  ||  decoded->flags & CCR_update_An )
+			if ( int32_t( pb.target ) <= 7  ||  decoded.flags & CCR_update_An )
 			{
 				// Don't update CCR targeting address registers unless requested
 				
 				const int index = ccr_flags >> CCR_update_shift;
 				
-				the_CCR_updaters[ index ]( *this, pb );
+				const bool sets_X = decoded.flags & CCR_update_set_X;
 				
-				if ( decoded->flags & CCR_update_set_X )
+				if ( CCR_update_is_deferrable( index ) )
+				{
+					defer_CCR_update( index, pb, sets_X );
+				}
+				else
 				{
-					sr.x = sr.nzvc & 0x1;
+					materialize_CCR();
+					
+					the_CCR_updaters[ index ]( *this, pb );
+					
+					if ( sets_X )
+					{
+						sr.x = sr.nzvc & 0x1;
+					}
 				}
 			}
 		}
 		
 		// store
 		
-		if ( (decoded->flags & stores_data)  &&  !store( *this, pb ) )
+		if ( (decoded.flags & stores_data)  &&  !store( *this, pb ) )
 		{
-			return fault( Bus_error, instruction_address );
+			return execution_result( fault( Bus_error, instruction_address ) );
 		}
 		
 		++its_instruction_counter;
@@ -243,10 +501,7 @@ namespace v68k
 			fault( Trace_exception, instruction_address );
 		}
 		
-		// prefetch next
-		prefetch_instruction_word();
-		
-		return condition == normal;
+		return execution_completed;
 	}
 	
 	void emulator::prefetch_instruction_word()
@@ -16,25 +16,58 @@
 namespace v68k
 {
 	
+	struct instruction;
+	struct cached_block;
+	
+	class block_cache;
+	
 	class emulator : public processor_state
 	{
 		private:
+			const instruction* const its_decode_table;
+			
 			unsigned long its_instruction_counter;
 			
+			uint32_t its_fall_through;  // address following the last fetch
+			
 			void double_bus_fault()  { condition = halted; }
 			
 			uint32_t bus_error    ()  { condition = halted;  return 0; }
 			uint32_t address_error()  { condition = halted;  return 0; }
+			
+			enum execution_result
+			{
+				execution_restart   = -1,  // breakpoint acknowledged; decode again
+				execution_failed    =  0,  // processor is no longer running
+				execution_diverted  =  1,  // exception taken
+				execution_completed =  2   // next opcode not yet fetched
+			};
+			
+			execution_result execute( const instruction& decoded );
+			
+			bool record_block( cached_block& block, unsigned long n_max );
+			bool replay_block( const cached_block& block, unsigned long n_max );
 		
 		public:
 			emulator( processor_model model, const memory& mem, bkpt_handler bkpt = 0 );  // NULL
 			
 			unsigned long instruction_count() const  { return its_instruction_counter; }
 			
+			void set_instruction_count( unsigned long n )  { its_instruction_counter = n; }
+			
 			void reset();
 			
 			bool step();
 			
+			/*
+				step_block() runs up to n_max instructions (at least one) as a
+				single dispatch, using and maintaining the given block cache.
+				The instruction count and all architectural state are exactly
+				as if step() had been called the same number of times.
+			*/
+			
+			bool step_block( block_cache& cache, unsigned long n_max );
+			
 			void prefetch_instruction_word();
 			
 			bool take_exception( uint16_t  format,
@@ -288,6 +288,8 @@ namespace v68k
 	{
 		uint16_t cc = s.opcode >> 8 & 0x0F;
 		
+		s.materialize_CCR();
+		
 		int32_t flag = int32_t() - test_conditional( cc, s.sr.nzvc );
 		
 		pb.result = flag;
@@ -425,6 +427,8 @@ namespace v68k
 	
 	op_result add_X_to_first( processor_state& s, op_params& pb )
 	{
+		s.materialize_CCR();
+		
 		pb.first += s.sr.x & 0x1;
 		
 		return Ok;
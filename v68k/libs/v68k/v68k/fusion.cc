@@ -0,0 +1,398 @@
+/*
+	fusion.cc
+	---------
+*/
+
+#include "v68k/fusion.hh"
+
+// v68k
+#include "v68k/conditional.hh"
+#include "v68k/instruction.hh"
+#include "v68k/macros.hh"
+#include "v68k/state.hh"
+
+
+#pragma exceptions off
+
+
+namespace v68k
+{
+	
+	enum
+	{
+		ADD_CCR_updater = (ADD_CCR_update & CCR_update_mask) >> CCR_update_shift,
+		SUB_CCR_updater = (SUB_CCR_update & CCR_update_mask) >> CCR_update_shift,
+		TST_CCR_updater = (TST_CCR_update & CCR_update_mask) >> CCR_update_shift,
+	};
+	
+	static inline
+	uint16_t word_at( const uint8_t* code )
+	{
+		return code[ 0 ] << 8 | code[ 1 ];
+	}
+	
+	static inline
+	bool is_short_Bcc( uint16_t opcode )
+	{
+		// Bcc.S with an 8-bit displacement, but not BRA or BSR
+		
+		const bool short_branch = uint8_t( opcode + 1 ) > 1;  // not 0 or -1
+		
+		return (opcode & 0xF000) == 0x6000  &&  (opcode & 0x0E00)  &&  short_branch;
+	}
+	
+	static inline
+	void defer_TST( processor_state& s, uint16_t n, uint32_t data, op_size_t size )
+	{
+		op_params pb;
+		
+		pb.size   = size;
+		pb.target = n;
+		pb.result = data;
+		
+		s.defer_CCR_update( TST_CCR_updater, pb, false );
+	}
+	
+	static
+	bool fused_TST_Bcc( processor_state& s, const uint8_t* code )
+	{
+		// TST.*  Dn
+		// Bcc.S  label
+		
+		const uint16_t   n    = code[ 1 ] & 0x7;
+		const op_size_t  size = op_size_t( (code[ 1 ] >> 6) + 1 );
+		
+		const uint16_t  cc   = code[ 2 ] & 0xF;
+		const int8_t    disp = code[ 3 ];
+		
+		const int32_t data = sign_extend( s.d( n ), size );
+		
+		defer_TST( s, n, data, size );
+		
+		// TST clears V and C, so N and Z decide the branch.
+		
+		const uint16_t nzvc = (data < 0) << 3 | (data == 0) << 2;
+		
+		s.pc() += 4;
+		
+		if ( test_conditional( cc, nzvc ) )
+		{
+			s.pc() += disp;
+		}
+		
+		return true;
+	}
+	
+	static
+	bool fused_ADDQ_Bcc( processor_state& s, const uint8_t* code )
+	{
+		// ADDQ.*  #data,Dn  or  SUBQ.*  #data,Dn
+		// Bcc.S   label
+		
+		const uint16_t   n    = code[ 1 ] & 0x7;
+		const op_size_t  size = op_size_t( (code[ 1 ] >> 6) + 1 );
+		
+		const bool subtract = code[ 0 ] & 0x1;
+		
+		const uint16_t  cc   = code[ 2 ] & 0xF;
+		const int8_t    disp = code[ 3 ];
+		
+		op_params pb;
+		
+		pb.size   = size;
+		pb.target = n;
+		pb.first  = ((code[ 0 ] >> 1) - 1 & 0x7) + 1;
+		pb.second = s.d( n );
+		pb.result = subtract ? pb.second - pb.first
+		                     : pb.second + pb.first;
+		
+		s.d( n ) = update( s.d( n ), pb.result, size );
+		
+		s.defer_CCR_update( subtract ? SUB_CCR_updater : ADD_CCR_updater, pb, true );
+		
+		s.materialize_CCR();
+		
+		s.pc() += 4;
+		
+		if ( test_conditional( cc, s.sr.nzvc ) )
+		{
+			s.pc() += disp;
+		}
+		
+		return true;
+	}
+	
+	static inline
+	void MOVEQ( processor_state& s, const uint8_t* code )
+	{
+		const uint16_t n    = code[ 0 ] >> 1 & 0x7;
+		const int32_t  data = int8_t( code[ 1 ] );
+		
+		s.d( n ) = data;
+		
+		defer_TST( s, n, data, long_sized );
+	}
+	
+	static
+	bool fused_MOVEQ_ADD( processor_state& s, const uint8_t* code )
+	{
+		// MOVEQ  #data,Dn
+		// ADD.L  Dy,Dx
+		
+		MOVEQ( s, code );
+		
+		const uint16_t x = code[ 2 ] >> 1 & 0x7;
+		const uint16_t y = code[ 3 ]      & 0x7;
+		
+		op_params pb;
+		
+		pb.size   = long_sized;
+		pb.target = x;
+		pb.first  = s.d( y );
+		pb.second = s.d( x );
+		pb.result = pb.second + pb.first;
+		
+		s.d( x ) = pb.result;
+		
+		s.defer_CCR_update( ADD_CCR_updater, pb, true );
+		
+		s.pc() += 4;
+		
+		return true;
+	}
+	
+	static
+	bool fused_MOVEQ_SUB( processor_state& s, const uint8_t* code )
+	{
+		// MOVEQ  #data,Dn
+		// SUB.L  Dy,Dx
+		
+		MOVEQ( s, code );
+		
+		const uint16_t x = code[ 2 ] >> 1 & 0x7;
+		const uint16_t y = code[ 3 ]      & 0x7;
+		
+		op_params pb;
+		
+		pb.size   = long_sized;
+		pb.target = x;
+		pb.first  = s.d( y );
+		pb.second = s.d( x );
+		pb.result = pb.second - pb.first;
+		
+		s.d( x ) = pb.result;
+		
+		s.defer_CCR_update( SUB_CCR_updater, pb, true );
+		
+		s.pc() += 4;
+		
+		return true;
+	}
+	
+	static
+	bool fused_MOVE_RTS( processor_state& s, const uint8_t* code )
+	{
+		// MOVE.L   (A7)+,Dn  or  MOVEA.L  (A7)+,An
+		// RTS
+		
+		uint32_t& sp = s.a(7);
+		
+		if ( s.badly_aligned_data( sp ) )
+		{
+			return false;
+		}
+		
+		const function_code_t fc = s.data_space();
+		
+		uint32_t data;
+		uint32_t return_address;
+		
+		if ( !s.mem.get_long( sp,     data,           fc )  ||
+		     !s.mem.get_long( sp + 4, return_address, fc ) )
+		{
+			return false;
+		}
+		
+		const uint16_t n = code[ 0 ] >> 1 & 0x7;
+		
+		if ( code[ 1 ] & 0x40 )
+		{
+			s.a( n ) = data;
+		}
+		else
+		{
+			s.d( n ) = data;
+			
+			defer_TST( s, n, data, long_sized );
+		}
+		
+		sp += 8;
+		
+		s.pc() = return_address;
+		
+		return true;
+	}
+	
+	static
+	bool fused_UNLK_RTS( processor_state& s, const uint8_t* code )
+	{
+		// UNLK  An
+		// RTS
+		
+		uint32_t& An = s.a( code[ 1 ] & 0x7 );
+		
+		const uint32_t frame = An;
+		
+		if ( s.badly_aligned_data( frame ) )
+		{
+			return false;
+		}
+		
+		const function_code_t fc = s.data_space();
+		
+		uint32_t saved_An;
+		uint32_t return_address;
+		
+		if ( !s.mem.get_long( frame,     saved_An,       fc )  ||
+		     !s.mem.get_long( frame + 4, return_address, fc ) )
+		{
+			return false;
+		}
+		
+		An = saved_An;
+		
+		s.a(7) = frame + 8;
+		
+		s.pc() = return_address;
+		
+		return true;
+	}
+	
+	static
+	bool fused_LINK_MOVEM( processor_state& s, const uint8_t* code )
+	{
+		// LINK     An,#disp
+		// MOVEM.L  <register list>,-(A7)
+		
+		const uint32_t pc = s.pc();
+		const uint32_t sp = s.a(7);
+		
+		const int32_t  disp = int16_t( word_at( code + 2 ) );
+		const uint16_t mask =          word_at( code + 6 );
+		
+		const uint32_t frame = sp - 4;
+		const uint32_t top   = frame + disp;
+		
+		if ( s.badly_aligned_data( sp )  ||  s.badly_aligned_data( top ) )
+		{
+			return false;
+		}
+		
+		// Stores by LINK into the MOVEM instruction would be noticed too late.
+		
+		if ( frame < pc + 8  &&  sp > pc + 4 )
+		{
+			return false;
+		}
+		
+		uint32_t n_bytes = 0;
+		
+		for ( uint16_t bits = mask;  bits != 0;  bits >>= 1 )
+		{
+			n_bytes += (bits & 0x1) * sizeof (uint32_t);
+		}
+		
+		const function_code_t fc = s.data_space();
+		
+		if ( !s.mem.translate( frame, 4, fc, mem_write ) )
+		{
+			return false;
+		}
+		
+		if ( n_bytes  &&  !s.mem.translate( top - n_bytes, n_bytes, fc, mem_write ) )
+		{
+			return false;
+		}
+		
+		// Neither instruction can fault now.
+		
+		op_params pb;
+		
+		pb.target = code[ 1 ] & 0x7;
+		pb.first  = disp;
+		
+		microcode_LINK( s, pb );
+		
+		pb.size    = long_sized;
+		pb.target  = 8 + 7;
+		pb.first   = mask;
+		pb.address = s.a(7) -= 4;
+		
+		microcode_MOVEM_to( s, pb );
+		
+		s.pc() = pc + 8;
+		
+		return true;
+	}
+	
+	fused_microcode fuse( uint16_t first, uint16_t second )
+	{
+		const uint16_t RTS     = 0x4E75;
+		const uint16_t MOVEM_L = 0x48E7;  // MOVEM.L <list>,-(A7)
+		
+		if ( (first & 0xFF38) == 0x4A00  &&  (first & 0x00C0) != 0x00C0 )
+		{
+			// TST.* Dn (but not TAS)
+			
+			if ( is_short_Bcc( second ) )
+			{
+				return &fused_TST_Bcc;
+			}
+		}
+		else if ( (first & 0xF038) == 0x5000  &&  (first & 0x00C0) != 0x00C0 )
+		{
+			// ADDQ.* or SUBQ.* to Dn
+			
+			if ( is_short_Bcc( second ) )
+			{
+				return &fused_ADDQ_Bcc;
+			}
+		}
+		else if ( (first & 0xF100) == 0x7000 )
+		{
+			switch ( second & 0xF1F8 )
+			{
+				case 0xD080:  return &fused_MOVEQ_ADD;
+				case 0x9080:  return &fused_MOVEQ_SUB;
+				
+				default:
+					break;
+			}
+		}
+		else if ( second == RTS )
+		{
+			const bool MOVE_L_pop  = (first & 0xF1FF) == 0x201F;
+			const bool MOVEA_L_pop = (first & 0xF1FF) == 0x205F  &&  first != 0x2E5F;
+			
+			if ( MOVE_L_pop  ||  MOVEA_L_pop )
+			{
+				return &fused_MOVE_RTS;
+			}
+			
+			if ( (first & 0xFFF8) == 0x4E58  &&  first != 0x4E5F )
+			{
+				return &fused_UNLK_RTS;
+			}
+		}
+		else if ( second == MOVEM_L )
+		{
+			if ( (first & 0xFFF8) == 0x4E50  &&  first != 0x4E57 )
+			{
+				return &fused_LINK_MOVEM;
+			}
+		}
+		
+		return 0;  // NULL
+	}
+	
+}
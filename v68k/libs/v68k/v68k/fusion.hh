@@ -0,0 +1,44 @@
+/*
+	fusion.hh
+	---------
+*/
+
+#ifndef V68K_FUSION_HH
+#define V68K_FUSION_HH
+
+// C99
+#include <stdint.h>
+
+
+namespace v68k
+{
+	
+	struct processor_state;
+	
+	/*
+		A fused microcode performs two adjacent instructions at once, with
+		the same architectural results as executing them in turn.  It's
+		called with the PC at the first instruction and `code` pointing to
+		its (big-endian) opcode, followed by the rest of the pair's code.
+		
+		A fused microcode first checks everything that could make either
+		instruction fault.  If anything might, it returns false without
+		changing any state, and the caller executes the pair the slow way.
+		Otherwise it returns true with the PC advanced past the pair (or
+		at the branch target).  The caller is responsible for counting two
+		instructions, and for not fusing while tracing.
+	*/
+	
+	typedef bool (*fused_microcode)( processor_state& s, const uint8_t* code );
+	
+	/*
+		Returns a fused microcode for the given opcode pair, or NULL if the
+		pair isn't fused.  Only the opcodes are examined, so a pair that
+		fuses does so regardless of its extension words.
+	*/
+	
+	fused_microcode fuse( uint16_t first, uint16_t second );
+	
+}
+
+#endif
@@ -5,8 +5,12 @@
 
 #include "v68k/memory.hh"
 
+// Standard C
+#include <string.h>
+
 // v68k
 #include "v68k/endian.hh"
+#include "v68k/tlb.hh"
 
 
 #pragma exceptions off
@@ -98,6 +102,41 @@ namespace v68k
 	}
 	
 	
+	uint8_t* memory::translate( addr_t a, uint32_t n, fc_t fc, mem_t mem ) const
+	{
+		if ( its_tlb )
+		{
+			if ( uint8_t* p = its_tlb->lookup( a, n, fc, mem ) )
+			{
+				return p;
+			}
+		}
+		
+		return its_translate( its_context, a, n, fc, mem );
+	}
+	
+	uint8_t* memory::probe( addr_t a, uint32_t n, fc_t fc, mem_t mem ) const
+	{
+		if ( its_tlb )
+		{
+			if ( uint8_t* p = its_tlb->lookup( a, n, fc, mem ) )
+			{
+				return p;
+			}
+		}
+		
+		return its_probe ? its_probe( its_context, a, n, fc, mem ) : 0;  // NULL
+	}
+	
+	void memory::flush_translations() const
+	{
+		if ( its_tlb )
+		{
+			its_tlb->flush();
+		}
+	}
+	
+	
 	bool memory::get_byte( uint32_t addr, uint8_t& x, function_code_t fc ) const
 	{
 		if ( const uint8_t* p = translate( addr, sizeof (uint8_t), fc, mem_read ) )
@@ -143,6 +182,8 @@ namespace v68k
 			
 			translate( addr, sizeof (uint8_t), fc, mem_update );
 			
+			note_write( addr, sizeof (uint8_t) );
+			
 			return true;
 		}
 		
@@ -157,6 +198,8 @@ namespace v68k
 			
 			translate( addr, sizeof (uint16_t), fc, mem_update );
 			
+			note_write( addr, sizeof (uint16_t) );
+			
 			return true;
 		}
 		
@@ -171,6 +214,8 @@ namespace v68k
 			
 			translate( addr, sizeof (uint32_t), fc, mem_update );
 			
+			note_write( addr, sizeof (uint32_t) );
+			
 			return true;
 		}
 		
@@ -190,4 +235,129 @@ namespace v68k
 		return false;
 	}
 	
+	
+	uint8_t* memory::translate_run( addr_t addr, uint32_t& n, fc_t fc, mem_t mem ) const
+	{
+		const uint32_t n_in_page = tlb_page_size - (addr & tlb_page_mask);
+		
+		if ( n > n_in_page )
+		{
+			if ( uint8_t* p = probe( addr, n, fc, mem ) )
+			{
+				return p;
+			}
+			
+			n = n_in_page;
+		}
+		
+		return translate( addr, n, fc, mem );
+	}
+	
+	bool memory::get_block( addr_t addr, void* buffer, uint32_t n, fc_t fc ) const
+	{
+		uint8_t* q = (uint8_t*) buffer;
+		
+		while ( n > 0 )
+		{
+			uint32_t run = n;
+			
+			const uint8_t* p = translate_run( addr, run, fc, mem_read );
+			
+			if ( p == 0 )  // NULL
+			{
+				return false;
+			}
+			
+			memcpy( q, p, run );
+			
+			addr += run;
+			q    += run;
+			n    -= run;
+		}
+		
+		return true;
+	}
+	
+	bool memory::put_block( addr_t addr, const void* buffer, uint32_t n, fc_t fc ) const
+	{
+		const uint8_t* p = (const uint8_t*) buffer;
+		
+		while ( n > 0 )
+		{
+			uint32_t run = n;
+			
+			uint8_t* q = translate_run( addr, run, fc, mem_write );
+			
+			if ( q == 0 )  // NULL
+			{
+				return false;
+			}
+			
+			memcpy( q, p, run );
+			
+			translate( addr, run, fc, mem_update );
+			
+			note_write( addr, run );
+			
+			addr += run;
+			p    += run;
+			n    -= run;
+		}
+		
+		return true;
+	}
+	
+	bool memory::copy_block( addr_t src, addr_t dst, uint32_t n, fc_t fc ) const
+	{
+		if ( n == 0 )
+		{
+			return true;
+		}
+		
+		if ( const uint8_t* p = probe( src, n, fc, mem_read ) )
+		{
+			if ( uint8_t* q = probe( dst, n, fc, mem_write ) )
+			{
+				memmove( q, p, n );
+				
+				translate( dst, n, fc, mem_update );
+				
+				note_write( dst, n );
+				
+				return true;
+			}
+		}
+		
+		/*
+			One side isn't contiguous, so bounce a page at a time.  Copy
+			from the end if dst overlaps the tail of src, as memmove() would.
+		*/
+		
+		uint8_t buffer[ tlb_page_size ];
+		
+		const bool backward = dst - src < n;
+		
+		while ( n > 0 )
+		{
+			const uint32_t chunk  = n < sizeof buffer ? n : sizeof buffer;
+			const uint32_t offset = backward ? n - chunk : 0;
+			
+			if ( !get_block( src + offset, buffer, chunk, fc )  ||
+			     !put_block( dst + offset, buffer, chunk, fc ) )
+			{
+				return false;
+			}
+			
+			if ( !backward )
+			{
+				src += chunk;
+				dst += chunk;
+			}
+			
+			n -= chunk;
+		}
+		
+		return true;
+	}
+	
 }
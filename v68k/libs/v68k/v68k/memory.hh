@@ -37,23 +37,90 @@ namespace v68k
 	typedef function_code_t  fc_t;
 	typedef memory_access_t  mem_t;
 	
-	typedef uint8_t* (*translate_f)( addr_t a, uint32_t n, fc_t fc, mem_t mem );
+	/*
+		A translate function gets the context its memory was created with,
+		so that one host can run several machines, each with its own.
+	*/
+	
+	typedef uint8_t* (*translate_f)( void*     context,
+	                                 addr_t    a,
+	                                 uint32_t  n,
+	                                 fc_t      fc,
+	                                 mem_t     mem );
+	
+	class tlb;
 	
 	class memory
 	{
 		private:
 			translate_f its_translate;
+			translate_f its_probe;
+			
+			void* const its_context;
+			
+			tlb* const its_tlb;
+			
+			mutable addr_t    its_watched_addr;
+			mutable uint32_t  its_watched_size;
+			mutable bool      its_watch_was_hit;
+			
+			uint8_t* probe( addr_t a, uint32_t n, fc_t fc, mem_t mem ) const;
+			
+			void note_write( addr_t addr, uint32_t n ) const
+			{
+				// True iff [addr, addr + n) overlaps the watched range
+				
+				if ( addr + n - 1 - its_watched_addr < its_watched_size + n - 1 )
+				{
+					its_watch_was_hit = true;
+				}
+			}
 		
 		public:
-			memory( translate_f f ) : its_translate( f )
+			/*
+				probe, if given, translates as f does, but quietly:  It's
+				used to try a whole block before falling back to a page at
+				a time, so its failures are expected.
+			*/
+			
+			memory( translate_f f, void* context = 0, tlb* t = 0, translate_f probe = 0 )  // NULL
+			:
+				its_translate( f ),
+				its_probe( probe ),
+				its_context( context ),
+				its_tlb( t ),
+				its_watched_addr(),
+				its_watched_size(),
+				its_watch_was_hit()
 			{
 			}
 			
-			uint8_t* translate( addr_t a, uint32_t n, fc_t fc, mem_t mem ) const
+			/*
+				While a range is watched, any put_byte(), put_word() or
+				put_long() overlapping it sets watch_hit().  Host writes
+				that go through translate() directly aren't noticed.
+			*/
+			
+			void watch( addr_t addr, uint32_t size ) const
 			{
-				return its_translate( a, n, fc, mem );
+				its_watched_addr  = addr;
+				its_watched_size  = size;
+				its_watch_was_hit = false;
 			}
 			
+			bool watch_hit() const  { return its_watch_was_hit; }
+			
+			void* context() const  { return its_context; }
+			
+			uint8_t* translate( addr_t a, uint32_t n, fc_t fc, mem_t mem ) const;
+			
+			/*
+				Call this after changing any mapping that the translate
+				function might have entered into the TLB.
+			*/
+			
+			void flush_translations() const;
+			
 			bool get_byte( addr_t addr, uint8_t & x, fc_t fc ) const;
 			bool get_word( addr_t addr, uint16_t& x, fc_t fc ) const;
 			bool get_long( addr_t addr, uint32_t& x, fc_t fc ) const;
@@ -63,6 +130,25 @@ namespace v68k
 			bool put_long( addr_t addr, uint32_t x, fc_t fc ) const;
 			
 			bool get_instruction_word( addr_t addr, uint16_t& x, fc_t fc ) const;
+			
+			/*
+				Translate as much of [addr, addr + n) as one run as possible:
+				all of it if the translate function allows, else as far as
+				the end of addr's page.  n is updated to the run's length.
+			*/
+			
+			uint8_t* translate_run( addr_t addr, uint32_t& n, fc_t fc, mem_t mem ) const;
+			
+			/*
+				Block transfers translate once per run rather than once per
+				element.  If one fails partway, the runs before the one that
+				faulted have been transferred.
+			*/
+			
+			bool get_block( addr_t addr, void* buffer, uint32_t n, fc_t fc ) const;
+			bool put_block( addr_t addr, const void* buffer, uint32_t n, fc_t fc ) const;
+			
+			bool copy_block( addr_t src, addr_t dst, uint32_t n, fc_t fc ) const;
 	};
 	
 }
@@ -260,6 +260,8 @@ namespace v68k
 	
 	op_result microcode_CHK( processor_state& s, op_params& pb )
 	{
+		s.materialize_CCR();
+		
 		const int32_t bound = pb.first;
 		const int32_t value = pb.second;
 		
@@ -377,6 +379,8 @@ namespace v68k
 	
 	op_result microcode_TAS( processor_state& s, op_params& pb )
 	{
+		s.materialize_CCR();
+		
 		const int32_t data = sign_extend( pb.second, byte_sized );
 		
 		s.sr.nzvc = N( data <  0 )
@@ -389,6 +393,69 @@ namespace v68k
 		return Ok;
 	}
 	
+	static inline
+	int gather_MOVEM_registers( const processor_state& s, uint16_t mask, bool reversed, uint32_t* data )
+	{
+		int n = 0;
+		
+		for ( int r = 0;  mask != 0;  ++r, mask >>= 1 )
+		{
+			if ( mask & 0x1 )
+			{
+				data[ n++ ] = s.regs[ reversed ? 15 - r : r ];
+			}
+		}
+		
+		return n;
+	}
+	
+	static
+	int put_MOVEM_block( processor_state& s, const op_params& pb )
+	{
+		/*
+			Store the whole register list with one put_block():  in memory,
+			the registers are in ascending order for either addressing mode.
+			Returns the number of registers stored, or zero on a fault.
+		*/
+		
+		const bool predecrement   = pb.target;
+		const bool longword_sized = pb.size == long_sized;
+		
+		const uint32_t size = 2 << longword_sized;
+		
+		uint32_t data[ 16 ];
+		
+		const int n = gather_MOVEM_registers( s, pb.first, predecrement, data );
+		
+		if ( n == 0 )
+		{
+			return 0;
+		}
+		
+		uint8_t buffer[ sizeof data ];
+		
+		uint8_t* p = buffer;
+		
+		for ( int i = 0;  i < n;  ++i )
+		{
+			const uint32_t x = data[ predecrement ? n - 1 - i : i ];
+			
+			if ( longword_sized )
+			{
+				*p++ = x >> 24;
+				*p++ = x >> 16;
+			}
+			
+			*p++ = x >> 8;
+			*p++ = x;
+		}
+		
+		const uint32_t low = predecrement ? pb.address - (n - 1) * size
+		                                  : pb.address;
+		
+		return s.mem.put_block( low, buffer, n * size, s.data_space() ) ? n : 0;
+	}
+	
 	op_result microcode_MOVEM_to( processor_state& s, op_params& pb )
 	{
 		uint16_t mask = pb.first;
@@ -405,6 +472,15 @@ namespace v68k
 			increment = -increment;
 		}
 		
+		if ( const int n = put_MOVEM_block( s, pb ) )
+		{
+			addr += n * increment;
+			
+			mask = 0;
+		}
+		
+		// If the block store faulted, redo it an element at a time.
+		
 		for ( int r = 0;  mask != 0;  ++r, mask >>= 1 )
 		{
 			if ( mask & 0x1 )
@@ -431,6 +507,50 @@ namespace v68k
 		return Ok;
 	}
 	
+	static
+	int get_MOVEM_block( processor_state& s, const op_params& pb )
+	{
+		/*
+			Load the whole register list with one get_block().  Returns the
+			number of registers loaded, or zero on a fault.
+		*/
+		
+		const bool longword_sized = pb.size == long_sized;
+		
+		const uint32_t size = 2 << longword_sized;
+		
+		int n = 0;
+		
+		for ( uint16_t bits = pb.first;  bits != 0;  bits >>= 1 )
+		{
+			n += bits & 0x1;
+		}
+		
+		uint8_t buffer[ 16 * sizeof (uint32_t) ];
+		
+		if ( n == 0  ||  !s.mem.get_block( pb.address, buffer, n * size, s.data_space() ) )
+		{
+			return 0;
+		}
+		
+		const uint8_t* p = buffer;
+		
+		uint16_t mask = pb.first;
+		
+		for ( int r = 0;  mask != 0;  ++r, mask >>= 1 )
+		{
+			if ( mask & 0x1 )
+			{
+				s.regs[ r ] = longword_sized ? p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3]
+				                             : int32_t( int16_t( p[0] << 8 | p[1] ) );
+				
+				p += size;
+			}
+		}
+		
+		return n;
+	}
+	
 	op_result microcode_MOVEM_from( processor_state& s, op_params& pb )
 	{
 		uint16_t mask = pb.first;
@@ -442,6 +562,15 @@ namespace v68k
 		
 		const int32_t increment = 2 << longword_sized;
 		
+		if ( const int n = get_MOVEM_block( s, pb ) )
+		{
+			addr += n * increment;
+			
+			mask = 0;
+		}
+		
+		// If the block load faulted, redo it an element at a time.
+		
 		for ( int r = 0;  mask != 0;  ++r, mask >>= 1 )
 		{
 			if ( mask & 0x1 )
@@ -1088,6 +1217,8 @@ namespace v68k
 	
 	op_result microcode_ASR( processor_state& s, op_params& pb )
 	{
+		s.materialize_CCR();
+		
 		int32_t data = pb.second;
 		
 		const uint16_t count = pb.first;
@@ -1124,6 +1255,8 @@ namespace v68k
 	
 	op_result microcode_ASL( processor_state& s, op_params& pb )
 	{
+		s.materialize_CCR();
+		
 		const uint16_t count = pb.first;
 		
 		int32_t data = pb.second;
@@ -1180,6 +1313,8 @@ namespace v68k
 	
 	op_result microcode_LSR( processor_state& s, op_params& pb )
 	{
+		s.materialize_CCR();
+		
 		const uint16_t count = pb.first;
 		
 		int32_t data = pb.second;
@@ -1220,6 +1355,8 @@ namespace v68k
 	
 	op_result microcode_LSL( processor_state& s, op_params& pb )
 	{
+		s.materialize_CCR();
+		
 		const uint16_t count = pb.first;
 		
 		int32_t data = pb.second;
@@ -1260,6 +1397,8 @@ namespace v68k
 	
 	op_result microcode_ROXR( processor_state& s, op_params& pb )
 	{
+		s.materialize_CCR();
+		
 		const uint32_t count = pb.first;
 		
 		int32_t data = pb.second;
@@ -1297,6 +1436,8 @@ namespace v68k
 	
 	op_result microcode_ROXL( processor_state& s, op_params& pb )
 	{
+		s.materialize_CCR();
+		
 		const uint32_t count = pb.first;
 		
 		int32_t data = pb.second;
@@ -1341,6 +1482,8 @@ namespace v68k
 	
 	op_result microcode_ROR( processor_state& s, op_params& pb )
 	{
+		s.materialize_CCR();
+		
 		const uint32_t count = pb.first;
 		
 		int32_t data = pb.second;
@@ -1380,6 +1523,8 @@ namespace v68k
 	
 	op_result microcode_ROL( processor_state& s, op_params& pb )
 	{
+		s.materialize_CCR();
+		
 		const uint32_t count = pb.first;
 		
 		int32_t data = pb.second;
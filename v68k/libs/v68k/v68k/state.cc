@@ -7,6 +7,7 @@
 
 // v68k
 #include "v68k/endian.hh"
+#include "v68k/update_CCR.hh"
 
 
 #pragma exceptions off
@@ -29,6 +30,8 @@ namespace v68k
 		{
 			*p = 0;
 		}
+		
+		discard_pending_CCR_updates();
 	}
 	
 	op_result processor_state::read_byte( uint32_t addr, uint32_t& data )
@@ -71,8 +74,38 @@ namespace v68k
 		return Ok;
 	}
 	
+	void processor_state::perform_pending_CCR_updates() const
+	{
+		/*
+			Updaters write only sr.x and sr.nzvc, which are lazily evaluated
+			and therefore logically unchanged by this, hence the const_cast.
+		*/
+		
+		processor_state& s = const_cast< processor_state& >( *this );
+		
+		if ( pending_X.updater )
+		{
+			// This is always followed by pending_NZVC, which overwrites NZVC.
+			
+			the_CCR_updaters[ pending_X.updater - 1 ]( s, pending_X.pb );
+			
+			s.sr.x = sr.nzvc & 0x1;
+		}
+		
+		the_CCR_updaters[ pending_NZVC.updater - 1 ]( s, pending_NZVC.pb );
+		
+		if ( X_follows_NZVC )
+		{
+			s.sr.x = sr.nzvc & 0x1;
+		}
+		
+		s.discard_pending_CCR_updates();
+	}
+	
 	uint16_t processor_state::get_CCR() const
 	{
+		materialize_CCR();
+		
 		const uint16_t ccr = sr.   x <<  4
 		                   | sr.nzvc <<  0;
 		
@@ -81,6 +114,8 @@ namespace v68k
 	
 	uint16_t processor_state::get_SR() const
 	{
+		materialize_CCR();
+		
 		const uint16_t result = sr.ttsm << 12
 		                      | sr. iii <<  8
 		                      | sr.   x <<  4
@@ -93,6 +128,8 @@ namespace v68k
 	{
 		// ...X NZVC  (all processors)
 		
+		discard_pending_CCR_updates();
+		
 		sr.   x = new_ccr >>  4 & 0x1;
 		sr.nzvc = new_ccr >>  0 & 0xF;
 	}
@@ -108,6 +145,8 @@ namespace v68k
 		
 		new_sr &= sr_mask;
 		
+		discard_pending_CCR_updates();
+		
 		save_sp();
 		
 		sr.ttsm = new_sr >> 12;
@@ -44,12 +44,35 @@ namespace v68k
 	
 	typedef op_result (*bkpt_handler)(processor_state& s, int vector);
 	
+	/*
+		A CCR update that has been recorded but not yet performed:  an index
+		into the_CCR_updaters (plus one, so zero means none) and the operands
+		and result of the instruction that requested it.
+	*/
+	
+	struct pending_CCR_update
+	{
+		uint8_t    updater;
+		op_params  pb;
+	};
+	
 	struct processor_state
 	{
 		uint32_t regs[ n_registers ];
 		
+		/*
+			The X and NZVC bits in sr are lazily evaluated.  Any code outside
+			of get_CCR(), get_SR(), set_CCR() and set_SR() that reads or writes
+			sr.x or sr.nzvc must call materialize_CCR() first.
+		*/
+		
 		status_register sr;
 		
+		mutable pending_CCR_update pending_NZVC;
+		mutable pending_CCR_update pending_X;  // X from the C of an older op
+		
+		mutable bool X_follows_NZVC;  // X is C from pending_NZVC
+		
 		const memory& mem;
 		
 		const bkpt_handler bkpt;
@@ -130,6 +153,45 @@ namespace v68k
 			return result;
 		}
 		
+		void defer_CCR_update( int updater, const op_params& pb, bool sets_X )
+		{
+			if ( sets_X )
+			{
+				X_follows_NZVC = true;
+				
+				pending_X.updater = 0;
+			}
+			else if ( X_follows_NZVC )
+			{
+				// The previous op's C is still needed for X.
+				
+				pending_X = pending_NZVC;
+				
+				X_follows_NZVC = false;
+			}
+			
+			pending_NZVC.updater = updater + 1;
+			pending_NZVC.pb      = pb;
+		}
+		
+		void perform_pending_CCR_updates() const;
+		
+		void materialize_CCR() const
+		{
+			if ( pending_NZVC.updater )
+			{
+				perform_pending_CCR_updates();
+			}
+		}
+		
+		void discard_pending_CCR_updates()
+		{
+			pending_NZVC.updater = 0;
+			pending_X   .updater = 0;
+			
+			X_follows_NZVC = false;
+		}
+		
 		uint16_t get_CCR() const;
 		
 		uint16_t get_SR() const;
@@ -0,0 +1,28 @@
+/*
+	tlb.cc
+	------
+*/
+
+#include "v68k/tlb.hh"
+
+
+#pragma exceptions off
+
+
+namespace v68k
+{
+	
+	void tlb::flush()
+	{
+		const tlb_entry empty = { uint32_t( -1 ), 0 };  // matches no tag
+		
+		tlb_entry* p   = its_entries;
+		tlb_entry* end = its_entries + sizeof its_entries / sizeof *its_entries;
+		
+		while ( p < end )
+		{
+			*p++ = empty;
+		}
+	}
+	
+}
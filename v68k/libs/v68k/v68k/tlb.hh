@@ -0,0 +1,108 @@
+/*
+	tlb.hh
+	------
+*/
+
+#ifndef V68K_TLB_HH
+#define V68K_TLB_HH
+
+// C99
+#include <stdint.h>
+
+// v68k
+#include "v68k/memory.hh"
+
+
+namespace v68k
+{
+	
+	/*
+		A direct-mapped software TLB, consulted by memory::translate() before
+		calling the translate function.  Entries map a page, function code
+		and access type to the host address of the page.
+		
+		The TLB never fills itself.  A translate function inserts a page only
+		when every address in it translates to contiguous host memory (for
+		that function code and access type) with no side effects -- including
+		for mem_update, which is otherwise a notification.  Whoever changes
+		such a mapping must flush the TLB (see memory::flush_translations()).
+	*/
+	
+	enum
+	{
+		tlb_page_size_bits = 12,
+		tlb_page_size      = 1 << tlb_page_size_bits,  // 4K
+		
+		tlb_page_mask = tlb_page_size - 1,
+		
+		n_tlb_sets = 64,  // per access type
+	};
+	
+	struct tlb_entry
+	{
+		uint32_t  tag;
+		uint8_t*  base;
+	};
+	
+	class tlb
+	{
+		private:
+			tlb_entry its_entries[ 4 * n_tlb_sets ];
+			
+			static uint32_t tag( addr_t page, fc_t fc, mem_t access )
+			{
+				return page | fc << 2 | access;
+			}
+			
+			tlb_entry& entry( addr_t addr, mem_t access )
+			{
+				const uint32_t set = addr >> tlb_page_size_bits & (n_tlb_sets - 1);
+				
+				return its_entries[ access * n_tlb_sets + set ];
+			}
+			
+			const tlb_entry& entry( addr_t addr, mem_t access ) const
+			{
+				const uint32_t set = addr >> tlb_page_size_bits & (n_tlb_sets - 1);
+				
+				return its_entries[ access * n_tlb_sets + set ];
+			}
+		
+		public:
+			tlb()  { flush(); }
+			
+			void flush();
+			
+			uint8_t* lookup( addr_t addr, uint32_t n, fc_t fc, mem_t access ) const
+			{
+				const uint32_t offset = addr & tlb_page_mask;
+				
+				const tlb_entry& e = entry( addr, access );
+				
+				if ( e.tag == tag( addr - offset, fc, access )  &&  n <= tlb_page_size - offset )
+				{
+					return e.base + offset;
+				}
+				
+				return 0;  // NULL
+			}
+			
+			/*
+				Insert the page containing addr, given the host address p
+				that addr translates to.
+			*/
+			
+			void insert( addr_t addr, fc_t fc, mem_t access, uint8_t* p )
+			{
+				const uint32_t offset = addr & tlb_page_mask;
+				
+				tlb_entry& e = entry( addr, access );
+				
+				e.tag  = tag( addr - offset, fc, access );
+				e.base = p - offset;
+			}
+	};
+	
+}
+
+#endif
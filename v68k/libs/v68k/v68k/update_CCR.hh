@@ -18,6 +18,16 @@ namespace v68k
 	
 	extern CCR_updater the_CCR_updaters[];
 	
+	/*
+		ADDX, SUBX and BTST depend on the existing CCR, so they can't be
+		deferred.  The others depend only on their op_params.
+	*/
+	
+	inline bool CCR_update_is_deferrable( int index )
+	{
+		return (0x53 >> index) & 0x1;  // ADD, SUB, TST, DIV
+	}
+	
 }
 
 #endif
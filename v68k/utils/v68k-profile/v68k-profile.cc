@@ -0,0 +1,447 @@
+/*
+	v68k-profile.cc
+	---------------
+*/
+
+// Standard C
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// recall
+#include "recall/macsbug_symbols.hh"
+
+// v68k-utils
+#include "utils/load.hh"
+#include "utils/profile_format.hh"
+
+
+#pragma exceptions off
+
+
+using namespace v68k::utils;
+
+
+enum
+{
+	n_top_opcodes   = 20,
+	n_top_PCs       = 30,
+	n_top_functions = 20,
+	
+	max_functions = 4096,
+	
+	symbol_search_range = 0x20000,  // as in recall::find_symbol_name()
+};
+
+struct entry
+{
+	uint32_t  key;
+	uint64_t  count;
+};
+
+struct section
+{
+	const uint8_t*  entries;  // profile_entry_words each
+	uint32_t        n;
+};
+
+static uint64_t n_instructions;  // completed, as counted by the emulator
+static uint64_t n_executions;    // including any that faulted
+
+static uint32_t program_address;
+
+static const uint8_t* the_code;  // padded with zeros past the end
+static uint32_t       code_size;
+
+static section the_opcodes;
+static section the_PCs;
+static section the_callouts;
+static section the_syscalls;
+
+static inline
+uint32_t read_long( const uint8_t* p )
+{
+	return p[ 0 ] << 24 | p[ 1 ] << 16 | p[ 2 ] << 8 | p[ 3 ];
+}
+
+static inline
+uint64_t read_count( const uint8_t* p )
+{
+	return uint64_t( read_long( p ) ) << 32 | read_long( p + 4 );
+}
+
+static
+entry get_entry( const section& s, uint32_t i )
+{
+	const uint8_t* p = s.entries + i * profile_entry_words * 4;
+	
+	entry result = { read_long( p ), read_count( p + 4 ) };
+	
+	return result;
+}
+
+static inline
+double percent( uint64_t count )
+{
+	return n_executions ? 100.0 * count / n_executions : 0.0;
+}
+
+static
+bool parse_profile( const uint8_t* p, uint32_t size )
+{
+	const uint8_t* end = p + size;
+	
+	if ( size < profile_header_words * 4 )
+	{
+		return false;
+	}
+	
+	if ( read_long( p ) != profile_magic  ||  read_long( p + 4 ) != profile_version )
+	{
+		return false;
+	}
+	
+	program_address = read_long ( p +  8 );
+	n_instructions  = read_count( p + 12 );
+	
+	p += profile_header_words * 4;
+	
+	while ( p < end )
+	{
+		if ( end - p < 8 )
+		{
+			return false;
+		}
+		
+		const uint32_t tag = read_long( p     );
+		const uint32_t n   = read_long( p + 4 );
+		
+		p += 8;
+		
+		if ( (end - p) / (profile_entry_words * 4) < n )
+		{
+			return false;
+		}
+		
+		const section s = { p, n };
+		
+		switch ( tag )
+		{
+			case profile_opcodes:   the_opcodes  = s;  break;
+			case profile_PCs:       the_PCs      = s;  break;
+			case profile_callouts:  the_callouts = s;  break;
+			case profile_syscalls:  the_syscalls = s;  break;
+			
+			default:
+				break;  // skip unknown sections
+		}
+		
+		p += n * profile_entry_words * 4;
+	}
+	
+	return true;
+}
+
+static
+bool load_code( const char* path )
+{
+	uint32_t size;
+	
+	void* file = load_file( path, &size );
+	
+	if ( file == NULL )
+	{
+		return false;
+	}
+	
+	uint8_t* code = (uint8_t*) calloc( 1, size + symbol_search_range );
+	
+	if ( code )
+	{
+		memcpy( code, file, size );
+		
+		the_code  = code;
+		code_size = size;
+	}
+	
+	free( file );
+	
+	return code != NULL;
+}
+
+static
+const recall::macsbug_symbol* symbol_at( uint32_t pc )
+{
+	if ( the_code == NULL  ||  pc - program_address >= code_size )
+	{
+		return NULL;
+	}
+	
+	typedef recall::return_address_68k addr_t;
+	
+	return recall::find_symbol_name( (addr_t) (the_code + (pc - program_address)) );
+}
+
+static
+void print_symbol( const recall::macsbug_symbol* symbol )
+{
+	if ( symbol )
+	{
+		const int   length = recall::get_symbol_length( symbol );
+		const char* name   = recall::get_symbol_string( symbol );
+		
+		printf( "  %.*s", length, name );
+	}
+	
+	printf( "\n" );
+}
+
+static
+void print_instruction_mix()
+{
+	static const char* const lines[] =
+	{
+		"bit ops, MOVEP, immediate",
+		"MOVE.B",
+		"MOVE.L",
+		"MOVE.W",
+		"miscellaneous",
+		"ADDQ, SUBQ, Scc, DBcc",
+		"Bcc, BRA, BSR",
+		"MOVEQ",
+		"OR, DIV, SBCD",
+		"SUB, SUBX",
+		"A-line traps",
+		"CMP, EOR",
+		"AND, MUL, ABCD, EXG",
+		"ADD, ADDX",
+		"shifts, rotates",
+		"F-line",
+	};
+	
+	uint64_t by_line[ 16 ] = { 0 };
+	
+	for ( uint32_t i = 0;  i < the_opcodes.n;  ++i )
+	{
+		const entry e = get_entry( the_opcodes, i );
+		
+		by_line[ e.key >> 12 & 0xF ] += e.count;
+	}
+	
+	printf( "\n" "Instruction mix by opcode line:\n" );
+	
+	for ( int line = 0;  line < 16;  ++line )
+	{
+		if ( by_line[ line ] )
+		{
+			const uint64_t n = by_line[ line ];
+			
+			printf( "%12llu  %5.1f%%  %X  %s\n", (unsigned long long) n,
+			                                     percent( n ),
+			                                     line,
+			                                     lines[ line ] );
+		}
+	}
+	
+	printf( "\n" "Top opcodes:\n" );
+	
+	for ( uint32_t i = 0;  i < the_opcodes.n  &&  i < n_top_opcodes;  ++i )
+	{
+		const entry e = get_entry( the_opcodes, i );
+		
+		printf( "%12llu  %5.1f%%  %.4X\n", (unsigned long long) e.count,
+		                                   percent( e.count ),
+		                                   e.key );
+	}
+}
+
+static
+void print_traps()
+{
+	bool any = false;
+	
+	for ( uint32_t i = 0;  i < the_opcodes.n;  ++i )
+	{
+		const entry e = get_entry( the_opcodes, i );
+		
+		if ( (e.key & 0xF000) == 0xA000 )
+		{
+			if ( !any )
+			{
+				printf( "\n" "A-traps:\n" );
+				
+				any = true;
+			}
+			
+			printf( "%12llu  %.4X\n", (unsigned long long) e.count, e.key );
+		}
+	}
+	
+	for ( uint32_t i = 0;  i < the_callouts.n;  ++i )
+	{
+		const entry e = get_entry( the_callouts, i );
+		
+		if ( i == 0 )
+		{
+			printf( "\n" "Callouts:\n" );
+		}
+		
+		const uint32_t address = (e.key + 1) * -2;
+		
+		printf( "%12llu  %3u  $%.8X\n", (unsigned long long) e.count, e.key, address );
+	}
+	
+	for ( uint32_t i = 0;  i < the_syscalls.n;  ++i )
+	{
+		const entry e = get_entry( the_syscalls, i );
+		
+		if ( i == 0 )
+		{
+			printf( "\n" "System calls:\n" );
+		}
+		
+		printf( "%12llu  %3u\n", (unsigned long long) e.count, e.key );
+	}
+}
+
+static
+void print_hot_PCs()
+{
+	printf( "\n" "Hot PCs:\n" );
+	
+	for ( uint32_t i = 0;  i < the_PCs.n  &&  i < n_top_PCs;  ++i )
+	{
+		const entry e = get_entry( the_PCs, i );
+		
+		printf( "%12llu  %5.1f%%  $%.8X", (unsigned long long) e.count,
+		                                  percent( e.count ),
+		                                  e.key );
+		
+		print_symbol( symbol_at( e.key ) );
+	}
+}
+
+struct function_count
+{
+	const recall::macsbug_symbol*  symbol;
+	uint64_t                       count;
+};
+
+static
+int descending_count( const void* a, const void* b )
+{
+	const uint64_t x = ((const function_count*) a)->count;
+	const uint64_t y = ((const function_count*) b)->count;
+	
+	return (x < y) - (x > y);
+}
+
+static
+void print_hot_functions()
+{
+	if ( the_code == NULL )
+	{
+		return;
+	}
+	
+	static function_count functions[ max_functions ];
+	
+	unsigned n_functions = 0;
+	
+	uint64_t other = 0;
+	
+	for ( uint32_t i = 0;  i < the_PCs.n;  ++i )
+	{
+		const entry e = get_entry( the_PCs, i );
+		
+		const recall::macsbug_symbol* symbol = symbol_at( e.key );
+		
+		unsigned j = 0;
+		
+		while ( j < n_functions  &&  functions[ j ].symbol != symbol )
+		{
+			++j;
+		}
+		
+		if ( j == n_functions )
+		{
+			if ( n_functions == max_functions )
+			{
+				other += e.count;
+				continue;
+			}
+			
+			functions[ n_functions ].symbol = symbol;
+			functions[ n_functions ].count  = 0;
+			
+			++n_functions;
+		}
+		
+		functions[ j ].count += e.count;
+	}
+	
+	qsort( functions, n_functions, sizeof (function_count), &descending_count );
+	
+	printf( "\n" "Hot functions:\n" );
+	
+	for ( unsigned i = 0;  i < n_functions  &&  i < n_top_functions;  ++i )
+	{
+		const function_count& f = functions[ i ];
+		
+		printf( "%12llu  %5.1f%%", (unsigned long long) f.count, percent( f.count ) );
+		
+		if ( f.symbol )
+		{
+			print_symbol( f.symbol );
+		}
+		else
+		{
+			printf( "  (unnamed, or outside the program)\n" );
+		}
+	}
+}
+
+int main( int argc, char** argv )
+{
+	if ( argc < 2 )
+	{
+		fprintf( stderr, "usage: v68k-profile profile [program]\n" );
+		return 2;
+	}
+	
+	uint32_t size;
+	
+	const uint8_t* profile = (const uint8_t*) load_file( argv[ 1 ], &size );
+	
+	if ( profile == NULL )
+	{
+		perror( argv[ 1 ] );
+		return 1;
+	}
+	
+	if ( !parse_profile( profile, size ) )
+	{
+		fprintf( stderr, "%s: not a valid xv68k profile\n", argv[ 1 ] );
+		return 1;
+	}
+	
+	if ( argc > 2  &&  !load_code( argv[ 2 ] ) )
+	{
+		perror( argv[ 2 ] );
+		return 1;
+	}
+	
+	for ( uint32_t i = 0;  i < the_opcodes.n;  ++i )
+	{
+		n_executions += get_entry( the_opcodes, i ).count;
+	}
+	
+	printf( "%llu instructions\n", (unsigned long long) n_instructions );
+	
+	print_instruction_mix();
+	print_traps();
+	print_hot_PCs();
+	print_hot_functions();
+	
+	return 0;
+}